@@ -0,0 +1,143 @@
+#pragma once
+#include "ReportData.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 合成记录：结构与真机记录相同(各核频率/负载+gpu、帧率、温度、多进程线程负载)，数值用固定种子的伪随机数
+// 同样的参数每次生成完全相同的数据，可以用来比较优化前后
+struct SyntheticSpec {
+    int cores = 8;
+    int threads = 100;      //所有进程的线程总数，游戏进程占六成，其余平分给系统进程
+    int processes = 3;
+    uint64_t duration_s = 600;
+    double rate_hz = 1.0;   //采样频率，各监控器相同
+    double churn = 0;       //每分钟新建(同时退出)的线程数
+    unsigned seed = 1;
+};
+
+class SyntheticReport {
+public:
+    explicit SyntheticReport(const SyntheticSpec& spec) : spec_(spec), seed_(spec.seed) {}
+
+    ReportData generate() {
+        ReportData report;
+        report.name = "com.synthetic.game";
+        report.time = "2026-01-01 00:00:00";
+
+        std::vector<uint32_t> freq_channels, load_channels;
+        for (int c = 0; c < spec_.cores; ++c) {
+            freq_channels.push_back(report.cpu_freq.channel("cpu" + std::to_string(c)));
+            load_channels.push_back(report.cpu_load.channel("cpu" + std::to_string(c)));
+        }
+        freq_channels.push_back(report.cpu_freq.channel("gpu"));
+        load_channels.push_back(report.cpu_load.channel("gpu"));
+
+        createSlots();
+
+        uint64_t interval_ms = static_cast<uint64_t>(1000.0 / spec_.rate_hz);
+        if (interval_ms == 0) interval_ms = 1;
+        uint64_t frames = spec_.duration_s * 1000 / interval_ms;
+        double births_per_frame = spec_.churn * static_cast<double>(interval_ms) / 60000.0;
+        double births = 0;
+
+        ThreadSeries& thread = report.thread;
+        std::vector<uint32_t> process_names;
+        for (const auto& process : processes_) process_names.push_back(thread.strings.intern(process.name));
+
+        for (uint64_t f = 0; f < frames; ++f) {
+            uint64_t time_ms = f * interval_ms;
+            for (size_t c = 0; c < freq_channels.size(); ++c) {
+                report.cpu_freq.add(freq_channels[c], 300000.0 + next() % 2700000);
+                if (f > 0) report.cpu_load.add(load_channels[c], next() % 10000 / 100.0);  //第一帧没有可比的上一次统计
+            }
+            report.cpu_freq.commitFrame(time_ms);
+            report.cpu_load.commitFrame(time_ms);
+            if (f > 0) report.fps.push(time_ms, 50 + next() % 1000 / 100.0);
+            report.thermal.push(time_ms, 38 + next() % 200 / 10.0);
+
+            for (births += births_per_frame; births >= 1; births -= 1) respawn(next() % slots_.size());
+
+            thread.frames.push_back({time_ms + 3, thread.processes.size()});
+            for (size_t p = 0; p < processes_.size(); ++p) {
+                thread.processes.push_back({processes_[p].pid, process_names[p], thread.threads.size()});
+                for (size_t s = processes_[p].first_slot; s < processes_[p].end_slot; ++s) {
+                    const Slot& slot = slots_[s];
+                    ThreadSeries::Thread item{};
+                    item.name = thread.strings.intern(slot.name);
+                    item.tid = slot.tid;
+                    item.load = next() % 6000 / 100.0;
+                    item.affinity = thread.strings.intern(slot.affinity);
+                    item.cgroup = thread.strings.intern(slot.cpuset);
+                    item.cpuset = item.cgroup;
+                    item.uclamp_min = 0;
+                    item.uclamp_max = 1024;
+                    thread.threads.push_back(item);
+                }
+            }
+        }
+        return report;
+    }
+
+private:
+    struct Slot {  //一个线程位置，线程退出后由新线程(新tid)顶替
+        std::string name;
+        int tid;
+        std::string affinity;
+        std::string cpuset;
+    };
+
+    struct Process {
+        int pid;
+        std::string name;
+        size_t first_slot;
+        size_t end_slot;
+    };
+
+    void createSlots() {
+        static const char* const SYSTEM_PROCESSES[] = {"system_server", "com.android.systemui", "surfaceflinger",
+                                                       "android.hardware.graphics.composer", "audioserver"};
+        int game_threads = spec_.processes > 1 ? spec_.threads * 6 / 10 : spec_.threads;
+        int others = spec_.processes > 1 ? (spec_.threads - game_threads) / (spec_.processes - 1) : 0;
+
+        for (int p = 0; p < spec_.processes; ++p) {
+            Process process;
+            process.pid = 1000 + p * 997;
+            process.name = p == 0 ? "com.synthetic.game"
+                                  : SYSTEM_PROCESSES[(p - 1) % 5] + (p > 5 ? ":" + std::to_string(p) : std::string());
+            process.first_slot = slots_.size();
+            int count = p == 0 ? game_threads : others;
+            for (int k = 0; k < count; ++k) {
+                slots_.push_back({threadName(p, k), 0, "", ""});
+                respawn(slots_.size() - 1);
+            }
+            process.end_slot = slots_.size();
+            processes_.push_back(process);
+        }
+    }
+
+    void respawn(size_t slot) {
+        static const char* const AFFINITIES[] = {"0-7", "4-7", "0-3", "7"};
+        static const char* const CPUSETS[] = {"top-app", "foreground", "background", "system-background"};
+        slots_[slot].tid = next_tid_++;
+        slots_[slot].affinity = AFFINITIES[next() % 4];
+        slots_[slot].cpuset = CPUSETS[next() % 4];
+    }
+
+    static std::string threadName(int process, int k) {
+        static const char* const GAME[] = {"UnityMain", "UnityGfxDeviceW", "RenderThread", "AudioTrack", "UnityPreload"};
+        if (process == 0 && k < 5) return GAME[k];
+        return (process == 0 ? "Job.Worker " : "binder:") + std::to_string(k);
+    }
+
+    uint32_t next() {
+        seed_ = seed_ * 1103515245u + 12345u;
+        return seed_ >> 8;
+    }
+
+    SyntheticSpec spec_;
+    uint32_t seed_;
+    int next_tid_ = 20000;
+    std::vector<Slot> slots_;
+    std::vector<Process> processes_;
+};
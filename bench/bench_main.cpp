@@ -0,0 +1,182 @@
+// 微基准：采样线程里的解析函数和绘图前的数据转换，输出 ns/op 和 allocs/op
+// 用法: bench [名字子串]   只跑名字包含该子串的项
+// 读文件的项(live)测的是本机/proc，其余项用 fixtures/ 里从手机上抓的内容
+#include "CpuLoadMonitor.hpp"
+#include "FpsMonitor.hpp"
+#include "ForegroundTracker.hpp"
+#include "SyntheticReport.hpp"
+#include "ThreadMonitor.hpp"
+#include "draw_svg.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifndef BENCH_FIXTURES
+#define BENCH_FIXTURES "bench/fixtures"
+#endif
+
+// 统计堆分配次数：替换全局operator new，基准都在主线程上跑
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"  //内联后看到malloc/free配对，替换全局new时的误报
+#endif
+static size_t g_allocations = 0;
+
+void* operator new(size_t size) {
+    ++g_allocations;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return ::operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+template <typename T>
+inline void keep(const T& value) {  //阻止编译器把结果当成无用代码删掉
+    asm volatile("" : : "r"(&value) : "memory");
+}
+
+static std::string g_filter;
+
+// 先跑一轮预热，再倍增次数直到单轮超过0.2秒，按最后一轮计算
+template <typename F>
+void bench(const char* name, F&& fn) {
+    if (!g_filter.empty() && std::string(name).find(g_filter) == std::string::npos) return;
+    fn();
+
+    using clock = std::chrono::steady_clock;
+    size_t iterations = 1;
+    for (;;) {
+        size_t allocations = g_allocations;
+        auto begin = clock::now();
+        for (size_t i = 0; i < iterations; ++i) fn();
+        double elapsed = std::chrono::duration<double, std::nano>(clock::now() - begin).count();
+        allocations = g_allocations - allocations;
+        if (elapsed >= 2e8 || iterations >= (size_t(1) << 30)) {
+            printf("%-36s %14.1f ns/op %10.1f allocs/op %12zu次\n", name, elapsed / iterations,
+                   static_cast<double>(allocations) / iterations, iterations);
+            return;
+        }
+        iterations *= 2;
+    }
+}
+
+static std::string readFixture(const char* name, bool first_line = false) {  //单行的节点内容监控器是用getline读的，不带换行
+    std::ifstream file(std::string(BENCH_FIXTURES) + "/" + name, std::ios::binary);
+    if (!file) {
+        fprintf(stderr, "找不到 %s/%s\n", BENCH_FIXTURES, name);
+        std::exit(1);
+    }
+    std::stringstream ss;
+    ss << file.rdbuf();
+    std::string content = ss.str();
+    return first_line ? content.substr(0, content.find('\n')) : content;
+}
+
+struct MonitorBench {
+    static void run() {
+        std::string proc_stat = readFixture("proc_stat.txt");
+        CPULoadMonitor cpu_load;
+        cpu_load.core_count_ = 8;
+        std::vector<CPULoadMonitor::CoreStat> stats(8);
+        bench("cpu_load/proc_stat", [&] {
+            std::istringstream in(proc_stat);
+            cpu_load.readCoreStats(in, stats);
+            keep(stats);
+        });
+
+        CPULoadMonitor host_load;
+        host_load.core_count_ = static_cast<int>(sysconf(_SC_NPROCESSORS_CONF));
+        std::vector<CPULoadMonitor::CoreStat> host_stats(host_load.core_count_);
+        bench("cpu_load/proc_stat(live)", [&] {
+            std::ifstream in("/proc/stat");
+            host_load.readCoreStats(in, host_stats);
+            keep(host_stats);
+        });
+
+        ThreadMonitor thread;
+        ThreadMonitor::ThreadInfo info;
+        int pid = getpid();
+        int tid = static_cast<int>(syscall(SYS_gettid));
+        bench("thread/readThreadStat(live)", [&] {
+            bool ok = thread.readThreadStat(pid, tid, info);
+            keep(ok);
+        });
+        bench("thread/getThreadAffinity(live)", [&] {
+            std::string affinity = thread.getThreadAffinity(pid, tid);
+            keep(affinity);
+        });
+
+        FPSMonitor fps;
+        std::string measured = readFixture("measured_fps.txt", true);
+        std::string measured_bare = readFixture("measured_fps_bare.txt", true);
+        std::string frame_line = readFixture("surfaceflinger_frame.txt", true);
+        bench("fps/extractFPSFromContent", [&] {
+            double value = fps.extractFPSFromContent(measured);
+            keep(value);
+        });
+        bench("fps/extractFPSFromContent(bare)", [&] {
+            double value = fps.extractFPSFromContent(measured_bare);
+            keep(value);
+        });
+        bench("fps/extractFrameNumber", [&] {
+            int value = fps.extractFrameNumber(frame_line);
+            keep(value);
+        });
+    }
+};
+
+static void benchForeground() {
+    std::string lru = readFixture("activity_lru.txt");
+    bench("foreground/readForegroundAppLru", [&] {
+        FILE* file = fmemopen(lru.data(), lru.size(), "r");
+        std::string package = readForegroundAppLru(file);
+        fclose(file);
+        keep(package);
+    });
+}
+
+static void benchDrawParse() {
+    SyntheticSpec spec;  // 10分钟、1秒一帧，8核+gpu，3个进程共100个线程，每分钟换30个线程
+    spec.churn = 30;
+    ReportData report = SyntheticReport(spec).generate();
+    bench("draw/parseFpsData", [&] {
+        auto frames = parseFpsData(report);
+        keep(frames);
+    });
+    bench("draw/CPUFreqFrameData", [&] {
+        auto frames = CPUFreqFrameData(report);
+        keep(frames);
+    });
+    bench("draw/parseCpuLoadData", [&] {
+        auto frames = parseCpuLoadData(report);
+        keep(frames);
+    });
+    bench("draw/parseThermalData", [&] {
+        auto frames = parseThermalData(report);
+        keep(frames);
+    });
+    bench("draw/parseThreadData", [&] {
+        auto series = parseThreadData(report);
+        keep(series);
+    });
+    bench("draw/parseThreadClassData", [&] {
+        auto frames = parseThreadClassData(report);
+        keep(frames);
+    });
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) g_filter = argv[1];
+    MonitorBench::run();
+    benchForeground();
+    benchDrawParse();
+    return 0;
+}
@@ -0,0 +1,209 @@
+// 规模基准：不同时长的合成记录走一遍 -i 的流程(载入 -> 建图(含parseThreadData) -> 渲染svg)
+// 每个时长在单独的子进程里跑，峰值RSS互不影响；记录文件也由另一个子进程生成，不计入峰值
+//   bench_scale [--sizes 10m,1h,3h] [--cores N] [--threads N] [--processes N] [--rate Hz] [--churn 每分钟]
+//               [-f json|cbor|msgpack] [-j 线程数] [--keep 目录]
+//   bench_scale --gen <文件> [--duration 3h] [同上的参数]   只生成一个合成记录
+#include "ReportLoader.hpp"
+#include "ReportWriter.hpp"
+#include "SyntheticReport.hpp"
+#include "ThreadPool.hpp"
+#include "draw_svg.hpp"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <getopt.h>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+struct StageTimes {  //子进程通过管道传回
+    double load_ms;
+    double parse_ms;   // parseThreadData单独跑一遍
+    double charts_ms;  // buildCharts，其中也包括一次parseThreadData
+    double render_ms;
+    uint64_t svg_bytes;
+};
+
+static bool parseDuration(const std::string& text, uint64_t& seconds) {  // 90、90s、10m、3h
+    char* end = nullptr;
+    double value = std::strtod(text.c_str(), &end);
+    std::string unit = end;
+    if (end == text.c_str() || value <= 0) return false;
+    if (unit.empty() || unit == "s") {
+        seconds = static_cast<uint64_t>(value);
+    } else if (unit == "m") {
+        seconds = static_cast<uint64_t>(value * 60);
+    } else if (unit == "h") {
+        seconds = static_cast<uint64_t>(value * 3600);
+    } else {
+        return false;
+    }
+    return seconds > 0;
+}
+
+static double msSince(std::chrono::steady_clock::time_point begin) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+
+template <typename F>
+static bool inChild(F&& fn, rusage* usage = nullptr) {  //在子进程里执行fn，返回是否正常退出
+    pid_t pid = fork();
+    if (pid < 0) return false;
+    if (pid == 0) _exit(fn() ? 0 : 1);
+    int status = 0;
+    rusage local;
+    wait4(pid, &status, 0, usage ? usage : &local);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static bool runPipeline(const std::string& path, unsigned jobs, StageTimes& times) {
+    ThreadPool pool(jobs);
+    auto begin = std::chrono::steady_clock::now();
+    ReportData report = loadReport(path);
+    times.load_ms = msSince(begin);
+
+    begin = std::chrono::steady_clock::now();
+    auto thread_series = parseThreadData(report);
+    times.parse_ms = msSince(begin);
+    thread_series.clear();
+
+    begin = std::chrono::steady_clock::now();
+    std::vector<ChartSpec> charts = buildCharts(report, {}, &pool);
+    times.charts_ms = msSince(begin);
+
+    begin = std::chrono::steady_clock::now();
+    std::string svg = render_svg(charts, report.name, report.time, &pool);
+    times.render_ms = msSince(begin);
+    times.svg_bytes = svg.size();
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    SyntheticSpec spec;
+    std::vector<uint64_t> sizes = {600, 3600, 3 * 3600};
+    ReportFormat format = ReportFormat::Json;
+    unsigned jobs = std::thread::hardware_concurrency();
+    std::string keep_dir;
+    std::string gen_path;
+
+    static const option long_options[] = {
+        {"sizes", required_argument, nullptr, 's'},
+        {"duration", required_argument, nullptr, 'd'},
+        {"cores", required_argument, nullptr, 'c'},
+        {"threads", required_argument, nullptr, 't'},
+        {"processes", required_argument, nullptr, 'p'},
+        {"rate", required_argument, nullptr, 'r'},
+        {"churn", required_argument, nullptr, 'n'},
+        {"keep", required_argument, nullptr, 'k'},
+        {"gen", required_argument, nullptr, 'g'},
+        {nullptr, 0, nullptr, 0}};
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "f:j:h", long_options, nullptr)) != -1) {
+        switch (opt) {
+        case 's': {
+            sizes.clear();
+            std::stringstream items(optarg);
+            std::string item;
+            while (std::getline(items, item, ',')) {
+                uint64_t seconds = 0;
+                if (!parseDuration(item, seconds)) {
+                    fprintf(stderr, "无效时长: %s\n", item.c_str());
+                    return 1;
+                }
+                sizes.push_back(seconds);
+            }
+            break;
+        }
+        case 'd':
+            if (!parseDuration(optarg, spec.duration_s)) {
+                fprintf(stderr, "无效时长: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'c': spec.cores = std::stoi(optarg); break;
+        case 't': spec.threads = std::stoi(optarg); break;
+        case 'p': spec.processes = std::max(1, std::stoi(optarg)); break;
+        case 'r': spec.rate_hz = std::stod(optarg); break;
+        case 'n': spec.churn = std::stod(optarg); break;
+        case 'k': keep_dir = optarg; break;
+        case 'g': gen_path = optarg; break;
+        case 'j': jobs = std::stoi(optarg); break;
+        case 'f':
+            if (!parseReportFormat(optarg, format)) {
+                fprintf(stderr, "未知格式: %s\n", optarg);
+                return 1;
+            }
+            break;
+        default:
+            fprintf(stderr, "用法见 bench/bench_scale.cpp 开头\n");
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (spec.rate_hz <= 0) {
+        fprintf(stderr, "采样频率必须大于0\n");
+        return 1;
+    }
+
+    if (!gen_path.empty()) {
+        if (!writeReport(gen_path, SyntheticReport(spec).generate(), format)) {
+            fprintf(stderr, "无法写入 %s\n", gen_path.c_str());
+            return 1;
+        }
+        return 0;
+    }
+
+    namespace fs = std::filesystem;
+    fs::path dir = keep_dir.empty() ? fs::temp_directory_path() / ("bench_scale_" + std::to_string(getpid())) : fs::path(keep_dir);
+    fs::create_directories(dir);
+
+    printf("%d核 %d线程 %d进程 %.3gHz 每分钟换%.3g个线程 -j%u\n", spec.cores, spec.threads, spec.processes, spec.rate_hz,
+           spec.churn, jobs);
+    printf("%8s %10s %10s %10s %16s %10s %10s %10s %12s %10s\n", "时长", "帧数", "文件(MB)", "载入(ms)",
+           "parseThread(ms)", "建图(ms)", "渲染(ms)", "合计(ms)", "峰值RSS(MB)", "svg(MB)");
+
+    for (uint64_t seconds : sizes) {
+        spec.duration_s = seconds;
+        std::string path = (dir / ("synthetic_" + std::to_string(seconds) + "s" + reportFileExtension(format))).string();
+        if (!fs::exists(path) && !inChild([&] { return writeReport(path, SyntheticReport(spec).generate(), format); })) {
+            fprintf(stderr, "生成 %s 失败\n", path.c_str());
+            return 1;
+        }
+
+        int fds[2];
+        if (pipe(fds) != 0) return 1;
+        rusage usage{};
+        bool ok = inChild(
+            [&] {
+                close(fds[0]);
+                StageTimes times{};
+                bool done = runPipeline(path, jobs, times);
+                return done && write(fds[1], &times, sizeof(times)) == static_cast<ssize_t>(sizeof(times));
+            },
+            &usage);
+        close(fds[1]);
+        StageTimes times{};
+        ok = ok && read(fds[0], &times, sizeof(times)) == static_cast<ssize_t>(sizeof(times));
+        close(fds[0]);
+        if (!ok) {
+            fprintf(stderr, "%llus: 子进程失败\n", static_cast<unsigned long long>(seconds));
+            continue;
+        }
+
+        char duration[32];
+        snprintf(duration, sizeof(duration), "%llu:%02llu:%02llu", static_cast<unsigned long long>(seconds / 3600),
+                 static_cast<unsigned long long>(seconds / 60 % 60), static_cast<unsigned long long>(seconds % 60));
+        uint64_t frames = static_cast<uint64_t>(seconds * spec.rate_hz);
+        printf("%8s %10llu %10.1f %10.0f %16.0f %10.0f %10.0f %10.0f %12.1f %10.1f\n", duration,
+               static_cast<unsigned long long>(frames), fs::file_size(path) / 1048576.0, times.load_ms, times.parse_ms,
+               times.charts_ms, times.render_ms, times.load_ms + times.charts_ms + times.render_ms,
+               usage.ru_maxrss / 1024.0, times.svg_bytes / 1048576.0);
+        fflush(stdout);
+    }
+
+    if (keep_dir.empty()) fs::remove_all(dir);
+    return 0;
+}
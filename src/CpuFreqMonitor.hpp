@@ -8,9 +8,12 @@ class CPUFreqMonitor : public MonitorBase {
 private:
     std::vector<std::string> cpu_freq_nodes_;
     std::vector<std::string> cpu_names_;
+    std::vector<uint32_t> cpu_channels_;
+    uint32_t gpu_channel_ = 0;
     std::string gpu_freq_node_;
     bool has_gpu_ = false;
-    std::vector<nlohmann::json> data_;
+    ChannelSeries data_;
+    SeqLock<LiveChannels> latest_;
     int interval_ms_ = 1000;
 
 public:
@@ -20,25 +23,43 @@ public:
         interval_ms_ = interval_ms;
         discoverFrequencyNodes();
         running_ = true;
-        worker_thread_ = std::thread(&CPUFreqMonitor::worker, this);
+        worker_thread_ = SessionClock::thread(&CPUFreqMonitor::worker, this);
         return true;
     }
 
-    nlohmann::json stop() override {
+    void stop() override {
         running_ = false;
         if (worker_thread_.joinable()) {
             worker_thread_.join();
         }
-        return data_;
+    }
+
+    void exportTo(ReportData& report) override {
+        report.cpu_freq = std::move(data_);
+    }
+
+    void appendLive(ReportData& live) override {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        live.cpu_freq.appendFrom(data_);
+    }
+
+    void drainTo(ReportData& out) override {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        out.cpu_freq.takeFrom(data_);
+    }
+
+    void readLatest(LiveSample& sample) override {
+        latest_.load(sample.cpu_freq);
     }
 
 private:
     void discoverFrequencyNodes() {
         cpu_freq_nodes_.clear();
         cpu_names_.clear();
+        cpu_channels_.clear();
 
         std::string cpu_base = "/sys/devices/system/cpu";
-        DIR* cpu_dir = opendir(cpu_base.c_str());
+        DIR* cpu_dir = opendir(SysRoot::path(cpu_base).c_str());
         if (cpu_dir) {
             // 使用map来自动排序
             std::map<int, std::pair<std::string, std::string>> cpu_map;  // cpu_id -> (node_path, cpu_name)
@@ -60,7 +81,7 @@ private:
 
                     if (is_number) {
                         int cpu_id = std::stoi(cpu_id_str);
-                        std::string freq_path = cpu_base + "/" + dir_name + "/cpufreq/cpuinfo_cur_freq";
+                        std::string freq_path = SysRoot::path(cpu_base + "/" + dir_name + "/cpufreq/cpuinfo_cur_freq");
 
                         if (access(freq_path.c_str(), R_OK) == 0) {
                             cpu_map[cpu_id] = {freq_path, dir_name};
@@ -74,6 +95,7 @@ private:
             for (const auto& [cpu_id, node_info] : cpu_map) {
                 cpu_freq_nodes_.push_back(node_info.first);
                 cpu_names_.push_back(node_info.second);
+                cpu_channels_.push_back(data_.channel(node_info.second));
             }
         }
 
@@ -88,37 +110,33 @@ private:
         };
         has_gpu_ = false;
         for (const auto& node : gpu_freq_nodes) {
-            if (access(node.c_str(), R_OK) == 0) {
+            std::string path = SysRoot::path(node);
+            if (access(path.c_str(), R_OK) == 0) {
                 has_gpu_ = true;
-                gpu_freq_node_ = node;
+                gpu_freq_node_ = path;
+                gpu_channel_ = data_.channel("gpu");
                 break;
             }
         }
     }
 
     void worker() {
-        auto start_time = std::chrono::steady_clock::now();
+        auto start_time = SessionClock::now();
         init_clock(interval_ms_);
         while (running_) {
-            auto sample_time = std::chrono::steady_clock::now();
+            auto sample_time = SessionClock::now();
             auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
                                  sample_time - start_time)
                                  .count();
 
-            nlohmann::json sample;
-            sample["time_ms"] = timestamp;
-            sample["data"] = nlohmann::json::array();
-
             // 采集CPU频率
             for (size_t i = 0; i < cpu_freq_nodes_.size(); i++) {
                 std::ifstream file(cpu_freq_nodes_[i]);
                 if (file) {
                     long freq_hz = 0;
                     if (file >> freq_hz) {
-                        nlohmann::json cpu_data;
-                        cpu_data["name"] = cpu_names_[i];
-                        cpu_data["freq"] = freq_hz;
-                        sample["data"].push_back(cpu_data);
+                        std::lock_guard<std::mutex> lock(data_mutex_);
+                        data_.add(cpu_channels_[i], freq_hz);
                     }
                 }
             }
@@ -129,15 +147,19 @@ private:
                 if (file) {
                     long freq_hz = 0;
                     if (file >> freq_hz) {
-                        nlohmann::json gpu_data;
-                        gpu_data["name"] = "gpu";
-                        gpu_data["freq"] = freq_hz / 1000;  // 对齐单位
-                        sample["data"].push_back(gpu_data);
+                        std::lock_guard<std::mutex> lock(data_mutex_);
+                        data_.add(gpu_channel_, freq_hz / 1000);  // 对齐单位
                     }
                 }
             }
 
-            data_.push_back(sample);
+            LiveChannels latest{};
+            {
+                std::lock_guard<std::mutex> lock(data_mutex_);
+                data_.commitFrame(timestamp);
+                latest.fromLastFrame(data_);
+            }
+            latest_.store(latest);
             _Sleep__();
         }
     }
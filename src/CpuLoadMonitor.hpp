@@ -1,9 +1,12 @@
 #pragma once
 #include "MonitorBase.hpp"
 #include <fstream>
+#include <set>
 #include <sstream>
 
 class CPULoadMonitor : public MonitorBase {
+    friend struct MonitorBench;  //基准测试(bench/)直接调用私有的解析函数
+
 private:
     struct CoreStat {
         unsigned long long user, nice, system, idle, iowait, irq, softirq;
@@ -11,9 +14,11 @@ private:
     
     int core_count_ = 0;
     std::vector<CoreStat> last_core_stats_;
-    std::vector<nlohmann::json> data_;
+    ChannelSeries data_;
+    SeqLock<LiveChannels> latest_;
     int interval_ms_ = 1000;
     std::string gpu_load_node_;
+    uint32_t gpu_channel_ = 0;
     bool has_gpu_ = false;
     
 public:
@@ -23,23 +28,40 @@ public:
         interval_ms_ = interval_ms;
         discoverCores();
         running_ = true;
-        worker_thread_ = std::thread(&CPULoadMonitor::worker, this);
+        worker_thread_ = SessionClock::thread(&CPULoadMonitor::worker, this);
         return true;
     }
     
-    nlohmann::json stop() override {
+    void stop() override {
         running_ = false;
         if (worker_thread_.joinable()) {
             worker_thread_.join();
         }
-        return data_;
+    }
+
+    void exportTo(ReportData& report) override {
+        report.cpu_load = std::move(data_);
+    }
+
+    void appendLive(ReportData& live) override {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        live.cpu_load.appendFrom(data_);
+    }
+
+    void drainTo(ReportData& out) override {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        out.cpu_load.takeFrom(data_);
+    }
+
+    void readLatest(LiveSample& sample) override {
+        latest_.load(sample.cpu_load);
     }
     
 private:
     void discoverCores() {
         core_count_ = 0;
         std::string cpu_base = "/sys/devices/system/cpu";
-        DIR* cpu_dir = opendir(cpu_base.c_str());
+        DIR* cpu_dir = opendir(SysRoot::path(cpu_base).c_str());
         if (cpu_dir) {
             std::set<int> cpu_ids; // 使用set自动排序和去重
             
@@ -67,7 +89,9 @@ private:
             closedir(cpu_dir);
             
             core_count_ = cpu_ids.size();
-            
+            for (int i = 0; i < core_count_; i++) {
+                data_.channel("cpu" + std::to_string(i));  //通道号与核心号一致
+            }
 
         }
 
@@ -78,50 +102,54 @@ private:
         };
         has_gpu_ = false;
         for (const auto& node : gpu_load_nodes) {
-            if (access(node.c_str(), R_OK) == 0) {
+            std::string path = SysRoot::path(node);
+            if (access(path.c_str(), R_OK) == 0) {
                 has_gpu_ = true;
-                gpu_load_node_ = node;
+                gpu_load_node_ = path;
+                gpu_channel_ = data_.channel("gpu");
                 break;
             }
         }
         
     }
     
+    void readCoreStats(std::istream& stat_file, std::vector<CoreStat>& current_stats) {  //解析/proc/stat的各核心行
+        std::string line;
+        int core_index = 0;
+        
+        // 跳过总的cpu行
+        std::getline(stat_file, line);
+        
+        while (std::getline(stat_file, line) && core_index < core_count_) {
+            if (line.find("cpu") == 0 && line[3] >= '0' && line[3] <= '9') {
+                std::istringstream iss(line);
+                std::string cpu_label;
+                iss >> cpu_label;
+                
+                CoreStat& stat = current_stats[core_index];
+                iss >> stat.user >> stat.nice >> stat.system >> stat.idle 
+                    >> stat.iowait >> stat.irq >> stat.softirq;
+                core_index++;
+            }
+        }
+    }
+    
     void worker() {
-        auto start_time = std::chrono::steady_clock::now();
+        auto start_time = SessionClock::now();
         
         while (running_) {
-            auto sample_time = std::chrono::steady_clock::now();
+            auto sample_time = SessionClock::now();
             auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
                 sample_time - start_time).count();
             
             std::vector<CoreStat> current_stats(core_count_);
-            std::ifstream stat_file("/proc/stat");
+            std::ifstream stat_file(SysRoot::path("/proc/stat"));
             init_clock(interval_ms_);
             if (stat_file) {
-                std::string line;
-                int core_index = 0;
-                
-                // 跳过总的cpu行
-                std::getline(stat_file, line);
-                
-                while (std::getline(stat_file, line) && core_index < core_count_) {
-                    if (line.find("cpu") == 0 && line[3] >= '0' && line[3] <= '9') {
-                        std::istringstream iss(line);
-                        std::string cpu_label;
-                        iss >> cpu_label;
-                        
-                        CoreStat& stat = current_stats[core_index];
-                        iss >> stat.user >> stat.nice >> stat.system >> stat.idle 
-                            >> stat.iowait >> stat.irq >> stat.softirq;
-                        core_index++;
-                    }
-                }
-                
-                nlohmann::json sample;
-                sample["time_ms"] = timestamp;
-                sample["data"] = nlohmann::json::array();
+                readCoreStats(stat_file, current_stats);
                 
+                LiveChannels latest{};
+                std::unique_lock<std::mutex> lock(data_mutex_);
                 if (!last_core_stats_.empty()) {
                     for (int i = 0; i < core_count_; i++) {
                         const CoreStat& last = last_core_stats_[i];
@@ -140,10 +168,7 @@ private:
                             load = 100.0 * (1.0 - static_cast<double>(idle_diff) / total_diff);
                         }
                         
-                        nlohmann::json core_data;
-                        core_data["name"] = "cpu" + std::to_string(i);
-                        core_data["load"] = load;
-                        sample["data"].push_back(core_data);
+                        data_.add(i, load);
                     }
                 }
 
@@ -152,16 +177,16 @@ private:
                     if (file) {
                         int load = 0;
                         if (file >> load) {
-                            nlohmann::json gpu_data;
-                            gpu_data["name"] = "gpu";
-                            gpu_data["load"] = static_cast<double>(load); 
-                            sample["data"].push_back(gpu_data);
+                            data_.add(gpu_channel_, static_cast<double>(load));
                         }
                     }
                 }
                 
-                data_.push_back(sample);
+                data_.commitFrame(timestamp);
+                latest.fromLastFrame(data_);
                 last_core_stats_ = current_stats;
+                lock.unlock();
+                latest_.store(latest);
             }
             
             _Sleep__();
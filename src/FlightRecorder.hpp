@@ -0,0 +1,242 @@
+#pragma once
+#include "MonitorBase.hpp"
+#include "ReportData.hpp"
+#include "ReportFormat.hpp"
+#include "ReportWriter.hpp"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// 守护模式(--daemon)的飞行记录器
+// 各监控器的帧定期移进一个只保留最近一段时间的环形窗口，触发条件命中后等到触发点之后post_ms，
+// 把[触发-pre_ms, 触发+post_ms]写成一个独立的记录文件(与普通记录同一格式，触发点写成标记)
+// 窗口按时间裁剪，线程名等字符串池也随之压缩到窗口内还引用的，内存只取决于pre/post长度，与守护进程运行多久无关
+// 画面卡住时SurfaceFlinger的帧号不动，FPSMonitor不产生样本，fps<X把超过STALL_MS没有新样本的时段当作0帧
+
+struct FlightTrigger {
+    enum class Kind {
+        FpsBelow,    // fps<X[:Y]  帧率低于X(或卡住没有新帧)持续Y毫秒
+        TempAbove,   // temp>T
+        ThreadAbove  // thread>L  任一线程负载超过L%
+    };
+
+    Kind kind;
+    double threshold;
+    uint64_t hold_ms = 0;
+    std::string spec;  //原始写法，用作标记名
+
+    // 运行状态：条件持续成立期间只触发一次
+    bool active = false;
+    uint64_t since_ms = 0;
+    bool fired = false;
+};
+
+// 解析逗号分隔的触发条件，格式错误时返回false
+inline bool parseFlightTriggers(const std::string& text, std::vector<FlightTrigger>& triggers) {
+    std::stringstream items(text);
+    std::string item;
+    while (std::getline(items, item, ',')) {
+        if (item.empty()) continue;
+        size_t op = item.find_first_of("<>");
+        if (op == std::string::npos) return false;
+
+        std::string key = item.substr(0, op);
+        char relation = item[op];
+        std::string value = item.substr(op + 1);
+        FlightTrigger trigger{};
+        trigger.spec = item;
+
+        size_t colon = value.find(':');
+        char* end = nullptr;
+        trigger.threshold = std::strtod(value.substr(0, colon).c_str(), &end);
+        if (*end != '\0' || value.empty()) return false;
+        if (colon != std::string::npos) {
+            if (key != "fps") return false;
+            trigger.hold_ms = std::strtoull(value.c_str() + colon + 1, &end, 10);
+            if (*end != '\0') return false;
+        }
+
+        if (key == "fps" && relation == '<') {
+            trigger.kind = FlightTrigger::Kind::FpsBelow;
+        } else if (key == "temp" && relation == '>') {
+            trigger.kind = FlightTrigger::Kind::TempAbove;
+        } else if (key == "thread" && relation == '>') {
+            trigger.kind = FlightTrigger::Kind::ThreadAbove;
+        } else {
+            return false;
+        }
+        triggers.push_back(trigger);
+    }
+    return !triggers.empty();
+}
+
+class FlightRecorder {
+public:
+    FlightRecorder(const std::string& pkg, ReportFormat format, std::vector<FlightTrigger> triggers, uint64_t pre_ms,
+                   uint64_t post_ms)
+        : pkg_(pkg), format_(format), triggers_(std::move(triggers)), pre_ms_(pre_ms), post_ms_(post_ms) {}
+
+    // 收集新帧 -> 检查触发 -> 到期的片段落盘 -> 裁掉不再需要的旧帧
+    void tick(const std::vector<std::unique_ptr<MonitorBase>>& monitors) {
+        size_t fps_begin = ring_.fps.size(), thermal_begin = ring_.thermal.size(), thread_begin = ring_.thread.size();
+        for (auto& monitor : monitors) monitor->drainTo(ring_);
+        uint64_t now = latestTime();
+        if (ring_.fps.size() > fps_begin) {
+            has_fps_ = true;
+            last_fps_ms_ = ring_.fps.time_ms.back();
+        }
+        bool stalled = has_fps_ && now > last_fps_ms_ + STALL_MS;  //之前有过帧率样本，之后一直没有
+
+        for (auto& trigger : triggers_) {
+            switch (trigger.kind) {
+            case FlightTrigger::Kind::FpsBelow:
+                for (size_t i = fps_begin; i < ring_.fps.size(); ++i) {
+                    update(trigger, ring_.fps.values[i] < trigger.threshold, ring_.fps.time_ms[i], "");
+                }
+                if (stalled) {  //卡住从最后一个样本之后算起
+                    if (!trigger.active) update(trigger, true, last_fps_ms_, "");
+                    update(trigger, true, now, "(no frames)");
+                }
+                break;
+            case FlightTrigger::Kind::TempAbove:
+                for (size_t i = thermal_begin; i < ring_.thermal.size(); ++i) {
+                    update(trigger, ring_.thermal.values[i] > trigger.threshold, ring_.thermal.time_ms[i], "");
+                }
+                break;
+            case FlightTrigger::Kind::ThreadAbove:
+                for (size_t f = thread_begin; f < ring_.thread.size(); ++f) {
+                    const ThreadSeries::Thread* hottest = nullptr;
+                    size_t process_end = ring_.thread.processEnd(f);
+                    for (size_t p = ring_.thread.frames[f].first_process; p < process_end; ++p) {
+                        for (size_t t = ring_.thread.processes[p].first_thread; t < ring_.thread.threadEnd(p); ++t) {
+                            const auto& thread = ring_.thread.threads[t];
+                            if (!hottest || thread.load > hottest->load) hottest = &thread;
+                        }
+                    }
+                    bool hit = hottest && hottest->load > trigger.threshold;
+                    update(trigger, hit, ring_.thread.frames[f].time_ms, hit ? ring_.thread.strings[hottest->name] : "");
+                }
+                break;
+            }
+        }
+
+        while (!pending_.empty() && now >= pending_.front().time_ms + post_ms_) {
+            dump(false);
+        }
+
+        uint64_t keep_from = now > pre_ms_ ? now - pre_ms_ : 0;  //还要留着的最早时刻
+        if (!pending_.empty()) keep_from = std::min(keep_from, pending_.front().time_ms - std::min(pending_.front().time_ms, pre_ms_));
+        ring_.crop(keep_from, UINT64_MAX);
+        ring_.thread.compactStrings();
+        ring_.begin_ms = 0;
+        annotations_.erase(annotations_.begin(),
+                           std::find_if(annotations_.begin(), annotations_.end(),
+                                        [keep_from](const Marker& marker) { return marker.time_ms >= keep_from; }));
+    }
+
+    // 外部标记(标记管道)：和帧一起按时间裁剪，落在片段范围内的写进该片段
+    void annotate(std::vector<Marker> markers) {
+        annotations_.insert(annotations_.end(), std::make_move_iterator(markers.begin()),
+                            std::make_move_iterator(markers.end()));
+    }
+
+    void finish() {  //停止时把未满post_ms的片段也写出
+        while (!pending_.empty()) dump(true);
+    }
+
+private:
+    void update(FlightTrigger& trigger, bool hit, uint64_t time_ms, const std::string& detail) {
+        if (!hit) {
+            trigger.active = false;
+            trigger.fired = false;
+            return;
+        }
+        if (!trigger.active) {
+            trigger.active = true;
+            trigger.since_ms = time_ms;
+        }
+        if (!trigger.fired && time_ms - trigger.since_ms >= trigger.hold_ms) {
+            trigger.fired = true;
+            fire(time_ms, detail.empty() ? trigger.spec : trigger.spec + " " + detail);
+        }
+    }
+
+    void fire(uint64_t time_ms, const std::string& reason) {  //落在上一个片段窗口内的触发并入该片段
+        if (!pending_.empty() && time_ms <= pending_.back().time_ms + post_ms_) {
+            pending_.back().markers.push_back({time_ms, reason});
+            return;
+        }
+        pending_.push_back({time_ms, wallClock(), {{time_ms, reason}}});
+        std::cout << "触发: " << reason << " @" << time_ms / 1000.0 << "s" << std::endl;
+    }
+
+    void dump(bool partial) {
+        Pending clip = std::move(pending_.front());
+        pending_.erase(pending_.begin());
+
+        uint64_t from = clip.time_ms - std::min(clip.time_ms, pre_ms_), to = clip.time_ms + post_ms_;
+        ReportData report = ring_;
+        report.crop(from, to);
+        report.begin_ms = 0;
+        report.name = pkg_;
+        report.time = clip.wall_time;
+        report.markers = std::move(clip.markers);
+        for (const auto& marker : annotations_) {
+            if (marker.time_ms >= from && marker.time_ms <= to) report.markers.push_back(marker);
+        }
+        std::stable_sort(report.markers.begin(), report.markers.end(),
+                         [](const Marker& a, const Marker& b) { return a.time_ms < b.time_ms; });
+
+        std::string filename =
+            "flight_" + std::to_string(++dumped_) + "_" + std::to_string(clip.time_ms / 1000) + "s" + reportFileExtension(format_);
+        if (writeReport(filename, report, format_)) {
+            std::cout << "已保存: " << filename << (partial ? " (记录结束，片段不完整)" : "") << std::endl;
+        } else {
+            std::cerr << "无法写入 " << filename << std::endl;
+        }
+    }
+
+    uint64_t latestTime() const {
+        uint64_t latest = 0;
+        if (!ring_.fps.time_ms.empty()) latest = std::max(latest, ring_.fps.time_ms.back());
+        if (!ring_.thermal.time_ms.empty()) latest = std::max(latest, ring_.thermal.time_ms.back());
+        if (!ring_.cpu_load.time_ms.empty()) latest = std::max(latest, ring_.cpu_load.time_ms.back());
+        if (!ring_.cpu_freq.time_ms.empty()) latest = std::max(latest, ring_.cpu_freq.time_ms.back());
+        if (!ring_.power.time_ms.empty()) latest = std::max(latest, ring_.power.time_ms.back());
+        if (!ring_.memory.time_ms.empty()) latest = std::max(latest, ring_.memory.time_ms.back());
+        if (!ring_.thread.frames.empty()) latest = std::max(latest, ring_.thread.frames.back().time_ms);
+        return latest;
+    }
+
+    static std::string wallClock() {
+        auto now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+        std::stringstream ss;
+        ss << std::put_time(std::localtime(&now), "%Y-%m-%d %H:%M:%S");
+        return ss.str();
+    }
+
+    struct Pending {
+        uint64_t time_ms;  //第一次触发的时刻
+        std::string wall_time;
+        std::vector<Marker> markers;
+    };
+
+    std::string pkg_;
+    ReportFormat format_;
+    std::vector<FlightTrigger> triggers_;
+    uint64_t pre_ms_;
+    uint64_t post_ms_;
+    static constexpr uint64_t STALL_MS = 2000;  //帧率每秒采一次，连续两个周期没有样本算卡住
+    bool has_fps_ = false;
+    uint64_t last_fps_ms_ = 0;  //最近一个帧率样本，不随窗口裁剪
+    ReportData ring_;
+    std::vector<Pending> pending_;
+    std::vector<Marker> annotations_;
+    unsigned dumped_ = 0;
+};
@@ -0,0 +1,184 @@
+#pragma once
+#include "SessionClock.hpp"
+#include "SysRoot.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 跟踪前台应用(--follow)
+// 读top-app控制组的进程列表，pid -> 包名来自/proc/<pid>/cmdline并缓存，每次轮询通常只读一个小文件；
+// 读不到控制组(没有root、内核布局不同)时退回调用方给的慢速方法(dumpsys)，降低频率并放到后台线程，
+// 调用poll的倒计时线程不会被它卡住
+
+class ForegroundTracker {
+public:
+    explicit ForegroundTracker(std::function<std::string()> fallback) : fallback_(std::move(fallback)) {
+        static const char* const CANDIDATES[] = {
+            "/dev/cpuset/top-app/cgroup.procs",
+            "/dev/cpuset/top-app/tasks",
+            "/sys/fs/cgroup/cpuset/top-app/cgroup.procs",
+            "/sys/fs/cgroup/top-app/cgroup.procs",  // cgroup v2
+        };
+        for (const char* path : CANDIDATES) {
+            std::vector<int> pids;
+            if (readPids(path, pids)) {
+                list_path_ = path;
+                break;
+            }
+        }
+    }
+
+    bool usingCgroup() const { return !list_path_.empty(); }
+
+    // 当前前台包名；拿不到时返回空串
+    std::string detect() {
+        if (list_path_.empty()) return fallback_ ? fallback_() : "";
+
+        std::vector<int> pids;
+        if (!readPids(list_path_.c_str(), pids)) return "";
+
+        std::unordered_map<int, std::string> seen;
+        std::map<std::string, std::pair<int, int>> votes;  //包名 -> {进程数, 最大pid}
+        for (int pid : pids) {
+            auto cached = package_cache_.find(pid);
+            std::string package = cached != package_cache_.end() ? cached->second : packageOf(pid);
+            seen.emplace(pid, package);
+            if (package.empty()) continue;
+            auto& vote = votes[package];
+            ++vote.first;
+            vote.second = std::max(vote.second, pid);
+        }
+        package_cache_ = std::move(seen);  //退出的进程顺带清掉，pid复用时重新读取
+
+        std::string best;
+        std::pair<int, int> best_vote{0, 0};
+        for (const auto& [package, vote] : votes) {
+            if (vote > best_vote) {  //进程多的优先，相同时取最近启动的
+                best_vote = vote;
+                best = package;
+            }
+        }
+        return best;
+    }
+
+    // 按轮询间隔调用；连续两次看到同一个新包名才算切换，返回true并更新current
+    bool poll(std::string& current) {
+        std::string package;
+        if (pending_.valid()) {  //后台的慢速检测，做完之前不再启动新的
+            if (pending_.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return false;
+            package = pending_.get();
+        } else {
+            auto now = SessionClock::now();
+            if (now < next_poll_) return false;
+            next_poll_ = now + (usingCgroup() ? std::chrono::seconds(1) : std::chrono::seconds(10));
+            if (!usingCgroup()) {  //结果在之后的轮询里取
+                pending_ = std::async(std::launch::async, [this] { return detect(); });
+                return false;
+            }
+            package = detect();
+        }
+        if (package.empty() || package == current) {
+            candidate_.clear();
+            return false;
+        }
+        if (package != candidate_) {
+            candidate_ = package;
+            return false;
+        }
+        candidate_.clear();
+        current = package;
+        return true;
+    }
+
+private:
+    static bool readPids(const char* path, std::vector<int>& pids) {
+        FILE* file = fopen(SysRoot::path(path).c_str(), "r");
+        if (!file) return false;
+        int pid;
+        while (fscanf(file, "%d", &pid) == 1) pids.push_back(pid);
+        fclose(file);
+        return true;
+    }
+
+    static std::string packageOf(int pid) {  //应用进程的cmdline就是包名(子进程带":名字")，其余进程返回空
+        char path[32];
+        snprintf(path, sizeof(path), "/proc/%d/cmdline", pid);
+        FILE* file = fopen(SysRoot::path(path).c_str(), "r");
+        if (!file) return "";
+        char buf[256];
+        size_t n = fread(buf, 1, sizeof(buf) - 1, file);
+        fclose(file);
+        buf[n] = '\0';
+
+        std::string cmdline(buf);  //到第一个\0为止
+        cmdline = cmdline.substr(0, cmdline.find(':'));
+        if (cmdline.empty() || cmdline[0] == '/' || cmdline.find('.') == std::string::npos) return "";
+        return cmdline;
+    }
+
+    std::function<std::string()> fallback_;
+    std::string list_path_;
+    std::unordered_map<int, std::string> package_cache_;
+    std::string candidate_;
+    std::chrono::steady_clock::time_point next_poll_{};
+    std::future<std::string> pending_;  //放在最后：析构时先等后台检测结束，它用到的其他成员还在
+};
+
+// 从 dumpsys activity lru 的输出里找TOP(不是BTOP)的那一行，取其中的包名
+inline std::string readForegroundAppLru(FILE* pipe) {
+    char buffer[256];
+    std::string result = "";
+
+    while (fgets(buffer, sizeof(buffer), pipe)) {
+        if (result.empty()) {
+            size_t len = strlen(buffer);
+            size_t startPos = 0;
+            size_t endPos = 0;
+
+            for (size_t i = 16; i < len; ++i) {
+                if (buffer[i] == ':') {
+                    startPos = i + 1;                       //包名起始点
+                } else if (buffer[i] == '/' && startPos) {  //包名结束
+                    endPos = i;
+                    break;
+                }
+            }
+
+            //确保是TOP
+            if (startPos && endPos && endPos > startPos) {
+                bool foundValidTOP = false;
+                for (int i = startPos - 4; i >= 0; --i) {
+                    if (i + 3 < static_cast<int>(startPos) &&
+                        buffer[i] == 'T' &&
+                        buffer[i + 1] == 'O' &&
+                        buffer[i + 2] == 'P') {
+                        if (i == 0 || buffer[i - 1] != 'B') {
+                            foundValidTOP = true;
+                            break;
+                        }
+                    }
+                }
+
+                if (foundValidTOP) {
+                    result.assign(buffer + startPos, endPos - startPos);
+                    break;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+inline std::string getForegroundApp_lru() {  //捕捉前台游戏
+    FILE* pipe = popen("dumpsys activity lru", "r");
+    if (!pipe) return "";
+    std::string result = readForegroundAppLru(pipe);
+    pclose(pipe);
+    return result;
+}
@@ -6,13 +6,19 @@
 #include <unistd.h>
 
 class FPSMonitor : public MonitorBase {
+    friend struct MonitorBench;
+
 private:
-    std::string package_name_;
-    std::vector<nlohmann::json> data_;
+    ScalarSeries data_;
+    SeqLock<LiveScalar> latest_;
     int interval_ms_ = 1000;
     bool force_dumpsys_ = false;
     std::string fps_file_path_;
     bool sysfs_checked_ = false;
+    int last_frame_number_ = -1;
+    std::chrono::steady_clock::time_point last_frame_time_ = SessionClock::now();
+    std::atomic<bool> retargeted_{false};  //换了图层，帧号不能接着上一个包算
+    static constexpr const char* FRAME_NUMBER_NODE = "/.dumpsys/SurfaceFlinger-latency";  //快照里存dumpsys帧号输出的位置
 
 public:
     FPSMonitor(bool force_dumpsys = false) {
@@ -22,29 +28,51 @@ public:
     std::string name() override { return "fps"; }
 
     bool start(const std::string& pkgName, int interval_ms = 1000) override {
-        package_name_ = pkgName;
+        setPackage(pkgName);
         interval_ms_ = interval_ms;
         running_ = true;
-        worker_thread_ = std::thread(&FPSMonitor::worker, this);
+        worker_thread_ = SessionClock::thread(&FPSMonitor::worker, this);
         return true;
     }
 
-    nlohmann::json stop() override {
+    void stop() override {
         running_ = false;
         if (worker_thread_.joinable()) {
             worker_thread_.join();
         }
-        return data_;
+    }
+
+    void exportTo(ReportData& report) override {
+        report.fps = std::move(data_);
+    }
+
+    void appendLive(ReportData& live) override {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        live.fps.appendFrom(data_);
+    }
+
+    void drainTo(ReportData& out) override {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        out.fps.takeFrom(data_);
+    }
+
+    void readLatest(LiveSample& sample) override {
+        latest_.load(sample.fps);
+    }
+
+    void retarget(const std::string& pkgName) override {
+        setPackage(pkgName);
+        retargeted_ = true;
     }
 
 private:
     void worker() {
-        auto start_time = std::chrono::steady_clock::now();
+        auto start_time = SessionClock::now();
         initSysFSPath();
         init_clock(interval_ms_);
 
         while (running_) {
-            auto sample_time = std::chrono::steady_clock::now();
+            auto sample_time = SessionClock::now();
             auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
                                  sample_time - start_time)
                                  .count();
@@ -52,10 +80,11 @@ private:
             double fps = getFPS();
 
             if (fps > 0) {
-                nlohmann::json sample;
-                sample["time_ms"] = timestamp;
-                sample["data"] = fps;
-                data_.push_back(sample);
+                {
+                    std::lock_guard<std::mutex> lock(data_mutex_);
+                    data_.push(timestamp, fps);
+                }
+                latest_.store({static_cast<uint64_t>(timestamp), fps, true});
             }
 
             _Sleep__();
@@ -87,17 +116,18 @@ private:
     }
 
     double getFPSFromDumpsys() {
-        static int last_frame_number = -1;
-        static auto last_frame_time = std::chrono::steady_clock::now();
+        if (retargeted_.exchange(false)) {
+            last_frame_number_ = -1;
+        }
 
         int frame_number = getCurrentFrameNumber();
-        auto current_time = std::chrono::steady_clock::now();
+        auto current_time = SessionClock::now();
 
         double fps = 0.0;
 
-        if (frame_number != -1 && last_frame_number != -1) {
-            int frame_diff = frame_number - last_frame_number;
-            double time_diff = std::chrono::duration<double>(current_time - last_frame_time).count();
+        if (frame_number != -1 && last_frame_number_ != -1) {
+            int frame_diff = frame_number - last_frame_number_;
+            double time_diff = std::chrono::duration<double>(current_time - last_frame_time_).count();
 
             if (frame_diff > 0 && time_diff > 0 && frame_diff <= 200 && time_diff <= 10.0) {
                 fps = frame_diff / time_diff;
@@ -108,8 +138,8 @@ private:
         }
 
         if (frame_number != -1) {
-            last_frame_number = frame_number;
-            last_frame_time = current_time;
+            last_frame_number_ = frame_number;
+            last_frame_time_ = current_time;
         }
 
         return fps;
@@ -122,10 +152,11 @@ private:
             nullptr};
 
         for (int i = 0; paths[i] != nullptr; i++) {
-            if (access(paths[i], R_OK) == 0) {
-                std::string content = readFile(paths[i]);
+            std::string path = SysRoot::path(paths[i]);
+            if (access(path.c_str(), R_OK) == 0) {
+                std::string content = readFile(path);
                 if (!content.empty() && extractFPSFromContent(content) > 0) {
-                    fps_file_path_ = paths[i];
+                    fps_file_path_ = path;
                     return;
                 }
             }
@@ -210,9 +241,15 @@ private:
     }
 
     int getCurrentFrameNumber() {
-        std::string cmd = "dumpsys SurfaceFlinger -latency " + package_name_ +
+        std::string cmd = "dumpsys SurfaceFlinger -latency " + *package() +
                           " | grep 'frameNumber:' | tail -1";
-        std::string output = executeCommand(cmd);
+        std::string output;
+        if (SysRoot::active()) {  //离线时没有dumpsys，读快照里记下的输出
+            output = readFile(SysRoot::path(FRAME_NUMBER_NODE));
+        } else {
+            output = executeCommand(cmd);
+            SysRoot::put(FRAME_NUMBER_NODE, output);
+        }
         return extractFrameNumber(output);
     }
 
@@ -0,0 +1,343 @@
+#pragma once
+#include "LiveSample.hpp"
+#include "MonitorBase.hpp"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <string>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+// 记录期间的终端面板(--tui)
+// 数据来自各监控器的无锁快照(readLatest)，采样线程感知不到面板的存在；
+// 屏幕按单元格双缓冲，每帧只输出变化的单元格，面板自身的CPU占用超出预算时自动降低刷新率
+
+class TerminalScreen {  //字符单元格缓冲 + 差分输出
+public:
+    enum Color : uint8_t { Default, Dim, Bold, Green, Yellow, Red, Cyan };
+
+    void resize(int cols, int rows) {
+        cols_ = cols;
+        rows_ = rows;
+        back_.assign(static_cast<size_t>(cols) * rows, Cell{});
+        front_.assign(back_.size(), Cell{INVALID, Default});  //下一帧全部重画
+        full_redraw_ = true;
+    }
+
+    int cols() const { return cols_; }
+    int rows() const { return rows_; }
+
+    static int textWidth(const std::string& text) {  //显示宽度(列数)
+        int width = 0;
+        for (size_t i = 0; i < text.size();) width += charWidth(decodeUtf8(text, i));
+        return width;
+    }
+
+    void clear() { std::fill(back_.begin(), back_.end(), Cell{}); }
+
+    int print(int row, int col, const std::string& text, uint8_t color = Default) {  //返回结束列，超出屏幕的部分丢弃
+        if (row < 0 || row >= rows_) return col;
+        for (size_t i = 0; i < text.size();) {
+            uint32_t cp = decodeUtf8(text, i);
+            int width = charWidth(cp);
+            if (col + width > cols_) break;
+            at(row, col) = {cp, color};
+            if (width == 2) at(row, col + 1) = {CONTINUATION, color};
+            col += width;
+        }
+        return col;
+    }
+
+    void bar(int row, int col, int width, double fraction, uint8_t color) {  //八分之一格精度
+        static const char* const PARTS[] = {"", "▏", "▎", "▍", "▌", "▋", "▊", "▉"};
+        int eighths = static_cast<int>(std::clamp(fraction, 0.0, 1.0) * width * 8 + 0.5);
+        for (int i = 0; i < width; ++i) {
+            int fill = std::clamp(eighths - i * 8, 0, 8);
+            print(row, col + i, fill == 8 ? "█" : fill == 0 ? "·" : PARTS[fill], fill == 0 ? static_cast<uint8_t>(Dim) : color);
+        }
+    }
+
+    std::string flush() {  //生成把屏幕从上一帧变成这一帧的转义序列
+        std::string out;
+        if (full_redraw_) out += "\x1b[2J";
+        full_redraw_ = false;
+
+        int cursor_row = -1, cursor_col = -1;
+        uint8_t current_color = 0xff;
+        for (int r = 0; r < rows_; ++r) {
+            for (int c = 0; c < cols_; ++c) {
+                Cell& cell = at(r, c);
+                Cell& shown = front_[static_cast<size_t>(r) * cols_ + c];
+                if (cell == shown) continue;
+                shown = cell;
+                if (cell.cp == CONTINUATION) continue;  //随前一个宽字符输出
+
+                if (r != cursor_row || c != cursor_col) {
+                    out += "\x1b[" + std::to_string(r + 1) + ";" + std::to_string(c + 1) + "H";
+                }
+                if (cell.color != current_color) {
+                    out += SGR[cell.color];
+                    current_color = cell.color;
+                }
+                encodeUtf8(cell.cp, out);
+                cursor_row = r;
+                cursor_col = c + charWidth(cell.cp);
+            }
+        }
+        if (current_color != 0xff && current_color != Default) out += SGR[Default];
+        return out;
+    }
+
+private:
+    static constexpr uint32_t CONTINUATION = 0;         //宽字符占用的第二格
+    static constexpr uint32_t INVALID = 0xffffffffu;  //屏幕上内容未知
+    static constexpr const char* SGR[] = {"\x1b[0m", "\x1b[0;2m", "\x1b[0;1m", "\x1b[0;32m",
+                                          "\x1b[0;33m", "\x1b[0;31m", "\x1b[0;36m"};
+
+    struct Cell {
+        uint32_t cp = ' ';
+        uint8_t color = Default;
+        bool operator==(const Cell& other) const { return cp == other.cp && color == other.color; }
+    };
+
+    Cell& at(int row, int col) { return back_[static_cast<size_t>(row) * cols_ + col]; }
+
+    static uint32_t decodeUtf8(const std::string& text, size_t& i) {
+        unsigned char lead = text[i];
+        int extra = lead >= 0xf0 ? 3 : lead >= 0xe0 ? 2 : lead >= 0xc0 ? 1 : 0;
+        uint32_t cp = extra == 0 ? lead : lead & (0x3f >> extra);
+        ++i;
+        for (int k = 0; k < extra && i < text.size(); ++k, ++i) cp = (cp << 6) | (text[i] & 0x3f);
+        return cp;
+    }
+
+    static void encodeUtf8(uint32_t cp, std::string& out) {
+        if (cp < 0x80) {
+            out += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            out += static_cast<char>(0xc0 | (cp >> 6));
+            out += static_cast<char>(0x80 | (cp & 0x3f));
+        } else if (cp < 0x10000) {
+            out += static_cast<char>(0xe0 | (cp >> 12));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+            out += static_cast<char>(0x80 | (cp & 0x3f));
+        } else {
+            out += static_cast<char>(0xf0 | (cp >> 18));
+            out += static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+            out += static_cast<char>(0x80 | (cp & 0x3f));
+        }
+    }
+
+    static int charWidth(uint32_t cp) {  //东亚宽字符占两格，面板里只会出现中文和全角符号
+        return (cp >= 0x1100 && cp <= 0x115f) || (cp >= 0x2e80 && cp <= 0xa4cf) || (cp >= 0xac00 && cp <= 0xd7a3) ||
+                       (cp >= 0xf900 && cp <= 0xfaff) || (cp >= 0xfe30 && cp <= 0xfe4f) ||
+                       (cp >= 0xff00 && cp <= 0xff60) || (cp >= 0xffe0 && cp <= 0xffe6)
+                   ? 2
+                   : 1;
+    }
+
+    int cols_ = 0;
+    int rows_ = 0;
+    bool full_redraw_ = true;
+    std::vector<Cell> back_;   //正在画的一帧
+    std::vector<Cell> front_;  //终端上现在的内容
+};
+
+class LiveDashboard {
+public:
+    LiveDashboard(const std::string& pkg, double rate_hz) : pkg_(pkg), frame_interval_(1.0 / rate_hz) {}
+
+    void begin() {  //切到备用屏幕并隐藏光标，被信号打断时也要恢复终端
+        writeAll("\x1b[?1049h\x1b[?25l");
+        std::signal(SIGINT, restoreAndExit);
+        std::signal(SIGTERM, restoreAndExit);
+    }
+
+    void end() {
+        std::signal(SIGINT, SIG_DFL);
+        std::signal(SIGTERM, SIG_DFL);
+        writeAll("\x1b[0m\x1b[?25h\x1b[?1049l");
+    }
+
+    // 按刷新率重画，直到until；remaining为剩余秒数
+    void runUntil(const std::vector<std::unique_ptr<MonitorBase>>& monitors,
+                  std::chrono::steady_clock::time_point until, int remaining) {
+        using namespace std::chrono;
+        while (true) {
+            auto now = steady_clock::now();
+            if (now >= until) return;
+            if (now >= next_frame_) {
+                drawFrame(monitors, remaining);
+                next_frame_ = now + duration_cast<steady_clock::duration>(duration<double>(currentInterval()));
+            }
+            std::this_thread::sleep_until(std::min(until, next_frame_));
+        }
+    }
+
+private:
+    static constexpr double CPU_BUDGET = 0.005;  //面板最多占用单核的0.5%
+    static constexpr int NAME_WIDTH = 6;
+
+    static void writeAll(const std::string& data) {
+        size_t done = 0;
+        while (done < data.size()) {
+            ssize_t n = ::write(STDOUT_FILENO, data.data() + done, data.size() - done);
+            if (n <= 0) return;
+            done += n;
+        }
+    }
+
+    static void restoreAndExit(int sig) {  //只用异步信号安全的调用
+        static const char RESTORE[] = "\x1b[0m\x1b[?25h\x1b[?1049l";
+        ssize_t ignored = ::write(STDOUT_FILENO, RESTORE, sizeof(RESTORE) - 1);
+        (void)ignored;
+        std::signal(sig, SIG_DFL);
+        std::raise(sig);
+    }
+
+    static double threadCpuSeconds() {
+        timespec ts{};
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+    }
+
+    double currentInterval() const {  //平均每帧的CPU耗时按预算折算出最短间隔
+        return std::max(frame_interval_, frame_cost_ / CPU_BUDGET);
+    }
+
+    static uint8_t levelColor(double fraction) {
+        return fraction < 0.5 ? TerminalScreen::Green : fraction < 0.8 ? TerminalScreen::Yellow : TerminalScreen::Red;
+    }
+
+    static std::string format(const char* fmt, double value) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), fmt, value);
+        return buf;
+    }
+
+    void drawFrame(const std::vector<std::unique_ptr<MonitorBase>>& monitors, int remaining) {
+        double cpu_before = threadCpuSeconds();
+
+        for (auto& monitor : monitors) monitor->readLatest(sample_);  //读失败的部分沿用上一帧
+
+        winsize ws{};
+        int cols = 80, rows = 24;
+        if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0 && ws.ws_row > 0) {
+            cols = ws.ws_col;
+            rows = ws.ws_row;
+        }
+        if (cols != screen_.cols() || rows != screen_.rows()) screen_.resize(cols, rows);
+
+        screen_.clear();
+        layout(remaining);
+        writeAll(screen_.flush());
+
+        double cost = threadCpuSeconds() - cpu_before;
+        frame_cost_ = frames_++ == 0 ? cost : frame_cost_ * 0.9 + cost * 0.1;
+    }
+
+    void layout(int remaining) {
+        int cols = screen_.cols();
+        int row = 0;
+
+        int col = screen_.print(row, 0, "BLoadRecorder ", TerminalScreen::Bold);
+        screen_.print(row, col, pkg_, TerminalScreen::Cyan);
+        std::string countdown = "剩余 " + std::to_string(remaining) + "秒";
+        screen_.print(row, std::max(0, cols - TerminalScreen::textWidth(countdown)), countdown);
+        row += 2;
+
+        col = screen_.print(row, 0, "帧率 ", TerminalScreen::Dim);
+        col = screen_.print(row, col, sample_.fps.valid ? format("%.1f", sample_.fps.value) : "--", TerminalScreen::Bold);
+        col = screen_.print(row, col + 4, "最高温度 ", TerminalScreen::Dim);
+        col = screen_.print(row, col, sample_.thermal.valid ? format("%.0f°C", sample_.thermal.value) : "--",
+                            sample_.thermal.valid ? levelColor(sample_.thermal.value / 100.0) : uint8_t{TerminalScreen::Default});
+        if (sample_.power.valid) {
+            col = screen_.print(row, col + 4, "功耗 ", TerminalScreen::Dim);
+            col = screen_.print(row, col, format("%.2fW", sample_.power.watts), TerminalScreen::Bold);
+            col = screen_.print(row, col, format("  共%.0fJ", sample_.power.energy_j), TerminalScreen::Dim);
+        }
+        if (sample_.memory.valid) {
+            col = screen_.print(row, col + 4, "内存 ", TerminalScreen::Dim);
+            screen_.print(row, col, format("%.0fMB", sample_.memory.value), TerminalScreen::Bold);
+        }
+        row += 2;
+
+        // 每个通道一行：负载条 + 频率条(按记录中见过的最高频率归一)
+        int bar_width = std::clamp((cols - NAME_WIDTH - 7 - 9 - 2) / 2, 5, 40);
+        int freq_col = NAME_WIDTH + bar_width + 7 + 1;
+        screen_.print(row, 0, "通道", TerminalScreen::Dim);
+        screen_.print(row, NAME_WIDTH, "负载", TerminalScreen::Dim);
+        screen_.print(row, freq_col, "频率", TerminalScreen::Dim);
+        ++row;
+
+        std::vector<std::string> names;
+        for (uint32_t c = 0; c < sample_.cpu_load.count; ++c) names.push_back(sample_.cpu_load.names[c]);
+        for (uint32_t c = 0; c < sample_.cpu_freq.count; ++c) {
+            if (std::find(names.begin(), names.end(), sample_.cpu_freq.names[c]) == names.end()) {
+                names.push_back(sample_.cpu_freq.names[c]);
+            }
+        }
+        int thread_rows = std::min<int>(sample_.thread.count, LiveThreads::MAX);
+        for (const auto& name : names) {
+            if (row >= screen_.rows() - (thread_rows > 0 ? 3 : 1)) break;  //给线程列表留出标题
+            screen_.print(row, 0, name);
+            const double* load = find(sample_.cpu_load, name);
+            if (load) {
+                screen_.bar(row, NAME_WIDTH, bar_width, *load / 100.0, levelColor(*load / 100.0));
+                screen_.print(row, NAME_WIDTH + bar_width + 1, format("%5.1f%%", *load));
+            }
+            const double* freq = find(sample_.cpu_freq, name);
+            if (freq) {
+                double& peak = peak_freq_[name];
+                peak = std::max(peak, *freq);
+                double fraction = peak > 0 ? *freq / peak : 0;
+                screen_.bar(row, freq_col, bar_width, fraction, TerminalScreen::Cyan);
+                screen_.print(row, freq_col + bar_width + 1, format("%.2fGHz", *freq / 1e6));
+            }
+            ++row;
+        }
+
+        if (thread_rows > 0 && row + 2 < screen_.rows()) {
+            ++row;
+            screen_.print(row++, 0, "热点线程", TerminalScreen::Dim);
+            int load_col = std::max(40, cols - bar_width - 8);
+            for (int i = 0; i < thread_rows && row < screen_.rows() - 1; ++i, ++row) {
+                const auto& item = sample_.thread.items[i];
+                col = screen_.print(row, 0, item.name, TerminalScreen::Bold);
+                screen_.print(row, 17, std::to_string(item.tid), TerminalScreen::Dim);
+                screen_.print(row, 25, item.process, TerminalScreen::Dim);
+                screen_.print(row, load_col - 1, " ");  //进程名过长时被负载条截断
+                screen_.bar(row, load_col, std::min(bar_width, cols - load_col - 7), item.load / 100.0,
+                            levelColor(item.load / 100.0));
+                screen_.print(row, cols - 6, format("%5.1f%%", item.load));
+            }
+        }
+
+        screen_.print(screen_.rows() - 1, 0,
+                      "面板 " + format("%.2f", frame_cost_ * 1000) + "ms/帧  刷新间隔 " +
+                          format("%.2f", currentInterval()) + "s",
+                      TerminalScreen::Dim);
+    }
+
+    static const double* find(const LiveChannels& channels, const std::string& name) {
+        for (uint32_t c = 0; c < channels.count; ++c) {
+            if (name == channels.names[c]) return &channels.values[c];
+        }
+        return nullptr;
+    }
+
+    std::string pkg_;
+    double frame_interval_;
+    double frame_cost_ = 0;  //每帧CPU耗时的滑动平均(秒)
+    uint64_t frames_ = 0;
+    std::chrono::steady_clock::time_point next_frame_{};
+    LiveSample sample_{};
+    TerminalScreen screen_;
+    std::map<std::string, double> peak_freq_;
+};
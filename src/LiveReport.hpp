@@ -0,0 +1,62 @@
+#pragma once
+#include "MonitorBase.hpp"
+#include "ReportData.hpp"
+#include "draw_html.hpp"
+#include "draw_svg.hpp"
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 记录过程中定期重写报告
+// 数据只追加新帧；时间轴按阶梯扩展，轴不变时每条折线只重算末尾未定的几列，已抽稀的前缀留在PathCache里
+// 省下的只是折线抽稀：buildCharts和网页报告仍要走一遍全部数据，每次刷新的开销随记录时长线性增长
+class LiveReport {
+public:
+    LiveReport(const std::string& pkg, const std::string& name, const std::string& time, const RenderOptions& options)
+        : pkg_(pkg), options_(options) {
+        data_.name = name;
+        data_.time = time;
+    }
+
+    void refresh(const std::vector<std::unique_ptr<MonitorBase>>& monitors) {
+        for (auto& monitor : monitors) {
+            monitor->appendLive(data_);
+        }
+
+        std::vector<ChartSpec> charts = buildCharts(data_, options_);
+        uint64_t horizon = timeHorizon(charts);
+        for (auto& chart : charts) {
+            chart.style.time_axis_max = horizon;
+            if (chart.style.chart_type == SVGFreqPlotter::ChartType::Line) {  //其他图表类型不走增量缓存
+                chart.path_cache = &caches_[chart.key.empty() ? chart.title : chart.key];
+            }
+        }
+
+        writeFileAtomic(pkg_ + ".svg", render_svg(charts, data_.name, data_.time));
+        if (options_.html) {
+            writeFileAtomic(pkg_ + ".html", render_html(charts, data_.name, data_.time));
+        }
+    }
+
+private:
+    // 轴右端取能容纳当前数据的最小阶梯值(60s起，每次放大1.5倍)
+    // 轴只在跨过阶梯时变化，这时缓存整体失效重算一次
+    uint64_t timeHorizon(const std::vector<ChartSpec>& charts) {
+        uint64_t latest = 0;
+        for (const auto& chart : charts) {
+            const auto& times = chart.data.time_ms;
+            if (!times.empty()) latest = std::max(latest, times.back());
+        }
+        while (horizon_ < latest) {
+            horizon_ = (horizon_ * 3 / 2 + 9999) / 10000 * 10000;  //取整到10s
+        }
+        return horizon_;
+    }
+
+    std::string pkg_;
+    RenderOptions options_;
+    ReportData data_;
+    uint64_t horizon_ = 60000;
+    std::map<std::string, SVGFreqPlotter::PathCache> caches_;
+};
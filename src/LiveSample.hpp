@@ -0,0 +1,135 @@
+#pragma once
+#include "ReportData.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+//各监控器最近一次采样的定长快照，供终端面板、指标导出等旁路读取
+//采样线程用SeqLock发布：写入只是几次原子store，从不等待读者；读者发现写入中途就重读
+
+template <typename T>
+class SeqLock {  //单写多读
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock只能发布平凡可复制的类型");
+
+public:
+    SeqLock() { store(T{}); }
+
+    void store(const T& value) {  //只能由唯一的写线程调用
+        uint64_t words[WORDS] = {};
+        std::memcpy(words, &value, sizeof(T));
+        uint32_t seq = seq_.load(std::memory_order_relaxed);
+        seq_.store(seq + 1, std::memory_order_relaxed);  //奇数：写入中
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; ++i) words_[i].store(words[i], std::memory_order_relaxed);
+        seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    bool load(T& out) const {  //一直撞上写入时放弃，调用方沿用上一次的值
+        for (int attempt = 0; attempt < 64; ++attempt) {
+            uint32_t before = seq_.load(std::memory_order_acquire);
+            if (before & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+            uint64_t words[WORDS];
+            for (size_t i = 0; i < WORDS; ++i) words[i] = words_[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq_.load(std::memory_order_relaxed) == before) {
+                std::memcpy(&out, words, sizeof(T));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    uint32_t version() const { return seq_.load(std::memory_order_acquire) / 2; }  //每发布一次加1
+
+private:
+    static constexpr size_t WORDS = (sizeof(T) + 7) / 8;
+    std::atomic<uint32_t> seq_{0};
+    std::array<std::atomic<uint64_t>, WORDS> words_{};
+};
+
+inline void copyName(char* dst, size_t size, const std::string& src) {  //超长截断，保证以0结尾
+    size_t n = std::min(size - 1, src.size());
+    std::memcpy(dst, src.data(), n);
+    dst[n] = '\0';
+}
+
+struct LiveScalar {  // fps、温度、目标进程RSS合计(MB)
+    uint64_t time_ms;
+    double value;
+    bool valid;  //还没有采到过时为false
+};
+
+struct LivePower {
+    uint64_t time_ms;
+    double watts;
+    double energy_j;  //记录开始以来累计
+    bool valid;
+};
+
+struct LiveChannels {  // cpu频率、负载：最后一帧的各通道
+    static constexpr size_t MAX = 32;
+
+    uint64_t time_ms;
+    uint32_t count;
+    char names[MAX][8];
+    double values[MAX];
+
+    void fromLastFrame(const ChannelSeries& series) {  //通道号即下标，没有值的通道记为0
+        size_t frame = series.size() - 1;
+        time_ms = series.time_ms[frame];
+        count = static_cast<uint32_t>(std::min(series.channels.size(), MAX));
+        for (uint32_t c = 0; c < count; ++c) {
+            copyName(names[c], sizeof(names[c]), series.channels[c]);
+            values[c] = 0;
+        }
+        for (size_t v = series.offsets[frame]; v < series.offsets[frame + 1]; ++v) {
+            if (series.values[v].channel < count) values[series.values[v].channel] = series.values[v].value;
+        }
+    }
+};
+
+struct LiveThreads {  //最后一帧负载最高的几个线程，按负载降序
+    static constexpr size_t MAX = 10;
+
+    struct Item {
+        char name[16];  // comm最长15字节
+        char process[40];
+        int32_t pid;
+        int32_t tid;
+        double load;
+    };
+
+    uint64_t time_ms;
+    uint32_t count;
+    Item items[MAX];
+
+    void offer(const std::string& name, const std::string& process, int pid, int tid, double load) {  //插入排序
+        if (count == MAX && load <= items[MAX - 1].load) return;
+        size_t pos = count < MAX ? count++ : MAX - 1;
+        while (pos > 0 && items[pos - 1].load < load) {
+            items[pos] = items[pos - 1];
+            --pos;
+        }
+        copyName(items[pos].name, sizeof(items[pos].name), name);
+        copyName(items[pos].process, sizeof(items[pos].process), process);
+        items[pos].pid = pid;
+        items[pos].tid = tid;
+        items[pos].load = load;
+    }
+};
+
+struct LiveSample {  //读者汇总各监控器的快照
+    LiveChannels cpu_freq;
+    LiveChannels cpu_load;
+    LiveScalar fps;
+    LiveScalar thermal;
+    LivePower power;
+    LiveScalar memory;
+    LiveThreads thread;
+};
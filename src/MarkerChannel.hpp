@@ -0,0 +1,138 @@
+#pragma once
+#include "ReportData.hpp"
+#include "SessionClock.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <fcntl.h>
+#include <mutex>
+#include <poll.h>
+#include <string>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// 记录期间从命名管道接收标记(--marker-fifo)，供自动化脚本标注"进入副本""打开地图"等时刻
+//   echo "进入副本" > 管道          记一个标记，从这一刻起进入同名区段
+//   echo "start 打开地图" > 管道    同上
+//   echo "mark 打开地图" > 管道     同上
+//   echo "stop" > 管道              结束当前区段(记一个无名标记)，直到下一个标记之前不属于任何区段
+// 一行一条命令，时间取收到时距记录开始的毫秒数(与各监控器同一时钟)
+// 单独的读线程阻塞在poll上，只在收到命令时加锁追加，采样线程不受影响
+
+class MarkerChannel {
+public:
+    MarkerChannel(const std::string& path, std::chrono::steady_clock::time_point started)
+        : path_(path), started_(started) {}
+
+    ~MarkerChannel() { stop(); }
+
+    bool start() {  //路径已存在但不是管道、或无法创建时返回false
+        struct stat st;
+        if (::stat(path_.c_str(), &st) == 0) {
+            if (!S_ISFIFO(st.st_mode)) return false;
+        } else {
+            if (::mkfifo(path_.c_str(), 0666) != 0) return false;
+            created_ = true;
+        }
+
+        fifo_fd_ = ::open(path_.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);  //自己也占着写端，写方全部关闭时不会一直读到EOF
+        if (fifo_fd_ < 0) {
+            if (created_) ::unlink(path_.c_str());
+            return false;
+        }
+        wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+        running_ = true;
+        thread_ = std::thread(&MarkerChannel::loop, this);
+        return true;
+    }
+
+    void stop() {
+        if (!running_) return;
+        running_ = false;
+        uint64_t one = 1;
+        ssize_t ignored = ::write(wake_fd_, &one, sizeof(one));
+        (void)ignored;
+        thread_.join();
+        drain();  //停止前已写进管道的命令也收下
+        ::close(fifo_fd_);
+        ::close(wake_fd_);
+        if (created_) ::unlink(path_.c_str());
+    }
+
+    // 到目前为止收到的标记(按时间)
+    std::vector<Marker> markers() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return markers_;
+    }
+
+    // 取走新收到的标记，守护模式按片段分发用
+    std::vector<Marker> take() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return std::move(markers_);
+    }
+
+private:
+    void loop() {
+        pollfd fds[2] = {{fifo_fd_, POLLIN, 0}, {wake_fd_, POLLIN, 0}};
+        while (running_) {
+            if (::poll(fds, 2, -1) < 0 && errno != EINTR) break;
+            if (fds[0].revents & POLLIN) drain();
+        }
+    }
+
+    void drain() {
+        char buf[4096];
+        ssize_t n;
+        while ((n = ::read(fifo_fd_, buf, sizeof(buf))) > 0) {
+            pending_.append(buf, static_cast<size_t>(n));
+            size_t begin = 0, end;
+            while ((end = pending_.find('\n', begin)) != std::string::npos) {
+                command(pending_.substr(begin, end - begin));
+                begin = end + 1;
+            }
+            pending_.erase(0, begin);
+            if (pending_.size() > MAX_LINE) pending_.clear();  //没有换行的超长输入直接丢弃
+        }
+    }
+
+    void command(std::string line) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        auto space = [](char c) { return c == ' ' || c == '\t'; };
+        line.erase(line.begin(), std::find_if_not(line.begin(), line.end(), space));
+        line.erase(std::find_if_not(line.rbegin(), line.rend(), space).base(), line.end());
+        if (line.empty()) return;
+
+        std::string name;
+        if (line == "stop") {
+            name.clear();
+        } else if (line.compare(0, 6, "start ") == 0 || line.compare(0, 5, "mark ") == 0) {
+            name = line.substr(line.find(' ') + 1);
+            name.erase(name.begin(), std::find_if_not(name.begin(), name.end(), space));
+        } else {
+            name = line;
+        }
+
+        uint64_t time_ms =
+            std::chrono::duration_cast<std::chrono::milliseconds>(SessionClock::now() - started_).count();
+        std::lock_guard<std::mutex> lock(mutex_);
+        markers_.push_back({time_ms, std::move(name)});
+    }
+
+    static constexpr size_t MAX_LINE = 1024;
+
+    std::string path_;
+    std::chrono::steady_clock::time_point started_;
+    bool created_ = false;
+    int fifo_fd_ = -1;
+    int wake_fd_ = -1;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+    std::string pending_;  //还没凑成一行的输入，只有读线程访问
+    mutable std::mutex mutex_;
+    std::vector<Marker> markers_;
+};
@@ -0,0 +1,262 @@
+#pragma once
+#include "MonitorBase.hpp"
+#include "ThreadMonitor.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fcntl.h>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+#include <vector>
+
+// 目标进程的内存：进程列表用ThreadMonitor扫到的，不再自己遍历/proc
+// 每次采样读/proc/<pid>/statm(RSS)，只是几个数字，很便宜；
+// smaps_rollup(PSS、swap、脏页)要走一遍进程的全部映射，大型游戏读一次要几毫秒到几十毫秒，
+// 和/proc/meminfo、/proc/vmstat一起按较慢的间隔读：间隔取读一次的CPU时间的100倍(占一个核1%)，
+// 限制在2~30秒之间，RSS变化超过一成或进程有增减时提前读
+// 数据写在ReportData::memory里，通道名：
+//   rss:<进程名> pss:<进程名> swap:<进程名> dirty:<进程名>   MB，同名进程相加
+//   MemAvailable   MB
+//   pgfault pgmajfault allocstall pgscan_kswapd   两次读之间的每秒次数(页数)
+
+class MemoryMonitor : public MonitorBase {
+private:
+    struct ProcessMemory {
+        double rss = 0, pss = 0, swap = 0, dirty = 0;
+        bool rollup = false;  //这一帧读到了smaps_rollup
+    };
+
+    struct VmCounters {
+        uint64_t pgfault = 0, pgmajfault = 0, allocstall = 0, pgscan_kswapd = 0;
+    };
+
+    const ThreadMonitor& threads_;
+    ChannelSeries data_;
+    SeqLock<LiveScalar> latest_;
+    int interval_ms_ = 1000;
+    double page_mb_ = sysconf(_SC_PAGESIZE) / 1048576.0;
+    std::string buffer_;  //读节点用，只有采样线程访问
+
+    static constexpr double DETAIL_BUDGET = 0.01;  //慢速读取占一个核的比例
+    static constexpr uint64_t DETAIL_MIN_MS = 2000;
+    static constexpr uint64_t DETAIL_MAX_MS = 30000;
+    static constexpr double RSS_CHANGE = 0.1;
+
+public:
+    explicit MemoryMonitor(const ThreadMonitor& threads) : threads_(threads) {}
+
+    std::string name() override { return "memory"; }
+
+    bool start(const std::string& /*pkgName*/, int interval_ms = 1000) override {
+        interval_ms_ = interval_ms;
+        running_ = true;
+        worker_thread_ = SessionClock::thread(&MemoryMonitor::worker, this);
+        return true;
+    }
+
+    void stop() override {
+        running_ = false;
+        if (worker_thread_.joinable()) {
+            worker_thread_.join();
+        }
+    }
+
+    void exportTo(ReportData& report) override {
+        report.memory = std::move(data_);
+    }
+
+    void appendLive(ReportData& live) override {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        live.memory.appendFrom(data_);
+    }
+
+    void drainTo(ReportData& out) override {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        out.memory.takeFrom(data_);
+    }
+
+    void readLatest(LiveSample& sample) override {
+        latest_.load(sample.memory);
+    }
+
+private:
+    bool readNode(const std::string& path) {  //整个读进buffer_
+        int fd = ::open(SysRoot::path(path).c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        buffer_.clear();
+        char chunk[4096];
+        ssize_t n;
+        while ((n = ::read(fd, chunk, sizeof(chunk))) > 0) buffer_.append(chunk, static_cast<size_t>(n));
+        ::close(fd);
+        return !buffer_.empty();
+    }
+
+    // 逐行取 "名字: 数值" 或 "名字 数值"，smaps_rollup、meminfo、vmstat都是这种格式
+    template <typename F>
+    static void forEachField(const std::string& text, F&& fn) {
+        size_t pos = 0;
+        while (pos < text.size()) {
+            size_t eol = text.find('\n', pos);
+            if (eol == std::string::npos) eol = text.size();
+            size_t key_end = text.find_first_of(": ", pos);
+            if (key_end != std::string::npos && key_end < eol) {
+                const char* value = text.c_str() + key_end + 1;
+                while (*value == ' ' || *value == ':') ++value;
+                fn(std::string_view(text).substr(pos, key_end - pos), std::strtoull(value, nullptr, 10));
+            }
+            pos = eol + 1;
+        }
+    }
+
+    bool readStatm(int pid, double& rss_mb) {  // statm第二项是常驻页数
+        if (!readNode("/proc/" + std::to_string(pid) + "/statm")) return false;
+        unsigned long long size = 0, resident = 0;
+        if (sscanf(buffer_.c_str(), "%llu %llu", &size, &resident) != 2) return false;
+        rss_mb = resident * page_mb_;
+        return true;
+    }
+
+    bool readRollup(int pid, ProcessMemory& memory) {  //老内核(4.14以前)没有smaps_rollup，不退回去读smaps
+        if (!readNode("/proc/" + std::to_string(pid) + "/smaps_rollup")) return false;
+        uint64_t pss = 0, swap = 0, swap_pss = 0, dirty = 0;
+        bool has_swap_pss = false;
+        forEachField(buffer_, [&](std::string_view key, uint64_t kb) {
+            if (key == "Pss") {
+                pss = kb;
+            } else if (key == "Swap") {
+                swap = kb;
+            } else if (key == "SwapPss") {  //共享的swap按比例分摊，和PSS口径一致
+                swap_pss = kb;
+                has_swap_pss = true;
+            } else if (key == "Private_Dirty" || key == "Shared_Dirty") {
+                dirty += kb;
+            }
+        });
+        memory.pss += pss / 1024.0;
+        memory.swap += (has_swap_pss ? swap_pss : swap) / 1024.0;
+        memory.dirty += dirty / 1024.0;
+        memory.rollup = true;
+        return true;
+    }
+
+    bool readMemAvailable(double& available_mb) {
+        if (!readNode("/proc/meminfo")) return false;
+        bool found = false;
+        forEachField(buffer_, [&](std::string_view key, uint64_t kb) {
+            if (key == "MemAvailable") {
+                available_mb = kb / 1024.0;
+                found = true;
+            }
+        });
+        return found;
+    }
+
+    bool readVmCounters(VmCounters& counters) {  // allocstall、pgscan_kswapd在新内核上按zone拆成了多项，相加
+        if (!readNode("/proc/vmstat")) return false;
+        counters = {};
+        forEachField(buffer_, [&](std::string_view key, uint64_t value) {
+            if (key == "pgfault") {
+                counters.pgfault = value;
+            } else if (key == "pgmajfault") {
+                counters.pgmajfault = value;
+            } else if (key.substr(0, 10) == "allocstall") {
+                counters.allocstall += value;
+            } else if (key.substr(0, 13) == "pgscan_kswapd") {
+                counters.pgscan_kswapd += value;
+            }
+        });
+        return true;
+    }
+
+    static double threadCpuMs() {
+        timespec ts;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+    }
+
+    static uint64_t detailGapMs(double cost_ms) {
+        if (SessionClock::isVirtual()) return DETAIL_MIN_MS;  //回放读的是临时文件，开销不代表真机，固定间隔保证结果可重复
+        return std::clamp(static_cast<uint64_t>(cost_ms / DETAIL_BUDGET), DETAIL_MIN_MS, DETAIL_MAX_MS);
+    }
+
+    void worker() {
+        auto start_time = SessionClock::now();
+        init_clock(interval_ms_);
+        bool has_detail = false;
+        uint64_t last_detail_ms = 0, detail_gap_ms = 0;
+        double detail_rss = 0;
+        std::vector<int> detail_pids;
+        VmCounters last_counters;
+        uint64_t last_counters_ms = 0;
+        bool has_counters = false;
+
+        while (running_) {
+            auto sample_time = SessionClock::now();
+            uint64_t timestamp =
+                std::chrono::duration_cast<std::chrono::milliseconds>(sample_time - start_time).count();
+            auto processes = threads_.processList();
+
+            std::map<std::string, ProcessMemory> memory;
+            std::vector<int> pids;
+            double rss_total = 0;
+            for (const auto& process : *processes) {
+                double rss = 0;
+                if (!readStatm(process.pid, rss)) continue;  //进程已经退出
+                memory[process.name].rss += rss;
+                rss_total += rss;
+                pids.push_back(process.pid);
+            }
+
+            uint64_t since = timestamp - last_detail_ms;
+            bool detail = !has_detail || since >= detail_gap_ms ||
+                          (since >= DETAIL_MIN_MS && (pids != detail_pids || std::fabs(rss_total - detail_rss) > detail_rss * RSS_CHANGE));
+            double available_mb = -1;
+            std::vector<std::pair<const char*, double>> rates;
+            if (detail) {
+                double cpu_before = threadCpuMs();
+                for (const auto& process : *processes) {
+                    auto it = memory.find(process.name);
+                    if (it != memory.end()) readRollup(process.pid, it->second);
+                }
+                if (!readMemAvailable(available_mb)) available_mb = -1;
+                VmCounters counters;
+                if (readVmCounters(counters)) {
+                    double elapsed_s = (timestamp - last_counters_ms) / 1000.0;
+                    auto rate = [elapsed_s](uint64_t now, uint64_t before) { return now >= before ? (now - before) / elapsed_s : 0.0; };
+                    if (has_counters && elapsed_s > 0) {
+                        rates = {{"pgfault", rate(counters.pgfault, last_counters.pgfault)},
+                                 {"pgmajfault", rate(counters.pgmajfault, last_counters.pgmajfault)},
+                                 {"allocstall", rate(counters.allocstall, last_counters.allocstall)},
+                                 {"pgscan_kswapd", rate(counters.pgscan_kswapd, last_counters.pgscan_kswapd)}};
+                    }
+                    last_counters = counters;
+                    last_counters_ms = timestamp;
+                    has_counters = true;
+                }
+                detail_gap_ms = detailGapMs(threadCpuMs() - cpu_before);
+                last_detail_ms = timestamp;
+                detail_rss = rss_total;
+                detail_pids = pids;
+                has_detail = true;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(data_mutex_);
+                size_t first_value = data_.values.size();
+                for (const auto& [name, usage] : memory) {
+                    data_.add(data_.channel("rss:" + name), usage.rss);
+                    if (!usage.rollup) continue;
+                    data_.add(data_.channel("pss:" + name), usage.pss);
+                    data_.add(data_.channel("swap:" + name), usage.swap);
+                    data_.add(data_.channel("dirty:" + name), usage.dirty);
+                }
+                if (available_mb >= 0) data_.add(data_.channel("MemAvailable"), available_mb);
+                for (const auto& [name, value] : rates) data_.add(data_.channel(name), value);
+                if (data_.values.size() > first_value) data_.commitFrame(timestamp);
+            }
+            if (!memory.empty()) latest_.store({timestamp, rss_total, true});
+            _Sleep__();
+        }
+    }
+};
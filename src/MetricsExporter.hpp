@@ -0,0 +1,419 @@
+#pragma once
+#include "LiveSample.hpp"
+#include "MonitorBase.hpp"
+#include "nlohmann/json.hpp"
+#include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <map>
+#include <memory>
+#include <netinet/in.h>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// 记录期间对外提供最新采样(--export)，供主机侧脚本抓取
+//   unix:<路径> / unix:@<名字>(抽象命名空间，可 adb forward tcp:N localabstract:名字) / tcp:<端口>(只监听127.0.0.1)
+//   GET /metrics  Prometheus文本格式
+//   GET /latest   最新一帧，一行JSON
+//   GET /stream   NDJSON流，每次刷新推送一行，直到客户端断开
+// 单线程epoll：定时器到期时从各监控器读一次快照，预先生成整份响应，原子替换后供所有请求共用；
+// 抓取频率再高也只是发送现成的缓冲区，采样线程不受影响
+
+class MetricsExporter {
+public:
+    static constexpr int TICK_MS = 500;
+    static constexpr size_t MAX_STREAM_BACKLOG = 64;  //推送积压超过这么多行的慢客户端直接断开
+
+    MetricsExporter(const std::string& address, const std::vector<std::unique_ptr<MonitorBase>>& monitors)
+        : address_(address), monitors_(monitors) {}
+
+    ~MetricsExporter() { stop(); }
+
+    bool start() {  //地址无效或端口被占用时返回false
+        listen_fd_ = openListener(address_);
+        if (listen_fd_ < 0) return false;
+
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        itimerspec tick{{0, TICK_MS * 1000000L}, {0, 1}};  //立即生成第一份
+        timerfd_settime(timer_fd_, 0, &tick, nullptr);
+        watch(listen_fd_, EPOLLIN);
+        watch(wake_fd_, EPOLLIN);
+        watch(timer_fd_, EPOLLIN);
+
+        running_ = true;
+        thread_ = std::thread(&MetricsExporter::loop, this);
+        return true;
+    }
+
+    void stop() {
+        if (!running_) return;
+        running_ = false;
+        uint64_t one = 1;
+        ssize_t ignored = ::write(wake_fd_, &one, sizeof(one));
+        (void)ignored;
+        thread_.join();
+        for (auto& [fd, client] : clients_) ::close(fd);
+        clients_.clear();
+        for (int fd : {listen_fd_, epoll_fd_, wake_fd_, timer_fd_}) ::close(fd);
+        if (!unix_path_.empty()) ::unlink(unix_path_.c_str());
+    }
+
+    // 当前的预生成响应，可以从任意线程取用
+    std::shared_ptr<const std::string> metrics() const { return std::atomic_load(&metrics_); }
+    std::shared_ptr<const std::string> latest() const { return std::atomic_load(&latest_); }
+
+private:
+    struct Client {
+        std::string request;
+        std::vector<std::shared_ptr<const std::string>> pending;  //待发送的缓冲区，共享快照不复制
+        size_t sent = 0;                                          // pending.front()已发送的字节
+        bool streaming = false;
+        bool close_after = false;  //发完就关闭
+    };
+
+    std::string address_;
+    const std::vector<std::unique_ptr<MonitorBase>>& monitors_;
+    std::string unix_path_;
+    int listen_fd_ = -1, epoll_fd_ = -1, wake_fd_ = -1, timer_fd_ = -1;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+    std::map<int, Client> clients_;
+    LiveSample sample_{};
+    std::shared_ptr<const std::string> metrics_ = std::make_shared<const std::string>();
+    std::shared_ptr<const std::string> latest_ = std::make_shared<const std::string>("{}\n");
+
+    int openListener(const std::string& address) {
+        int fd = -1;
+        if (address.rfind("tcp:", 0) == 0) {
+            const char* port_text = address.c_str() + 4;
+            char* end = nullptr;
+            errno = 0;
+            long port = std::strtol(port_text, &end, 10);
+            if (end == port_text || *end != '\0' || errno != 0 || port < 1 || port > 65535) return -1;  // 1~65535，不接受多余字符
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            addr.sin_port = htons(static_cast<uint16_t>(port));
+            fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            int reuse = 1;
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+            if (fd >= 0 && bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+                ::close(fd);
+                return -1;
+            }
+        } else if (address.rfind("unix:", 0) == 0) {
+            std::string path = address.substr(5);
+            sockaddr_un addr{};
+            addr.sun_family = AF_UNIX;
+            if (path.empty() || path.size() >= sizeof(addr.sun_path)) return -1;
+            std::memcpy(addr.sun_path, path.data(), path.size());
+            socklen_t len = offsetof(sockaddr_un, sun_path) + path.size();
+            if (path[0] == '@') {
+                addr.sun_path[0] = '\0';  //抽象命名空间，不留文件
+            } else {
+                struct stat st;
+                if (::lstat(path.c_str(), &st) == 0) {
+                    if (!S_ISSOCK(st.st_mode)) return -1;  //已有的普通文件等不能删，不启动
+                    ::unlink(path.c_str());  //上次异常退出留下的socket
+                } else if (errno != ENOENT) {
+                    return -1;
+                }
+                len += 1;
+            }
+            fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (fd >= 0 && bind(fd, reinterpret_cast<sockaddr*>(&addr), len) != 0) {
+                ::close(fd);
+                return -1;
+            }
+            if (fd >= 0 && path[0] != '@') unix_path_ = path;  //只删自己建的socket文件
+        } else {
+            return -1;
+        }
+        if (fd >= 0 && listen(fd, 16) != 0) {
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    void watch(int fd, uint32_t events) {
+        epoll_event ev{};
+        ev.events = events;
+        ev.data.fd = fd;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev);
+    }
+
+    void rewatch(int fd, uint32_t events) {
+        epoll_event ev{};
+        ev.events = events;
+        ev.data.fd = fd;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev);
+    }
+
+    void loop() {
+        epoll_event events[32];
+        while (running_) {
+            int n = epoll_wait(epoll_fd_, events, 32, -1);
+            for (int i = 0; i < n; ++i) {
+                int fd = events[i].data.fd;
+                if (fd == wake_fd_) {
+                    break;
+                } else if (fd == timer_fd_) {
+                    uint64_t expirations;
+                    while (::read(timer_fd_, &expirations, sizeof(expirations)) > 0) {
+                    }
+                    tick();
+                } else if (fd == listen_fd_) {
+                    acceptClients();
+                } else if (clients_.count(fd)) {
+                    if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                        closeClient(fd);
+                        continue;
+                    }
+                    if (events[i].events & EPOLLIN) readClient(fd);
+                    if (clients_.count(fd) && (events[i].events & EPOLLOUT)) writeClient(fd);
+                }
+            }
+        }
+    }
+
+    void tick() {  //读快照 -> 生成两种响应 -> 原子替换 -> 推送给流式客户端
+        for (auto& monitor : monitors_) monitor->readLatest(sample_);
+
+        std::atomic_store(&metrics_, std::shared_ptr<const std::string>(std::make_shared<std::string>(renderPrometheus())));
+        auto line = std::shared_ptr<const std::string>(std::make_shared<std::string>(renderJson()));
+        std::atomic_store(&latest_, line);
+
+        std::vector<int> streams;  // writeClient可能关闭连接，不能边遍历边发送
+        for (auto& [fd, client] : clients_) {
+            if (client.streaming) streams.push_back(fd);
+        }
+        for (int fd : streams) {
+            Client& client = clients_[fd];
+            if (client.pending.size() >= MAX_STREAM_BACKLOG) {
+                closeClient(fd);
+                continue;
+            }
+            client.pending.push_back(line);
+            writeClient(fd);
+        }
+    }
+
+    void acceptClients() {
+        while (true) {
+            int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) return;
+            clients_[fd] = Client{};
+            watch(fd, EPOLLIN);
+        }
+    }
+
+    void closeClient(int fd) {
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+        clients_.erase(fd);
+    }
+
+    void readClient(int fd) {
+        Client& client = clients_[fd];
+        char buf[1024];
+        while (true) {
+            ssize_t n = ::read(fd, buf, sizeof(buf));
+            if (n == 0) {
+                closeClient(fd);
+                return;
+            }
+            if (n < 0) break;
+            if (!client.streaming && client.pending.empty()) client.request.append(buf, n);
+        }
+        if (client.streaming || !client.pending.empty()) return;  //请求已处理，之后的输入忽略
+
+        if (client.request.find("\r\n\r\n") == std::string::npos && client.request.find("\n\n") == std::string::npos) {
+            if (client.request.size() > 8192) closeClient(fd);
+            return;
+        }
+        respond(fd, client);
+    }
+
+    void respond(int fd, Client& client) {
+        std::string path;
+        if (client.request.rfind("GET ", 0) == 0) {
+            path = client.request.substr(4, client.request.find(' ', 4) - 4);
+        }
+        path = path.substr(0, path.find('?'));
+
+        std::shared_ptr<const std::string> body;
+        const char* type = "text/plain; charset=utf-8";
+        if (path == "/metrics") {
+            body = metrics();
+            type = "text/plain; version=0.0.4; charset=utf-8";
+        } else if (path == "/latest") {
+            body = latest();
+            type = "application/json";
+        } else if (path == "/stream") {
+            client.streaming = true;
+            client.pending.push_back(std::make_shared<const std::string>(
+                "HTTP/1.1 200 OK\r\nContent-Type: application/x-ndjson\r\nCache-Control: no-cache\r\n"
+                "Connection: close\r\n\r\n"));
+            client.pending.push_back(latest());
+            writeClient(fd);
+            return;
+        } else {
+            body = std::make_shared<const std::string>("not found: /metrics /latest /stream\n");
+        }
+
+        char header[256];
+        snprintf(header, sizeof(header), "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+                 path == "/metrics" || path == "/latest" ? "200 OK" : "404 Not Found", type, body->size());
+        client.pending.push_back(std::make_shared<const std::string>(header));
+        client.pending.push_back(body);
+        client.close_after = true;
+        writeClient(fd);
+    }
+
+    void writeClient(int fd) {
+        Client& client = clients_[fd];
+        while (!client.pending.empty()) {
+            const std::string& front = *client.pending.front();
+            ssize_t n = ::send(fd, front.data() + client.sent, front.size() - client.sent, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    rewatch(fd, EPOLLIN | EPOLLOUT);  //等可写再继续
+                    return;
+                }
+                closeClient(fd);
+                return;
+            }
+            client.sent += n;
+            if (client.sent == front.size()) {
+                client.pending.erase(client.pending.begin());
+                client.sent = 0;
+            }
+        }
+        if (client.close_after) {
+            closeClient(fd);
+            return;
+        }
+        rewatch(fd, EPOLLIN);
+    }
+
+    static std::string escapeLabel(const char* value) {
+        std::string out;
+        for (const char* p = value; *p; ++p) {
+            if (*p == '\\' || *p == '"') out += '\\';
+            if (*p == '\n') {
+                out += "\\n";
+                continue;
+            }
+            out += *p;
+        }
+        return out;
+    }
+
+    std::string renderPrometheus() const {
+        std::string out;
+        char buf[256];
+        auto gauge = [&out](const char* name, const char* help) {
+            out += "# HELP ";
+            out += name;
+            out += ' ';
+            out += help;
+            out += "\n# TYPE ";
+            out += name;
+            out += " gauge\n";
+        };
+        auto scalar = [&](const char* name, const char* help, const LiveScalar& value) {
+            if (!value.valid) return;
+            gauge(name, help);
+            snprintf(buf, sizeof(buf), "%s %.10g\n", name, value.value);
+            out += buf;
+        };
+        auto channels = [&](const char* name, const char* help, const LiveChannels& value) {
+            if (value.count == 0) return;
+            gauge(name, help);
+            for (uint32_t c = 0; c < value.count; ++c) {
+                snprintf(buf, sizeof(buf), "%s{channel=\"%s\"} %.10g\n", name, escapeLabel(value.names[c]).c_str(),
+                         value.values[c]);
+                out += buf;
+            }
+        };
+
+        scalar("bload_fps", "Frames per second", sample_.fps);
+        scalar("bload_temperature_celsius", "Highest cpu/soc thermal zone", sample_.thermal);
+        if (sample_.power.valid) {
+            gauge("bload_power_watts", "Battery discharge power");
+            snprintf(buf, sizeof(buf), "bload_power_watts %.10g\n", sample_.power.watts);
+            out += buf;
+            out += "# HELP bload_energy_joules_total Energy drawn since the recording started\n"
+                   "# TYPE bload_energy_joules_total counter\n";
+            snprintf(buf, sizeof(buf), "bload_energy_joules_total %.10g\n", sample_.power.energy_j);
+            out += buf;
+        }
+        scalar("bload_memory_rss_megabytes", "Resident memory of the target processes", sample_.memory);
+        channels("bload_cpu_freq_khz", "Current frequency per channel", sample_.cpu_freq);
+        channels("bload_cpu_load_percent", "Load per channel", sample_.cpu_load);
+        if (sample_.thread.count > 0) {
+            gauge("bload_thread_load_percent", "Hottest threads in the latest scan");
+            for (uint32_t i = 0; i < sample_.thread.count; ++i) {
+                const auto& item = sample_.thread.items[i];
+                snprintf(buf, sizeof(buf), "bload_thread_load_percent{thread=\"%s\",tid=\"%d\",process=\"%s\"} %.10g\n",
+                         escapeLabel(item.name).c_str(), item.tid, escapeLabel(item.process).c_str(), item.load);
+                out += buf;
+            }
+        }
+
+        gauge("bload_sample_time_ms", "Recording time of the latest sample per series");
+        const std::pair<const char*, uint64_t> times[] = {{"fps", sample_.fps.time_ms},
+                                                          {"thermal", sample_.thermal.time_ms},
+                                                          {"power", sample_.power.time_ms},
+                                                          {"memory", sample_.memory.time_ms},
+                                                          {"cpu_freq", sample_.cpu_freq.time_ms},
+                                                          {"cpu_load", sample_.cpu_load.time_ms},
+                                                          {"thread", sample_.thread.time_ms}};
+        for (const auto& [series, time] : times) {
+            snprintf(buf, sizeof(buf), "bload_sample_time_ms{series=\"%s\"} %llu\n", series,
+                     static_cast<unsigned long long>(time));
+            out += buf;
+        }
+        return out;
+    }
+
+    std::string renderJson() const {  //与导出文件的字段名一致
+        nlohmann::json line;
+        if (sample_.fps.valid) line["fps"] = sample_.fps.value;
+        if (sample_.thermal.valid) line["thermal"] = sample_.thermal.value;
+        if (sample_.power.valid) {
+            line["power"] = sample_.power.watts;
+            line["energy_j"] = sample_.power.energy_j;
+        }
+        if (sample_.memory.valid) line["memory"] = sample_.memory.value;
+        for (auto [key, channels] : {std::make_pair("cpu_freq", &sample_.cpu_freq), std::make_pair("cpu_load", &sample_.cpu_load)}) {
+            nlohmann::json& out = line[key] = nlohmann::json::object();
+            for (uint32_t c = 0; c < channels->count; ++c) out[channels->names[c]] = channels->values[c];
+        }
+        nlohmann::json& threads = line["thread"] = nlohmann::json::array();
+        for (uint32_t i = 0; i < sample_.thread.count; ++i) {
+            const auto& item = sample_.thread.items[i];
+            threads.push_back({{"name", item.name}, {"tid", item.tid}, {"pid", item.pid}, {"process", item.process},
+                               {"load", item.load}});
+        }
+        line["time_ms"] = std::max({sample_.fps.time_ms, sample_.thermal.time_ms, sample_.power.time_ms, sample_.memory.time_ms,
+                                    sample_.cpu_freq.time_ms, sample_.cpu_load.time_ms, sample_.thread.time_ms});
+        return line.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace) + "\n";  //线程名可能被截断在多字节字符中间
+    }
+};
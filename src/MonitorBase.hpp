@@ -1,5 +1,8 @@
 #pragma once
-#include "nlohmann/json.hpp"
+#include "LiveSample.hpp"
+#include "ReportData.hpp"
+#include "SessionClock.hpp"
+#include "SysRoot.hpp"
 #include <string>
 #include <vector>
 #include <chrono>
@@ -15,6 +18,7 @@
 #include <mutex>
 #include <atomic>
 #include <map>
+#include <memory>
 #include <fstream>
 #include <filesystem>
 #include <time.h>
@@ -25,27 +29,39 @@ public:
     
     virtual std::string name() = 0;
     virtual bool start(const std::string& pkgName, int interval_ms = 1000) = 0;
-    virtual nlohmann::json stop() = 0;
+    virtual void stop() = 0;
+    virtual void exportTo(ReportData& report) = 0;  //停止后把采样数据移交给report
+    virtual void appendLive(ReportData& live) = 0;  //记录中途把新增的帧追加到live(实时报告)
+    virtual void readLatest(LiveSample& sample) = 0;  //最近一次采样，无锁，可随时高频调用
+    virtual void drainTo(ReportData& out) = 0;  //把已有的帧移到out，监控器自己不再保留(守护模式，内存不随时长增长)
+    virtual void retarget(const std::string& /*pkgName*/) {}  //前台应用切换，只有按包名采样的监控器需要处理
+    void halt() { running_ = false; }  //只让采样循环在下次醒来时退出，不等线程；回放时先让所有监控器停在同一时刻再stop
     
 protected:
     std::atomic<bool> running_{false};
+    std::mutex data_mutex_;  //工作线程写采样数据与appendLive读取之间互斥
     std::thread worker_thread_;
     std::chrono::steady_clock::time_point _starttime__;
     unsigned long _cycles__=0;
     int _interval_ms__=0;
 
+    // 目标包名：采样线程每次取一份快照，retarget时整体替换，不需要加锁
+    std::shared_ptr<const std::string> package_ = std::make_shared<const std::string>();
+    void setPackage(const std::string& pkgName) { std::atomic_store(&package_, std::make_shared<const std::string>(pkgName)); }
+    std::shared_ptr<const std::string> package() const { return std::atomic_load(&package_); }
+
     void init_clock(int interval_ms){
         _cycles__=0;
-        _starttime__=std::chrono::steady_clock::now();
+        _starttime__=SessionClock::now();
         _interval_ms__=interval_ms;
     }
     void _Sleep__() {
         auto nexttime=_starttime__+std::chrono::milliseconds(++_cycles__*_interval_ms__);
-        auto nowtime=std::chrono::steady_clock::now();
+        auto nowtime=SessionClock::now();
  
         while(nowtime>nexttime){
             nexttime=_starttime__+std::chrono::milliseconds(++_cycles__*_interval_ms__);
         }
-        std::this_thread::sleep_until(nexttime);
+        SessionClock::sleepUntil(nexttime);
     }
 };
\ No newline at end of file
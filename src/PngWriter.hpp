@@ -0,0 +1,406 @@
+#pragma once
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+struct RasterImage {  // 8位RGB，按行连续存放
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> pixels;
+
+    RasterImage(int w, int h, uint8_t fill = 255)
+        : width(w), height(h), pixels(static_cast<size_t>(w) * h * 3, fill) {}
+
+    uint8_t* row(int y) { return pixels.data() + static_cast<size_t>(y) * width * 3; }
+    const uint8_t* row(int y) const { return pixels.data() + static_cast<size_t>(y) * width * 3; }
+};
+
+//不依赖zlib/libpng的png编码：逐行自适应滤波 + 固定哈夫曼deflate
+//图像按行分块并行压缩，块之间用空的stored块对齐字节(同zlib的sync flush)，拼起来仍是一个合法的zlib流
+namespace png_writer {
+
+inline const std::array<uint32_t, 256>& crcTable() {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[n] = c;
+        }
+        return t;
+    }();
+    return table;
+}
+
+inline uint32_t crc32(uint32_t crc, const uint8_t* data, size_t size) {
+    const auto& table = crcTable();
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+constexpr uint32_t ADLER_BASE = 65521;
+
+inline uint32_t adler32(uint32_t adler, const uint8_t* data, size_t size) {
+    uint32_t a = adler & 0xFFFF, b = adler >> 16;
+    while (size > 0) {
+        size_t n = size < 5552 ? size : 5552;  //5552字节内不会溢出，之后再取模
+        size -= n;
+        while (n--) {
+            a += *data++;
+            b += a;
+        }
+        a %= ADLER_BASE;
+        b %= ADLER_BASE;
+    }
+    return (b << 16) | a;
+}
+
+inline uint32_t adler32Combine(uint32_t adler1, uint32_t adler2, size_t len2) {  //同zlib的adler32_combine
+    uint32_t rem = static_cast<uint32_t>(len2 % ADLER_BASE);
+    uint32_t sum1 = adler1 & 0xFFFF;
+    uint32_t sum2 = static_cast<uint32_t>((static_cast<uint64_t>(rem) * sum1) % ADLER_BASE);
+    sum1 += (adler2 & 0xFFFF) + ADLER_BASE - 1;
+    sum2 += ((adler1 >> 16) & 0xFFFF) + ((adler2 >> 16) & 0xFFFF) + ADLER_BASE - rem;
+    if (sum1 >= ADLER_BASE) sum1 -= ADLER_BASE;
+    if (sum1 >= ADLER_BASE) sum1 -= ADLER_BASE;
+    if (sum2 >= (ADLER_BASE << 1)) sum2 -= (ADLER_BASE << 1);
+    if (sum2 >= ADLER_BASE) sum2 -= ADLER_BASE;
+    return sum1 | (sum2 << 16);
+}
+
+class BitWriter {  // deflate的位序：低位先出；攒满32位再整块写出
+public:
+    explicit BitWriter(std::string& out) : out_(out) {}
+    ~BitWriter() { flushBytes(); }
+
+    void put(uint32_t value, int count) {
+        bits_ |= static_cast<uint64_t>(value) << count_;
+        count_ += count;
+        if (count_ >= 32) {
+            char word[4] = {static_cast<char>(bits_), static_cast<char>(bits_ >> 8), static_cast<char>(bits_ >> 16),
+                            static_cast<char>(bits_ >> 24)};
+            out_.append(word, 4);
+            bits_ >>= 32;
+            count_ -= 32;
+        }
+    }
+
+    void align() {  //补齐到字节边界并写出全部整字节
+        if (count_ % 8) put(0, 8 - count_ % 8);
+        flushBytes();
+    }
+
+private:
+    void flushBytes() {
+        while (count_ >= 8) {
+            out_.push_back(static_cast<char>(bits_ & 0xFF));
+            bits_ >>= 8;
+            count_ -= 8;
+        }
+    }
+
+    std::string& out_;
+    uint64_t bits_ = 0;
+    int count_ = 0;
+};
+
+struct FixedCodes {  //固定哈夫曼表，码字已按位反转好，直接put
+    struct Code {
+        uint16_t bits;
+        uint8_t length;
+    };
+    struct Extra {
+        uint16_t symbol;  //长度码的码字下标/距离码
+        uint8_t extra_bits;
+        uint16_t extra_value;
+    };
+
+    std::array<Code, 288> literal{};
+    std::array<Extra, 259> length{};   //下标为匹配长度 3..258
+    std::array<Extra, 32769> distance{};  //下标为距离 1..32768
+
+    static uint16_t reverse(uint32_t code, int length) {
+        uint32_t r = 0;
+        for (int i = 0; i < length; ++i) {
+            r = (r << 1) | (code & 1);
+            code >>= 1;
+        }
+        return static_cast<uint16_t>(r);
+    }
+
+    FixedCodes() {
+        for (uint32_t v = 0; v < 288; ++v) {
+            if (v < 144) literal[v] = {reverse(0x30 + v, 8), 8};
+            else if (v < 256) literal[v] = {reverse(0x190 + v - 144, 9), 9};
+            else if (v < 280) literal[v] = {reverse(v - 256, 7), 7};
+            else literal[v] = {reverse(0xC0 + v - 280, 8), 8};
+        }
+
+        static const uint16_t length_base[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                                 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        static const uint8_t length_extra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                                 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        for (int code = 0; code < 29; ++code) {
+            int end = code == 28 ? 259 : length_base[code] + (1 << length_extra[code]);
+            if (code == 27) end = 258;  // 258单独用285
+            for (int len = length_base[code]; len < end; ++len) {
+                length[len] = {static_cast<uint16_t>(257 + code), length_extra[code],
+                               static_cast<uint16_t>(len - length_base[code])};
+            }
+        }
+
+        static const uint16_t dist_base[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129,
+                                               193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097,
+                                               6145, 8193, 12289, 16385, 24577};
+        for (int code = 0; code < 30; ++code) {
+            int extra = code < 4 ? 0 : code / 2 - 1;
+            for (int d = dist_base[code]; d < dist_base[code] + (1 << extra) && d <= 32768; ++d) {
+                distance[d] = {reverse(code, 5), static_cast<uint8_t>(extra),
+                               static_cast<uint16_t>(d - dist_base[code])};
+            }
+        }
+    }
+
+    static const FixedCodes& get() {
+        static const FixedCodes codes;
+        return codes;
+    }
+};
+
+inline size_t matchLength(const uint8_t* a, const uint8_t* b, size_t max_len) {  //每次比较8字节
+    size_t len = 0;
+    while (len + 8 <= max_len) {
+        uint64_t x, y;
+        std::memcpy(&x, a + len, 8);
+        std::memcpy(&y, b + len, 8);
+        if (x != y) return len + (__builtin_ctzll(x ^ y) >> 3);
+        len += 8;
+    }
+    while (len < max_len && a[len] == b[len]) ++len;
+    return len;
+}
+
+// LZ77用哈希链找匹配：32K窗口，链长上限4；匹配内部的位置只在短匹配时入链(同zlib的快速档)，白底大图基本是整段匹配
+inline void deflateFixed(const uint8_t* data, size_t size, bool final, std::string& out) {
+    constexpr int HASH_BITS = 15;
+    constexpr size_t WINDOW = 32768;
+    constexpr int MAX_CHAIN = 4;
+    constexpr size_t MIN_MATCH = 3, MAX_MATCH = 258;
+    constexpr size_t INSERT_LIMIT = 4;   //不超过这个长度的匹配才把内部位置加入哈希链
+    constexpr size_t RUN_ACCEPT = 32;    //连续相同字节达到这个长度时不再查哈希链
+
+    const FixedCodes& codes = FixedCodes::get();
+    std::vector<int32_t> head(1 << HASH_BITS, -1);
+    std::vector<int32_t> prev(WINDOW, -1);
+
+    auto hash = [data](size_t i) {
+        uint32_t v = data[i] | (data[i + 1] << 8) | (data[i + 2] << 16);
+        return (v * 2654435761u) >> (32 - HASH_BITS);
+    };
+    auto insert = [&](size_t i) {
+        uint32_t h = hash(i);
+        prev[i & (WINDOW - 1)] = head[h];
+        head[h] = static_cast<int32_t>(i);
+    };
+
+    BitWriter writer(out);
+    writer.put(final ? 1 : 0, 1);
+    writer.put(1, 2);  //BTYPE=01 固定哈夫曼
+
+    size_t i = 0;
+    while (i < size) {
+        size_t best_len = 0, best_dist = 0;
+        if (i > 0 && i + MIN_MATCH <= size && data[i] == data[i - 1]) {  //滤波后的空白是成片的0，先按距离1取连续相同字节
+            size_t max_len = size - i < MAX_MATCH ? size - i : MAX_MATCH;
+            size_t run = matchLength(data + i, data + i - 1, max_len);
+            if (run >= RUN_ACCEPT) {
+                best_len = run;
+                best_dist = 1;
+            }
+        }
+        if (best_len == 0 && i + MIN_MATCH <= size) {
+            size_t max_len = size - i < MAX_MATCH ? size - i : MAX_MATCH;
+            int32_t candidate = head[hash(i)];
+            for (int chain = 0; chain < MAX_CHAIN && candidate >= 0; ++chain) {
+                size_t dist = i - candidate;
+                if (dist > WINDOW) break;
+                const uint8_t* a = data + i;
+                const uint8_t* b = data + candidate;
+                if (b[best_len] == a[best_len]) {  //先比较当前最优长度处的字节，快速排除
+                    size_t len = matchLength(a, b, max_len);
+                    if (len > best_len) {
+                        best_len = len;
+                        best_dist = dist;
+                        if (len == max_len) break;
+                    }
+                }
+                int32_t next = prev[candidate & (WINDOW - 1)];
+                if (next >= candidate) break;  //槽位已被窗口外的新位置覆盖
+                candidate = next;
+            }
+            insert(i);
+        }
+
+        if (best_len >= MIN_MATCH) {
+            const auto& len = codes.length[best_len];
+            const auto& lit = codes.literal[len.symbol];
+            writer.put(lit.bits, lit.length);
+            if (len.extra_bits) writer.put(len.extra_value, len.extra_bits);
+            const auto& dist = codes.distance[best_dist];
+            writer.put(dist.symbol, 5);
+            if (dist.extra_bits) writer.put(dist.extra_value, dist.extra_bits);
+
+            if (best_len <= INSERT_LIMIT) {
+                for (size_t k = 1; k < best_len && i + k + MIN_MATCH <= size; ++k) insert(i + k);
+            }
+            i += best_len;
+        } else {
+            const auto& lit = codes.literal[data[i]];
+            writer.put(lit.bits, lit.length);
+            ++i;
+        }
+    }
+
+    const auto& eob = codes.literal[256];
+    writer.put(eob.bits, eob.length);
+    if (!final) {  //空stored块，让下一块从字节边界开始
+        writer.put(0, 3);
+        writer.align();
+        out.append("\x00\x00\xFF\xFF", 4);
+    }
+    writer.align();
+}
+
+inline uint32_t residualCost(const uint8_t* r, size_t n) {  //残差按有符号字节取绝对值求和
+    uint32_t sum = 0;
+    for (size_t i = 0; i < n; ++i) sum += r[i] < 128 ? r[i] : 256 - r[i];
+    return sum;
+}
+
+// 每行选 None/Sub/Up/Paeth 中残差绝对值和最小的滤波器(libpng的启发式)
+// 与上一行完全相同的行(大片空白)直接用Up，残差全为0
+inline void filterRows(const RasterImage& image, int y0, int y1, std::vector<uint8_t>& out) {
+    constexpr size_t BPP = 3;
+    const size_t stride = static_cast<size_t>(image.width) * BPP;
+    out.resize((stride + 1) * (y1 - y0));
+    std::vector<uint8_t> zero(stride, 0);
+    std::vector<uint8_t> sub(stride), up_res(stride), paeth(stride);
+
+    for (int y = y0; y < y1; ++y) {
+        const uint8_t* cur = image.row(y);
+        const uint8_t* up = y > 0 ? image.row(y - 1) : zero.data();
+        uint8_t* dst = out.data() + (stride + 1) * (y - y0);
+
+        if (y > 0 && std::memcmp(cur, up, stride) == 0) {
+            dst[0] = 2;
+            std::memset(dst + 1, 0, stride);
+            continue;
+        }
+
+        for (size_t x = 0; x < BPP; ++x) {
+            sub[x] = cur[x];
+            paeth[x] = static_cast<uint8_t>(cur[x] - up[x]);  //左边没有像素时Paeth退化为Up
+        }
+        for (size_t x = BPP; x < stride; ++x) sub[x] = static_cast<uint8_t>(cur[x] - cur[x - BPP]);
+        for (size_t x = 0; x < stride; ++x) up_res[x] = static_cast<uint8_t>(cur[x] - up[x]);
+        for (size_t x = BPP; x < stride; ++x) {
+            int a = cur[x - BPP], b = up[x], c = up[x - BPP];
+            int pa = std::abs(b - c), pb = std::abs(a - c), pc = std::abs(a + b - 2 * c);
+            int predictor = (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+            paeth[x] = static_cast<uint8_t>(cur[x] - predictor);
+        }
+
+        static const uint8_t filter_type[4] = {0, 1, 2, 4};
+        const uint8_t* candidates[4] = {cur, sub.data(), up_res.data(), paeth.data()};
+        uint32_t best_cost = residualCost(cur, stride);
+        int best = 0;
+        for (int f = 1; f < 4; ++f) {
+            uint32_t cost = residualCost(candidates[f], stride);
+            if (cost < best_cost) {
+                best_cost = cost;
+                best = f;
+            }
+        }
+        dst[0] = filter_type[best];
+        std::memcpy(dst + 1, candidates[best], stride);
+    }
+}
+
+inline void appendBE32(std::string& out, uint32_t v) {
+    out.push_back(static_cast<char>(v >> 24));
+    out.push_back(static_cast<char>(v >> 16));
+    out.push_back(static_cast<char>(v >> 8));
+    out.push_back(static_cast<char>(v));
+}
+
+inline void appendChunk(std::string& out, const char* type, const std::string& data) {
+    appendBE32(out, static_cast<uint32_t>(data.size()));
+    size_t start = out.size();
+    out.append(type, 4);
+    out.append(data);
+    uint32_t crc = crc32(0, reinterpret_cast<const uint8_t*>(out.data() + start), out.size() - start);
+    appendBE32(out, crc);
+}
+
+}  // namespace png_writer
+
+// 编码为png文件内容；pool不为空时按行分块并行滤波和压缩
+inline std::string encodePng(const RasterImage& image, ThreadPool* pool = nullptr) {
+    using namespace png_writer;
+    constexpr int ROWS_PER_BLOCK = 128;
+
+    struct Block {
+        std::string deflated;
+        uint32_t adler = 1;
+        size_t raw_size = 0;
+    };
+    int block_count = (image.height + ROWS_PER_BLOCK - 1) / ROWS_PER_BLOCK;
+    std::vector<Block> blocks(block_count);
+
+    TaskGroup group(pool);
+    for (int b = 0; b < block_count; ++b) {
+        group.run([&image, &blocks, b, block_count] {
+            int y0 = b * ROWS_PER_BLOCK;
+            int y1 = std::min(image.height, y0 + ROWS_PER_BLOCK);
+            std::vector<uint8_t> filtered;
+            filterRows(image, y0, y1, filtered);
+            Block& block = blocks[b];
+            block.deflated.reserve(filtered.size() / 8 + 64);
+            deflateFixed(filtered.data(), filtered.size(), b + 1 == block_count, block.deflated);
+            block.adler = adler32(1, filtered.data(), filtered.size());
+            block.raw_size = filtered.size();
+        });
+    }
+    group.wait();
+
+    std::string idat;
+    size_t total = 6;
+    for (const auto& block : blocks) total += block.deflated.size();
+    idat.reserve(total);
+    idat.push_back(0x78);  // zlib头：deflate，32K窗口，最快压缩级别
+    idat.push_back(0x01);
+    uint32_t adler = 1;
+    for (const auto& block : blocks) {
+        idat.append(block.deflated);
+        adler = adler32Combine(adler, block.adler, block.raw_size);
+    }
+    appendBE32(idat, adler);
+
+    std::string ihdr;
+    appendBE32(ihdr, static_cast<uint32_t>(image.width));
+    appendBE32(ihdr, static_cast<uint32_t>(image.height));
+    ihdr.append("\x08\x02\x00\x00\x00", 5);  //8位，RGB，deflate，自适应滤波，不隔行
+
+    std::string png("\x89PNG\r\n\x1a\n", 8);
+    png.reserve(idat.size() + 128);
+    appendChunk(png, "IHDR", ihdr);
+    appendChunk(png, "IDAT", idat);
+    appendChunk(png, "IEND", std::string());
+    return png;
+}
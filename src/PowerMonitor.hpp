@@ -0,0 +1,204 @@
+#pragma once
+#include "MonitorBase.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+
+// 整机功耗：读电池的power_supply节点，每次采样换算成瓦(放电为正)，并累计记录开始以来的能耗
+// 单位按内核ABI：current_now μA、voltage_now μV、power_now μW、energy_now μWh
+//   有的厂商电流电压用mA/mV，只有voltage_now读数落在毫伏量级时才把这一对按mA/mV换算
+//   电流的正负号有的放电为正、有的充电为正，按status(Charging/Discharging)第一次确定后固定下来
+// 有power_now时直接用，否则用电流×电压，都没有时用energy_now(μWh)的下降量
+// 节点的fd一直开着，每次从头pread，省掉open/close
+
+class PowerMonitor : public MonitorBase {
+private:
+    struct Node {
+        std::string path;
+        int fd = -1;
+    };
+
+    Node current_, voltage_, power_, energy_, status_;
+    int sign_ = 0;  //乘上后放电为正，0为还没确定
+    ScalarSeries data_;
+    SeqLock<LivePower> latest_;
+    int interval_ms_ = 1000;
+
+public:
+    ~PowerMonitor() override {
+        for (Node* node : {&current_, &voltage_, &power_, &energy_, &status_}) {
+            if (node->fd >= 0) ::close(node->fd);
+        }
+    }
+
+    std::string name() override { return "power"; }
+
+    bool start(const std::string& /*pkgName*/, int interval_ms = 1000) override {  //找不到电池时返回false
+        interval_ms_ = interval_ms;
+        if (!discoverBattery()) return false;
+        running_ = true;
+        worker_thread_ = SessionClock::thread(&PowerMonitor::worker, this);
+        return true;
+    }
+
+    void stop() override {
+        running_ = false;
+        if (worker_thread_.joinable()) {
+            worker_thread_.join();
+        }
+    }
+
+    void exportTo(ReportData& report) override {
+        report.power = std::move(data_);
+    }
+
+    void appendLive(ReportData& live) override {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        live.power.appendFrom(data_);
+    }
+
+    void drainTo(ReportData& out) override {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        out.power.takeFrom(data_);
+    }
+
+    void readLatest(LiveSample& sample) override {
+        latest_.load(sample.power);
+    }
+
+private:
+    bool discoverBattery() {  //取第一个type为Battery、并且能算出功率的供电设备
+        std::string base = "/sys/class/power_supply";
+        DIR* dir = opendir(SysRoot::path(base).c_str());
+        if (!dir) return false;
+
+        std::vector<std::string> names;
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != nullptr) {
+            std::string name = entry->d_name;
+            if (name != "." && name != "..") names.push_back(name);
+        }
+        closedir(dir);
+        std::sort(names.begin(), names.end());
+        std::stable_partition(names.begin(), names.end(), [](const std::string& name) { return name == "battery"; });
+
+        for (const auto& name : names) {
+            std::string supply = base + "/" + name;
+            std::ifstream type_file(SysRoot::path(supply + "/type"));
+            std::string type;
+            if (!type_file || !std::getline(type_file, type) || type != "Battery") continue;
+
+            openNode(current_, supply + "/current_now");
+            openNode(voltage_, supply + "/voltage_now");
+            openNode(power_, supply + "/power_now");
+            openNode(energy_, supply + "/energy_now");
+            openNode(status_, supply + "/status");
+            if (power_.fd >= 0 || (current_.fd >= 0 && voltage_.fd >= 0) || energy_.fd >= 0) return true;
+            for (Node* node : {&current_, &voltage_, &power_, &energy_, &status_}) closeNode(*node);
+        }
+        return false;
+    }
+
+    static void openNode(Node& node, const std::string& path) {
+        node.path = SysRoot::path(path);
+        node.fd = ::open(node.path.c_str(), O_RDONLY | O_CLOEXEC);
+    }
+
+    static void closeNode(Node& node) {
+        if (node.fd >= 0) ::close(node.fd);
+        node = Node{};
+    }
+
+    static bool readText(Node& node, char* buf, size_t size) {
+        if (node.fd < 0) return false;
+        ssize_t n;
+        if (SysRoot::active()) {  //回放时节点文件整个被替换，开着的fd读到的是旧文件
+            int fd = ::open(node.path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) return false;
+            n = ::pread(fd, buf, size - 1, 0);
+            ::close(fd);
+        } else {
+            n = ::pread(node.fd, buf, size - 1, 0);
+        }
+        if (n <= 0) return false;
+        buf[n] = '\0';
+        return true;
+    }
+
+    static bool readValue(Node& node, double& value) {
+        char buf[32];
+        if (!readText(node, buf, sizeof(buf))) return false;
+        char* end = nullptr;
+        value = std::strtod(buf, &end);
+        return end != buf;
+    }
+
+    int readStatus() {  // 1放电，-1充电，0未知
+        char buf[32];
+        if (!readText(status_, buf, sizeof(buf))) return 0;
+        std::string status = buf;
+        if (status.compare(0, 11, "Discharging") == 0 || status.compare(0, 12, "Not charging") == 0) return 1;
+        if (status.compare(0, 8, "Charging") == 0) return -1;
+        return 0;
+    }
+
+    bool readWatts(double elapsed_s, double& last_energy_wh, double& watts) {
+        double value = 0;
+        if (power_.fd >= 0 && readValue(power_, value)) {
+            watts = value * 1e-6;
+        } else if (current_.fd >= 0 && voltage_.fd >= 0) {
+            double voltage = 0;
+            if (!readValue(current_, value) || !readValue(voltage_, voltage)) return false;
+            // 电池电压(单节3~4.5V，双节也不过9V左右)按μV计至少是百万量级，读数不到1e5只能是mV，电流跟着按mA算
+            double scale = std::fabs(voltage) < 1e5 ? 1e-3 : 1e-6;
+            watts = value * scale * voltage * scale;
+        } else {
+            if (!readValue(energy_, value)) return false;
+            value *= 1e-6;
+            double previous = last_energy_wh;
+            last_energy_wh = value;
+            if (previous < 0 || elapsed_s <= 0) return false;  //需要两次读数
+            watts = (previous - value) * 3600.0 / elapsed_s;
+            return true;  // energy_now下降即放电，不需要判断符号
+        }
+
+        if (sign_ == 0 && watts != 0) {  //按status确定符号；没有status节点时假定正在放电
+            int status = readStatus();
+            int discharging = status == 0 ? 1 : status;
+            sign_ = (watts > 0) == (discharging > 0) ? 1 : -1;
+        }
+        watts *= sign_ == 0 ? 1 : sign_;
+        return true;
+    }
+
+    void worker() {
+        auto start_time = SessionClock::now();
+        init_clock(interval_ms_);
+        double energy_j = 0;
+        double last_energy_wh = -1;
+        uint64_t last_time = 0;
+        bool has_last = false;
+
+        while (running_) {
+            auto sample_time = SessionClock::now();
+            uint64_t timestamp =
+                std::chrono::duration_cast<std::chrono::milliseconds>(sample_time - start_time).count();
+            double elapsed_s = has_last ? (timestamp - last_time) / 1000.0 : 0;
+
+            double watts = 0;
+            if (readWatts(elapsed_s, last_energy_wh, watts)) {
+                energy_j += watts * elapsed_s;  //每个值代表从上一次采样到现在，与帧率的统计口径一致
+                {
+                    std::lock_guard<std::mutex> lock(data_mutex_);
+                    data_.push(timestamp, watts);
+                }
+                latest_.store({timestamp, watts, energy_j, true});
+            }
+            last_time = timestamp;
+            has_last = true;
+            _Sleep__();
+        }
+    }
+};
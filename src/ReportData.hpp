@@ -0,0 +1,271 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//采样数据的类型化存储：监控器直接写入，导出文件和绘图都从这里读取
+
+class StringPool {  //字符串驻留，0号固定为空串
+public:
+    StringPool() { intern(""); }
+
+    uint32_t intern(const std::string& str) {
+        auto it = index_.find(str);
+        if (it != index_.end()) {
+            return it->second;
+        }
+        uint32_t id = static_cast<uint32_t>(strings_.size());
+        strings_.push_back(str);
+        index_.emplace(str, id);
+        return id;
+    }
+
+    const std::string& operator[](uint32_t id) const { return strings_[id]; }
+    size_t size() const { return strings_.size(); }
+
+private:
+    std::vector<std::string> strings_;
+    std::unordered_map<std::string, uint32_t> index_;
+};
+
+template <typename T>
+void eraseOutside(std::vector<T>& items, size_t first, size_t last) {  //只保留[first, last)，容量不变
+    items.erase(items.begin() + last, items.end());
+    items.erase(items.begin(), items.begin() + first);
+}
+
+struct ScalarSeries {  // fps、温度、功耗：每帧一个值
+    std::vector<uint64_t> time_ms;
+    std::vector<double> values;
+
+    void push(uint64_t time, double value) {
+        time_ms.push_back(time);
+        values.push_back(value);
+    }
+    size_t size() const { return time_ms.size(); }
+
+    void appendFrom(const ScalarSeries& src) {  //追加src中比自己多出的帧(自己是src的前缀)
+        if (size() >= src.size()) return;
+        time_ms.insert(time_ms.end(), src.time_ms.begin() + size(), src.time_ms.end());
+        values.insert(values.end(), src.values.begin() + values.size(), src.values.end());
+    }
+
+    void crop(uint64_t from, uint64_t to) {  //只保留时间在[from, to]内的帧
+        size_t first = std::lower_bound(time_ms.begin(), time_ms.end(), from) - time_ms.begin();
+        size_t last = std::max(first, static_cast<size_t>(std::upper_bound(time_ms.begin(), time_ms.end(), to) - time_ms.begin()));
+        eraseOutside(time_ms, first, last);
+        eraseOutside(values, first, last);
+    }
+
+    void takeFrom(ScalarSeries& src) {  //把src的帧全部移到末尾，src清空
+        time_ms.insert(time_ms.end(), src.time_ms.begin(), src.time_ms.end());
+        values.insert(values.end(), src.values.begin(), src.values.end());
+        src.time_ms.clear();
+        src.values.clear();
+    }
+};
+
+struct ChannelSeries {  // cpu频率、负载、内存：每帧若干个 {通道, 值}
+    struct Value {
+        uint32_t channel;
+        double value;
+    };
+
+    std::vector<std::string> channels;
+    std::vector<uint64_t> time_ms;
+    std::vector<size_t> offsets{0};  // 第i帧的值为 values[offsets[i], offsets[i+1])
+    std::vector<Value> values;
+
+    uint32_t channel(const std::string& name) {  //通道很少，线性查找即可
+        for (size_t i = 0; i < channels.size(); ++i) {
+            if (channels[i] == name) return static_cast<uint32_t>(i);
+        }
+        channels.push_back(name);
+        return static_cast<uint32_t>(channels.size() - 1);
+    }
+
+    void add(uint32_t channel, double value) { values.push_back({channel, value}); }
+
+    void commitFrame(uint64_t time) {  //把add过的值归入新的一帧
+        time_ms.push_back(time);
+        offsets.push_back(values.size());
+    }
+
+    size_t size() const { return time_ms.size(); }
+
+    void appendFrom(const ChannelSeries& src) {  //只追加已提交的帧
+        for (size_t i = channels.size(); i < src.channels.size(); ++i) channels.push_back(src.channels[i]);
+        size_t first = size();
+        if (first >= src.size()) return;
+        time_ms.insert(time_ms.end(), src.time_ms.begin() + first, src.time_ms.end());
+        values.insert(values.end(), src.values.begin() + src.offsets[first], src.values.begin() + src.offsets[src.size()]);
+        offsets.insert(offsets.end(), src.offsets.begin() + first + 1, src.offsets.begin() + src.size() + 1);
+    }
+
+    void crop(uint64_t from, uint64_t to) {
+        size_t first = std::lower_bound(time_ms.begin(), time_ms.end(), from) - time_ms.begin();
+        size_t last = std::max(first, static_cast<size_t>(std::upper_bound(time_ms.begin(), time_ms.end(), to) - time_ms.begin()));
+        size_t base = offsets[first];
+        eraseOutside(values, base, offsets[last]);
+        eraseOutside(time_ms, first, last);
+        eraseOutside(offsets, first, last + 1);
+        for (auto& offset : offsets) offset -= base;
+    }
+
+    void takeFrom(ChannelSeries& src) {  //移走src已提交的帧，还没commitFrame的值留在src
+        for (size_t i = channels.size(); i < src.channels.size(); ++i) channels.push_back(src.channels[i]);
+        size_t base = values.size();
+        size_t committed = src.offsets.back();
+        values.insert(values.end(), src.values.begin(), src.values.begin() + committed);
+        time_ms.insert(time_ms.end(), src.time_ms.begin(), src.time_ms.end());
+        for (size_t i = 1; i < src.offsets.size(); ++i) offsets.push_back(base + src.offsets[i]);
+        src.values.erase(src.values.begin(), src.values.begin() + committed);
+        src.time_ms.clear();
+        src.offsets.assign(1, 0);
+    }
+};
+
+struct ThreadSeries {  // 线程负载：帧 -> 进程 -> 线程，三层平铺存储
+    struct Thread {
+        uint32_t name;
+        int tid;
+        double load;
+        uint32_t affinity;  // Cpus_allowed_list
+        uint32_t cgroup;
+        uint32_t cpuset;
+        int uclamp_min;  // -1表示未知
+        int uclamp_max;
+    };
+
+    struct Process {
+        int pid;
+        uint32_t name;
+        size_t first_thread;
+    };
+
+    struct Frame {
+        uint64_t time_ms;
+        size_t first_process;
+    };
+
+    StringPool strings;
+    std::vector<Frame> frames;
+    std::vector<Process> processes;
+    std::vector<Thread> threads;
+
+    size_t processEnd(size_t frame_index) const {
+        return frame_index + 1 < frames.size() ? frames[frame_index + 1].first_process : processes.size();
+    }
+    size_t threadEnd(size_t process_index) const {
+        return process_index + 1 < processes.size() ? processes[process_index + 1].first_thread : threads.size();
+    }
+    size_t size() const { return frames.size(); }
+
+    void appendFrom(const ThreadSeries& src) {  //字符串池只增不减，按顺序驻留后编号与src一致
+        for (size_t id = strings.size(); id < src.strings.size(); ++id) strings.intern(src.strings[id]);
+        if (size() >= src.size()) return;
+        processes.insert(processes.end(), src.processes.begin() + processes.size(), src.processes.end());
+        threads.insert(threads.end(), src.threads.begin() + threads.size(), src.threads.end());
+        frames.insert(frames.end(), src.frames.begin() + size(), src.frames.end());
+    }
+
+    void crop(uint64_t from, uint64_t to) {
+        auto byTime = [](const Frame& frame, uint64_t time) { return frame.time_ms < time; };
+        size_t first = std::lower_bound(frames.begin(), frames.end(), from, byTime) - frames.begin();
+        size_t last = first;
+        while (last < frames.size() && frames[last].time_ms <= to) ++last;
+        if (first == last) {
+            frames.clear();
+            processes.clear();
+            threads.clear();
+            return;
+        }
+
+        size_t process_begin = frames[first].first_process, process_end = processEnd(last - 1);
+        size_t thread_begin = process_begin < processes.size() ? processes[process_begin].first_thread : threads.size();
+        size_t thread_end = process_end > process_begin ? threadEnd(process_end - 1) : thread_begin;
+        eraseOutside(threads, thread_begin, thread_end);
+        eraseOutside(processes, process_begin, process_end);
+        eraseOutside(frames, first, last);
+        for (auto& process : processes) process.first_thread -= thread_begin;
+        for (auto& frame : frames) frame.first_process -= process_begin;
+    }
+
+    // 移走src的全部帧，引用到的字符串按内容驻留到自己的池里；src不剩帧，池也清空，两边的池都不随时长增长
+    // 之后src的编号与自己不再一致，同一个src不能再用appendFrom
+    void takeFrom(ThreadSeries& src) {
+        std::vector<uint32_t> remap(src.strings.size(), UINT32_MAX);
+        auto take = [&](uint32_t id) {
+            if (remap[id] == UINT32_MAX) remap[id] = strings.intern(src.strings[id]);
+            return remap[id];
+        };
+        size_t process_base = processes.size(), thread_base = threads.size();
+        for (const auto& frame : src.frames) frames.push_back({frame.time_ms, frame.first_process + process_base});
+        for (const auto& process : src.processes) {
+            processes.push_back({process.pid, take(process.name), process.first_thread + thread_base});
+        }
+        for (Thread thread : src.threads) {
+            thread.name = take(thread.name);
+            thread.affinity = take(thread.affinity);
+            thread.cgroup = take(thread.cgroup);
+            thread.cpuset = take(thread.cpuset);
+            threads.push_back(thread);
+        }
+        src.frames.clear();
+        src.processes.clear();
+        src.threads.clear();
+        src.strings = StringPool();
+    }
+
+    void compactStrings() {  //只留还被帧引用的字符串并重新编号，crop之后调用，池的大小随窗口而不是随运行时长
+        StringPool compact;
+        std::vector<uint32_t> remap(strings.size(), UINT32_MAX);
+        auto keep = [&](uint32_t& id) {
+            if (remap[id] == UINT32_MAX) remap[id] = compact.intern(strings[id]);
+            id = remap[id];
+        };
+        for (auto& process : processes) keep(process.name);
+        for (auto& thread : threads) {
+            keep(thread.name);
+            keep(thread.affinity);
+            keep(thread.cgroup);
+            keep(thread.cpuset);
+        }
+        strings = std::move(compact);
+    }
+};
+
+struct Marker {  //标记：从这一时刻起进入名为name的区段，直到下一个标记
+    uint64_t time_ms;
+    std::string name;
+};
+
+struct ReportData {  //一次记录的全部数据，对应导出文件的顶层对象
+    std::string name;  // info
+    std::string time;
+
+    ChannelSeries cpu_freq;  // 单位同sysfs，cpu为kHz，gpu已换算
+    ChannelSeries cpu_load;
+    ScalarSeries fps;
+    ScalarSeries thermal;
+    ScalarSeries power;  // 整机功耗(W)，放电为正；没有电池节点时为空
+    ChannelSeries memory;  // 目标进程和系统的内存，通道名见MemoryMonitor.hpp
+    ThreadSeries thread;
+    std::vector<Marker> markers;
+
+    uint64_t begin_ms = 0;  // 只载入了一个时间窗口时为窗口起点
+
+    void crop(uint64_t from, uint64_t to) {  //裁剪到时间窗口，标记全部保留
+        cpu_freq.crop(from, to);
+        cpu_load.crop(from, to);
+        fps.crop(from, to);
+        thermal.crop(from, to);
+        power.crop(from, to);
+        memory.crop(from, to);
+        thread.crop(from, to);
+        begin_ms = from;
+    }
+};
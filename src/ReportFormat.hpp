@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//记录文件的存储格式，-i 读取时自动识别
+enum class ReportFormat {
+    Json,         // 缩进4格，便于阅读
+    JsonCompact,  // 无空白
+    Cbor,
+    Msgpack
+};
+
+inline bool parseReportFormat(const std::string& name, ReportFormat& format) {
+    if (name == "json") {
+        format = ReportFormat::Json;
+    } else if (name == "json-compact") {
+        format = ReportFormat::JsonCompact;
+    } else if (name == "cbor") {
+        format = ReportFormat::Cbor;
+    } else if (name == "msgpack") {
+        format = ReportFormat::Msgpack;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+inline std::string reportFileExtension(ReportFormat format) {
+    switch (format) {
+    case ReportFormat::Cbor: return ".cbor";
+    case ReportFormat::Msgpack: return ".msgpack";
+    default: return ".json";
+    }
+}
+
+// 根据首字节判断格式：记录的顶层总是对象
+// JSON以'{'开头；CBOR的map为0xa0-0xbf；MessagePack的map为0x80-0x8f/0xde/0xdf
+inline ReportFormat detectReportFormat(const std::vector<std::uint8_t>& bytes) {
+    for (std::uint8_t b : bytes) {
+        if (b == ' ' || b == '\t' || b == '\r' || b == '\n') continue;
+
+        if ((b & 0xe0) == 0xa0) return ReportFormat::Cbor;
+        if ((b & 0xf0) == 0x80 || b == 0xde || b == 0xdf) return ReportFormat::Msgpack;
+        break;
+    }
+    return ReportFormat::Json;
+}
@@ -0,0 +1,144 @@
+#pragma once
+#include "ReportFormat.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+//记录文件的时间索引(<记录>.idx)：导出时顺带写出，-i 只载入一个时间窗口时据此直接定位
+//每段记录值的字节范围；按帧存储的段每STRIDE帧记一次 {帧号, 时间, 偏移}，末尾一项指向最后一帧之后
+//json的帧偏移包含前一个逗号和缩进，读取时去掉
+//记录文件的大小和内容哈希都对得上才用索引：哈希取文件首尾各HASH_SPAN字节和每段值的起止处，
+//被同样大小的新记录覆盖时也能发现
+
+struct ReportIndex {
+    static constexpr uint32_t MAGIC = 0x49524c42;  // "BLRI"
+    static constexpr uint32_t VERSION = 2;
+    static constexpr uint32_t STRIDE = 32;
+    static constexpr uint64_t HASH_SPAN = 4096;
+
+    struct Entry {
+        uint32_t frame;
+        uint64_t time_ms;
+        uint64_t offset;
+    };
+
+    struct Section {
+        std::string name;
+        uint64_t begin = 0;  // 值的起止字节
+        uint64_t end = 0;
+        std::vector<Entry> entries;  // 只有按帧存储的段才有
+
+        void mark(size_t frame, uint64_t time_ms, uint64_t offset) {
+            if (frame % STRIDE == 0) entries.push_back({static_cast<uint32_t>(frame), time_ms, offset});
+        }
+        void finishFrames(size_t frames, uint64_t offset) {
+            entries.push_back({static_cast<uint32_t>(frames), UINT64_MAX, offset});
+        }
+    };
+
+    uint64_t file_size = 0;  // 与记录文件大小或哈希不符时说明索引过期
+    uint64_t content_hash = 0;
+    ReportFormat format = ReportFormat::Json;
+    std::vector<Section> sections;
+};
+
+inline uint64_t reportContentHash(const std::string& path, const ReportIndex& index) {  // FNV-1a，index.file_size须已填好
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return 0;
+    uint64_t hash = 1469598103934665603ULL;
+    std::string bytes;
+    bool ok = true;
+    auto hashRange = [&](uint64_t begin, uint64_t end) {
+        begin = std::min(begin, index.file_size);
+        end = std::min(std::max(begin, end), index.file_size);
+        bytes.resize(end - begin);
+        file.seekg(static_cast<std::streamoff>(begin));
+        file.read(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        ok = ok && file.good();
+        for (char c : bytes) hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ULL;
+    };
+    hashRange(0, ReportIndex::HASH_SPAN);
+    for (const auto& section : index.sections) {
+        hashRange(section.begin, section.begin + 64);
+        hashRange(section.end < 64 ? 0 : section.end - 64, section.end);
+    }
+    hashRange(index.file_size < ReportIndex::HASH_SPAN ? 0 : index.file_size - ReportIndex::HASH_SPAN, index.file_size);
+    return ok ? hash : 0;
+}
+
+inline bool writeReportIndex(const std::string& path, const ReportIndex& index) {
+    std::string out;
+    auto put = [&out](uint64_t value, int bytes) {  //小端
+        for (int i = 0; i < bytes; ++i) out.push_back(static_cast<char>((value >> (i * 8)) & 0xff));
+    };
+    put(ReportIndex::MAGIC, 4);
+    put(ReportIndex::VERSION, 4);
+    put(index.file_size, 8);
+    put(index.content_hash, 8);
+    put(static_cast<uint32_t>(index.format), 4);
+    put(index.sections.size(), 4);
+    for (const auto& section : index.sections) {
+        put(section.name.size(), 1);
+        out += section.name;
+        put(section.begin, 8);
+        put(section.end, 8);
+        put(section.entries.size(), 4);
+        for (const auto& entry : section.entries) {
+            put(entry.frame, 4);
+            put(entry.time_ms, 8);
+            put(entry.offset, 8);
+        }
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    file.write(out.data(), out.size());
+    return file.good();
+}
+
+inline bool readReportIndex(const std::string& path, ReportIndex& index) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    size_t pos = 0;
+    bool ok = true;
+    auto get = [&](int bytes) -> uint64_t {
+        if (pos + bytes > data.size()) {
+            ok = false;
+            return 0;
+        }
+        uint64_t value = 0;
+        for (int i = 0; i < bytes; ++i) value |= static_cast<uint64_t>(static_cast<uint8_t>(data[pos + i])) << (i * 8);
+        pos += bytes;
+        return value;
+    };
+
+    if (get(4) != ReportIndex::MAGIC || get(4) != ReportIndex::VERSION) return false;
+    index.file_size = get(8);
+    index.content_hash = get(8);
+    index.format = static_cast<ReportFormat>(get(4));
+    size_t sections = get(4);
+    index.sections.clear();
+    for (size_t s = 0; s < sections && ok; ++s) {
+        ReportIndex::Section section;
+        size_t name_size = get(1);
+        if (pos + name_size > data.size()) return false;
+        section.name = data.substr(pos, name_size);
+        pos += name_size;
+        section.begin = get(8);
+        section.end = get(8);
+        size_t entries = get(4);
+        if (!ok || entries > (data.size() - pos) / 20) return false;
+        section.entries.resize(entries);
+        for (auto& entry : section.entries) {
+            entry.frame = static_cast<uint32_t>(get(4));
+            entry.time_ms = get(8);
+            entry.offset = get(8);
+        }
+        index.sections.push_back(std::move(section));
+    }
+    return ok;
+}
@@ -0,0 +1,487 @@
+#pragma once
+#include "ReportData.hpp"
+#include "ReportFormat.hpp"
+#include "ReportIndex.hpp"
+#include "nlohmann/json.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//读取记录文件(json/cbor/msgpack)：SAX单遍解析，直接填充ReportData，不构建DOM
+//缺字段、类型不对的帧按旧的解析规则处理：没有time_ms的帧丢弃，数值缺失记为0
+
+class ReportSaxHandler : public nlohmann::json_sax<nlohmann::json> {
+public:
+    explicit ReportSaxHandler(ReportData& report) : report_(report) {}
+
+    bool null() override { return true; }
+    bool boolean(bool) override { return true; }
+    bool number_integer(number_integer_t value) override { return number(static_cast<double>(value), value >= 0); }
+    bool number_unsigned(number_unsigned_t value) override { return number(static_cast<double>(value), true); }
+    bool number_float(number_float_t value, const string_t&) override { return number(value, false); }
+    bool binary(binary_t&) override { return true; }
+
+    bool string(string_t& value) override {
+        if (skip_depth_ > 0 || stack_.empty()) return true;
+
+        switch (stack_.back()) {
+        case Ctx::Info:
+            if (key_ == Key::Name) report_.name = value;
+            if (key_ == Key::Time) report_.time = value;
+            break;
+        case Ctx::ChannelItem:
+            if (key_ == Key::Name) item_channel_ = channels_->channel(value);
+            break;
+        case Ctx::Process:
+            if (key_ == Key::Name) process_.name = report_.thread.strings.intern(value);
+            break;
+        case Ctx::MarkerItem:
+            if (key_ == Key::Name) marker_.name = value;
+            break;
+        case Ctx::Thread:
+            if (key_ == Key::Name) thread_.name = report_.thread.strings.intern(value);
+            if (key_ == Key::CpuSet) thread_.affinity = report_.thread.strings.intern(value);
+            if (key_ == Key::Cgroup) thread_.cgroup = report_.thread.strings.intern(value);
+            if (key_ == Key::Cpuset) thread_.cpuset = report_.thread.strings.intern(value);
+            break;
+        default:
+            break;
+        }
+        return true;
+    }
+
+    bool key(string_t& name) override {
+        if (skip_depth_ > 0) return true;
+
+        if (stack_.size() == 1) {  //顶层：各监控器的段
+            section_ = name;
+        }
+        key_ = keyOf(name);
+        return true;
+    }
+
+    bool start_object(std::size_t) override { return enter(true); }
+    bool start_array(std::size_t) override { return enter(false); }
+    bool end_object() override { return leave(); }
+    bool end_array() override { return leave(); }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::json::exception& ex) override {
+        if (auto* parse_ex = dynamic_cast<const nlohmann::json::parse_error*>(&ex)) {
+            throw *parse_ex;
+        }
+        throw std::runtime_error(ex.what());
+    }
+
+private:
+    enum class Ctx {
+        Root,
+        Info,
+        ChannelSection,  // cpu_freq / cpu_load / memory
+        ChannelFrame,
+        ChannelData,
+        ChannelItem,
+        ScalarSection,  // fps / thermal / power
+        ScalarFrame,
+        ThreadSection,
+        ThreadFrame,
+        ThreadData,
+        Process,
+        ProcessThreads,
+        Thread,
+        MarkerSection,
+        MarkerItem
+    };
+
+    enum class Key {
+        Other,
+        Data,
+        TimeMs,
+        Name,
+        Time,
+        Value,  // freq / load
+        Pid,
+        Threads,
+        Tid,
+        Load,
+        CpuSet,  // "cpu-set"
+        Cgroup,
+        Cpuset,
+        UclampMin,
+        UclampMax
+    };
+
+    ReportData& report_;
+    std::vector<Ctx> stack_;
+    int skip_depth_ = 0;  // >0 时在跳过未知的子树
+    std::string section_;
+    Key key_ = Key::Other;
+
+    ChannelSeries* channels_ = nullptr;
+    const char* value_key_ = "";
+    ScalarSeries* scalars_ = nullptr;
+
+    // 当前帧
+    bool has_time_ = false;
+    uint64_t time_ms_ = 0;
+    double scalar_value_ = 0.0;
+    size_t frame_first_value_ = 0;
+    size_t frame_first_process_ = 0;
+    size_t frame_first_thread_ = 0;
+
+    // 当前元素
+    uint32_t item_channel_ = 0;
+    double item_value_ = 0.0;
+    ThreadSeries::Process process_{};
+    ThreadSeries::Thread thread_{};
+    Marker marker_{};
+
+    Key keyOf(const std::string& name) const {
+        if (name == "data") return Key::Data;
+        if (name == "time_ms") return Key::TimeMs;
+        if (name == "name") return Key::Name;
+        if (name == "time") return Key::Time;
+        if (name == value_key_) return Key::Value;
+        if (name == "pid") return Key::Pid;
+        if (name == "threads") return Key::Threads;
+        if (name == "tid") return Key::Tid;
+        if (name == "load") return Key::Load;
+        if (name == "cpu-set") return Key::CpuSet;
+        if (name == "cgroup") return Key::Cgroup;
+        if (name == "cpuset") return Key::Cpuset;
+        if (name == "uclamp_min") return Key::UclampMin;
+        if (name == "uclamp_max") return Key::UclampMax;
+        return Key::Other;
+    }
+
+    bool number(double value, bool non_negative) {
+        if (skip_depth_ > 0 || stack_.empty()) return true;
+
+        switch (stack_.back()) {
+        case Ctx::ChannelFrame:
+        case Ctx::ScalarFrame:
+        case Ctx::ThreadFrame:
+        case Ctx::MarkerItem:
+            if (key_ == Key::TimeMs && non_negative) {
+                has_time_ = true;
+                time_ms_ = static_cast<uint64_t>(value);
+            }
+            if (key_ == Key::Data && stack_.back() == Ctx::ScalarFrame) scalar_value_ = value;
+            break;
+        case Ctx::ChannelItem:
+            if (key_ == Key::Value) item_value_ = value;
+            break;
+        case Ctx::Process:
+            if (key_ == Key::Pid) process_.pid = static_cast<int>(value);
+            break;
+        case Ctx::Thread:
+            if (key_ == Key::Tid) thread_.tid = static_cast<int>(value);
+            if (key_ == Key::Load) thread_.load = value;
+            if (key_ == Key::UclampMin) thread_.uclamp_min = static_cast<int>(value);
+            if (key_ == Key::UclampMax) thread_.uclamp_max = static_cast<int>(value);
+            break;
+        default:
+            break;
+        }
+        return true;
+    }
+
+    bool enter(bool is_object) {  //根据父节点和键决定子节点的含义
+        if (skip_depth_ > 0) {
+            ++skip_depth_;
+            return true;
+        }
+
+        Ctx next;
+        bool known = true;
+        if (stack_.empty()) {
+            next = Ctx::Root;
+            known = is_object;
+        } else {
+            switch (stack_.back()) {
+            case Ctx::Root:
+                next = sectionContext(is_object, known);
+                break;
+            case Ctx::ChannelSection:
+                next = Ctx::ChannelFrame;
+                known = is_object;
+                break;
+            case Ctx::ChannelFrame:
+                next = Ctx::ChannelData;
+                known = !is_object && key_ == Key::Data;
+                break;
+            case Ctx::ChannelData:
+                next = Ctx::ChannelItem;
+                known = is_object;
+                break;
+            case Ctx::ScalarSection:
+                next = Ctx::ScalarFrame;
+                known = is_object;
+                break;
+            case Ctx::ThreadSection:
+                next = Ctx::ThreadFrame;
+                known = is_object;
+                break;
+            case Ctx::ThreadFrame:
+                next = Ctx::ThreadData;
+                known = !is_object && key_ == Key::Data;
+                break;
+            case Ctx::ThreadData:
+                next = Ctx::Process;
+                known = is_object;
+                break;
+            case Ctx::Process:
+                next = Ctx::ProcessThreads;
+                known = !is_object && key_ == Key::Threads;
+                break;
+            case Ctx::ProcessThreads:
+                next = Ctx::Thread;
+                known = is_object;
+                break;
+            case Ctx::MarkerSection:
+                next = Ctx::MarkerItem;
+                known = is_object;
+                break;
+            default:
+                known = false;
+                break;
+            }
+        }
+
+        if (!known) {
+            skip_depth_ = 1;
+            return true;
+        }
+
+        stack_.push_back(next);
+        key_ = Key::Other;
+        switch (next) {
+        case Ctx::ChannelFrame:
+        case Ctx::ScalarFrame:
+        case Ctx::ThreadFrame:
+            has_time_ = false;
+            scalar_value_ = 0.0;
+            frame_first_value_ = channels_ ? channels_->values.size() : 0;
+            frame_first_process_ = report_.thread.processes.size();
+            frame_first_thread_ = report_.thread.threads.size();
+            break;
+        case Ctx::ChannelItem:
+            item_channel_ = UINT32_MAX;
+            item_value_ = 0.0;
+            break;
+        case Ctx::Process:
+            process_ = {0, 0, report_.thread.threads.size()};
+            break;
+        case Ctx::Thread:
+            thread_ = {0, 0, 0.0, 0, 0, 0, -1, -1};
+            break;
+        case Ctx::MarkerItem:
+            has_time_ = false;
+            marker_ = {0, ""};
+            break;
+        default:
+            break;
+        }
+        return true;
+    }
+
+    Ctx sectionContext(bool is_object, bool& known) {
+        known = true;
+        if (section_ == "info" && is_object) return Ctx::Info;
+        if (is_object) {
+            known = false;
+            return Ctx::Root;
+        }
+
+        if (section_ == "cpu_freq" || section_ == "cpu_load") {
+            channels_ = section_ == "cpu_freq" ? &report_.cpu_freq : &report_.cpu_load;
+            value_key_ = section_ == "cpu_freq" ? "freq" : "load";
+            return Ctx::ChannelSection;
+        }
+        if (section_ == "memory") {
+            channels_ = &report_.memory;
+            value_key_ = "value";
+            return Ctx::ChannelSection;
+        }
+        if (section_ == "fps" || section_ == "thermal" || section_ == "power") {
+            scalars_ = section_ == "fps" ? &report_.fps : section_ == "thermal" ? &report_.thermal : &report_.power;
+            return Ctx::ScalarSection;
+        }
+        if (section_ == "thread") return Ctx::ThreadSection;
+        if (section_ == "markers") return Ctx::MarkerSection;
+
+        known = false;
+        return Ctx::Root;
+    }
+
+    bool leave() {
+        if (skip_depth_ > 0) {
+            --skip_depth_;
+            return true;
+        }
+
+        Ctx ctx = stack_.back();
+        stack_.pop_back();
+        ThreadSeries& threads = report_.thread;
+
+        switch (ctx) {
+        case Ctx::ChannelItem:
+            if (item_channel_ == UINT32_MAX) item_channel_ = channels_->channel("unknown");
+            channels_->add(item_channel_, item_value_);
+            break;
+        case Ctx::ChannelFrame:
+            if (has_time_) {
+                channels_->commitFrame(time_ms_);
+            } else {
+                channels_->values.resize(frame_first_value_);
+            }
+            break;
+        case Ctx::ScalarFrame:
+            if (has_time_) scalars_->push(time_ms_, scalar_value_);
+            break;
+        case Ctx::Thread:
+            threads.threads.push_back(thread_);
+            break;
+        case Ctx::Process:
+            threads.processes.push_back(process_);
+            break;
+        case Ctx::MarkerItem:
+            if (has_time_) {
+                marker_.time_ms = time_ms_;
+                report_.markers.push_back(std::move(marker_));
+            }
+            break;
+        case Ctx::ThreadFrame:
+            if (has_time_) {
+                threads.frames.push_back({time_ms_, frame_first_process_});
+            } else {
+                threads.processes.resize(frame_first_process_);
+                threads.threads.resize(frame_first_thread_);
+            }
+            break;
+        case Ctx::ChannelSection:
+            channels_ = nullptr;
+            value_key_ = "";
+            break;
+        default:
+            break;
+        }
+
+        key_ = Key::Other;  //容器结束后，外层的键已经用过
+        return true;
+    }
+};
+
+// 读取记录文件，解析失败时抛出nlohmann::json::parse_error
+// 直接从文件流解析，不把整个文件读进内存
+inline ReportData loadReport(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+
+    std::vector<std::uint8_t> head(64);  //只看开头判断格式
+    file.read(reinterpret_cast<char*>(head.data()), head.size());
+    head.resize(file.gcount());
+    file.clear();
+    file.seekg(0);
+
+    nlohmann::json::input_format_t input_format = nlohmann::json::input_format_t::json;
+    switch (detectReportFormat(head)) {
+    case ReportFormat::Cbor: input_format = nlohmann::json::input_format_t::cbor; break;
+    case ReportFormat::Msgpack: input_format = nlohmann::json::input_format_t::msgpack; break;
+    default: break;
+    }
+
+    ReportData report;
+    ReportSaxHandler handler(report);
+    nlohmann::json::sax_parse(file, &handler, input_format);
+    return report;
+}
+
+// 读取记录文件中[from, to]时间窗口内的数据；marker非空时窗口改为该标记的区段(到下一个标记为止)
+// 有可用的索引时只读窗口附近的字节，否则整体载入后裁剪；找不到标记时抛出std::runtime_error
+inline ReportData loadReportWindow(const std::string& path, uint64_t from, uint64_t to, const std::string& marker = "") {
+    ReportIndex index;
+    std::error_code ec;
+    uint64_t file_size = std::filesystem::file_size(path, ec);
+    bool indexed = !ec && readReportIndex(path + ".idx", index) && index.file_size == file_size &&
+                   index.content_hash == reportContentHash(path, index);
+
+    ReportData report;
+    std::ifstream file(path, std::ios::binary);
+    auto readRange = [&file](uint64_t begin, uint64_t end) {
+        std::string bytes(end - begin, '\0');
+        file.seekg(begin);
+        file.read(bytes.data(), bytes.size());
+        return bytes;
+    };
+
+    nlohmann::json::input_format_t input_format = nlohmann::json::input_format_t::json;
+    if (index.format == ReportFormat::Cbor) input_format = nlohmann::json::input_format_t::cbor;
+    if (index.format == ReportFormat::Msgpack) input_format = nlohmann::json::input_format_t::msgpack;
+    ReportSaxHandler handler(report);
+
+    // 把一段字节包成只有一个键的顶层对象交给原来的解析器；frames>0 时bytes是若干帧，包成数组
+    auto parseSection = [&](const std::string& name, std::string bytes, size_t frames, bool is_array) {
+        std::string doc;
+        if (input_format == nlohmann::json::input_format_t::json) {
+            if (is_array) {
+                size_t first = bytes.find_first_not_of(" \t\r\n,");  //第一帧前的逗号和缩进
+                bytes.erase(0, first == std::string::npos ? bytes.size() : first);
+            }
+            doc = "{\"" + name + "\":" + (is_array ? "[" + bytes + "]" : bytes) + "}";
+        } else if (input_format == nlohmann::json::input_format_t::cbor) {
+            doc = "\xa1";
+            doc += static_cast<char>(0x60 | name.size());  //段名都短于24字节
+            doc += name;
+            doc += is_array ? "\x9f" + bytes + "\xff" : bytes;  //不定长数组
+        } else {
+            doc = "\x81";
+            doc += static_cast<char>(0xa0 | name.size());
+            doc += name;
+            if (is_array) {
+                doc += "\xdd";
+                for (int shift = 24; shift >= 0; shift -= 8) doc += static_cast<char>((frames >> shift) & 0xff);
+            }
+            doc += bytes;
+        }
+        nlohmann::json::sax_parse(doc, &handler, input_format);
+    };
+
+    if (indexed) {  //先读info和markers，确定窗口
+        for (const auto& section : index.sections) {
+            if (section.entries.empty()) parseSection(section.name, readRange(section.begin, section.end), 0, false);
+        }
+    } else {
+        report = loadReport(path);
+    }
+
+    if (!marker.empty()) {
+        auto it = std::find_if(report.markers.begin(), report.markers.end(),
+                               [&marker](const Marker& m) { return m.name == marker; });
+        if (it == report.markers.end()) {
+            throw std::runtime_error("记录中没有标记: " + marker);
+        }
+        from = it->time_ms;
+        auto next = std::next(it);
+        to = next == report.markers.end() ? UINT64_MAX : std::max(from, next->time_ms - 1);  //不含下一个标记的时刻
+    }
+
+    if (indexed) {
+        for (const auto& section : index.sections) {
+            const auto& entries = section.entries;
+            if (entries.size() < 2) continue;  //不按帧存储，或者没有帧
+
+            size_t a = 0;  //最后一个不晚于from的索引点
+            while (a + 2 < entries.size() && entries[a + 1].time_ms <= from) ++a;
+            size_t b = a + 1;  //第一个晚于to的索引点，末尾的哨兵一定满足
+            while (b + 1 < entries.size() && entries[b].time_ms <= to) ++b;
+            parseSection(section.name, readRange(entries[a].offset, entries[b].offset),
+                         entries[b].frame - entries[a].frame, true);
+        }
+    }
+
+    report.crop(from, to);
+    return report;
+}
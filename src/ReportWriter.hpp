@@ -0,0 +1,556 @@
+#pragma once
+#include "ReportData.hpp"
+#include "ReportFormat.hpp"
+#include "ReportIndex.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//流式导出：直接从ReportData写出，不构建json DOM，内存占用只有一个固定大小的缓冲区
+//键按字母序输出，与nlohmann::json(std::map)的dump结果一致
+
+class BufferedFile {  //写满即刷出的文件缓冲
+public:
+    explicit BufferedFile(const std::string& path, size_t buffer_size = 64 * 1024)
+        : file_(path, std::ios::binary), buffer_(buffer_size) {}
+
+    ~BufferedFile() { flush(); }
+
+    bool is_open() const { return file_.is_open(); }
+
+    void put(char c) {
+        if (used_ == buffer_.size()) flush();
+        buffer_[used_++] = c;
+    }
+
+    void write(const char* data, size_t size) {
+        while (size > 0) {
+            if (used_ == buffer_.size()) flush();
+            size_t n = std::min(size, buffer_.size() - used_);
+            std::memcpy(buffer_.data() + used_, data, n);
+            used_ += n;
+            data += n;
+            size -= n;
+        }
+    }
+
+    void fill(char c, size_t count) {
+        while (count-- > 0) put(c);
+    }
+
+    uint64_t position() const { return written_ + used_; }  //已写入的总字节数
+
+    bool flush() {
+        if (used_ > 0) {
+            file_.write(buffer_.data(), used_);
+            written_ += used_;
+            used_ = 0;
+        }
+        file_.flush();
+        return file_.good();
+    }
+
+private:
+    std::ofstream file_;
+    std::vector<char> buffer_;
+    size_t used_ = 0;
+    uint64_t written_ = 0;
+};
+
+class JsonEmitter {  // indent为0时输出紧凑格式
+public:
+    JsonEmitter(BufferedFile& out, int indent) : out_(out), indent_(indent) {}
+
+    uint64_t position() const { return out_.position(); }  //逗号和缩进在下一个值之前才写出，帧的偏移会带着它们
+
+    void beginObject(size_t) {
+        prefix();
+        out_.put('{');
+        first_.push_back(true);
+    }
+    void endObject() { close('}'); }
+
+    void beginArray(size_t) {
+        prefix();
+        out_.put('[');
+        first_.push_back(true);
+    }
+    void endArray() { close(']'); }
+
+    void key(const std::string& name) {
+        prefix();
+        writeString(name);
+        out_.put(':');
+        if (indent_ > 0) out_.put(' ');
+        after_key_ = true;
+    }
+
+    void string(const std::string& value) {
+        prefix();
+        writeString(value);
+    }
+
+    void integer(int64_t value) {
+        prefix();
+        char buf[24];
+        auto res = std::to_chars(buf, buf + sizeof(buf), value);
+        out_.write(buf, res.ptr - buf);
+    }
+
+    void number(double value) {
+        prefix();
+        if (!std::isfinite(value)) {  //与nlohmann一致
+            out_.write("null", 4);
+            return;
+        }
+        char buf[32];
+        auto res = std::to_chars(buf, buf + sizeof(buf), value);
+        out_.write(buf, res.ptr - buf);
+        if (std::find_if(buf, res.ptr, [](char c) { return c == '.' || c == 'e'; }) == res.ptr) {
+            out_.write(".0", 2);  //保持浮点类型
+        }
+    }
+
+private:
+    BufferedFile& out_;
+    int indent_;
+    std::vector<bool> first_;  // 每层是否还没有元素
+    bool after_key_ = false;
+
+    void newline() {
+        if (indent_ > 0) {
+            out_.put('\n');
+            out_.fill(' ', first_.size() * indent_);
+        }
+    }
+
+    void prefix() {  //值或键之前的逗号和缩进
+        if (after_key_) {
+            after_key_ = false;
+            return;
+        }
+        if (first_.empty()) return;
+        if (!first_.back()) out_.put(',');
+        first_.back() = false;
+        newline();
+    }
+
+    void close(char c) {
+        bool empty = first_.back();
+        first_.pop_back();
+        if (!empty) newline();
+        out_.put(c);
+    }
+
+    void writeString(const std::string& str) {
+        static const char hex[] = "0123456789abcdef";
+        out_.put('"');
+        for (size_t i = 0; i < str.size(); ++i) {
+            unsigned char c = static_cast<unsigned char>(str[i]);
+            switch (c) {
+            case '"': out_.write("\\\"", 2); break;
+            case '\\': out_.write("\\\\", 2); break;
+            case '\b': out_.write("\\b", 2); break;
+            case '\f': out_.write("\\f", 2); break;
+            case '\n': out_.write("\\n", 2); break;
+            case '\r': out_.write("\\r", 2); break;
+            case '\t': out_.write("\\t", 2); break;
+            default:
+                if (c < 0x20) {
+                    char esc[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf]};
+                    out_.write(esc, 6);
+                } else if (c < 0x80) {
+                    out_.put(static_cast<char>(c));
+                } else {
+                    size_t len = utf8Length(str, i);
+                    if (len == 0) {
+                        out_.write("\\ufffd", 6);  // comm截断可能留下半个字符
+                    } else {
+                        out_.write(str.data() + i, len);
+                        i += len - 1;
+                    }
+                }
+            }
+        }
+        out_.put('"');
+    }
+
+    static size_t utf8Length(const std::string& str, size_t pos) {  //合法UTF-8序列的长度，非法返回0
+        unsigned char c = static_cast<unsigned char>(str[pos]);
+        size_t len = 0;
+        if (c >= 0xc2 && c <= 0xdf) {
+            len = 2;
+        } else if (c >= 0xe0 && c <= 0xef) {
+            len = 3;
+        } else if (c >= 0xf0 && c <= 0xf4) {
+            len = 4;
+        } else {
+            return 0;
+        }
+        if (pos + len > str.size()) return 0;
+        for (size_t i = 1; i < len; ++i) {
+            if ((static_cast<unsigned char>(str[pos + i]) & 0xc0) != 0x80) return 0;
+        }
+        return len;
+    }
+};
+
+class BinaryEmitter {  // CBOR / MessagePack，容器长度由调用方给出
+public:
+    BinaryEmitter(BufferedFile& out, bool msgpack) : out_(out), msgpack_(msgpack) {}
+
+    uint64_t position() const { return out_.position(); }
+
+    void beginObject(size_t count) {
+        if (msgpack_) {
+            containerHead(count, 0x80, 0xde);
+        } else {
+            cborHead(5, count);
+        }
+    }
+    void endObject() {}
+
+    void beginArray(size_t count) {
+        if (msgpack_) {
+            containerHead(count, 0x90, 0xdc);
+        } else {
+            cborHead(4, count);
+        }
+    }
+    void endArray() {}
+
+    void key(const std::string& name) { string(name); }
+
+    void string(const std::string& value) {
+        size_t size = value.size();
+        if (!msgpack_) {
+            cborHead(3, size);
+        } else if (size < 32) {
+            out_.put(static_cast<char>(0xa0 | size));
+        } else if (size <= 0xff) {
+            out_.put(static_cast<char>(0xd9));
+            putBE(size, 1);
+        } else if (size <= 0xffff) {
+            out_.put(static_cast<char>(0xda));
+            putBE(size, 2);
+        } else {
+            out_.put(static_cast<char>(0xdb));
+            putBE(size, 4);
+        }
+        out_.write(value.data(), size);
+    }
+
+    void integer(int64_t value) {
+        if (!msgpack_) {
+            if (value >= 0) {
+                cborHead(0, static_cast<uint64_t>(value));
+            } else {
+                cborHead(1, static_cast<uint64_t>(-1 - value));
+            }
+        } else if (value >= 0) {
+            if (value < 128) {
+                out_.put(static_cast<char>(value));
+            } else if (value <= 0xff) {
+                out_.put(static_cast<char>(0xcc));
+                putBE(value, 1);
+            } else if (value <= 0xffff) {
+                out_.put(static_cast<char>(0xcd));
+                putBE(value, 2);
+            } else if (value <= 0xffffffffLL) {
+                out_.put(static_cast<char>(0xce));
+                putBE(value, 4);
+            } else {
+                out_.put(static_cast<char>(0xcf));
+                putBE(value, 8);
+            }
+        } else if (value >= -32) {
+            out_.put(static_cast<char>(value));
+        } else if (value >= INT8_MIN) {
+            out_.put(static_cast<char>(0xd0));
+            putBE(static_cast<uint64_t>(value), 1);
+        } else if (value >= INT16_MIN) {
+            out_.put(static_cast<char>(0xd1));
+            putBE(static_cast<uint64_t>(value), 2);
+        } else if (value >= INT32_MIN) {
+            out_.put(static_cast<char>(0xd2));
+            putBE(static_cast<uint64_t>(value), 4);
+        } else {
+            out_.put(static_cast<char>(0xd3));
+            putBE(static_cast<uint64_t>(value), 8);
+        }
+    }
+
+    void number(double value) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        out_.put(static_cast<char>(msgpack_ ? 0xcb : 0xfb));
+        putBE(bits, 8);
+    }
+
+private:
+    BufferedFile& out_;
+    bool msgpack_;
+
+    void putBE(uint64_t value, int bytes) {
+        for (int i = bytes - 1; i >= 0; --i) {
+            out_.put(static_cast<char>((value >> (i * 8)) & 0xff));
+        }
+    }
+
+    void cborHead(uint8_t major, uint64_t value) {
+        uint8_t type = major << 5;
+        if (value < 24) {
+            out_.put(static_cast<char>(type | value));
+        } else if (value <= 0xff) {
+            out_.put(static_cast<char>(type | 24));
+            putBE(value, 1);
+        } else if (value <= 0xffff) {
+            out_.put(static_cast<char>(type | 25));
+            putBE(value, 2);
+        } else if (value <= 0xffffffffULL) {
+            out_.put(static_cast<char>(type | 26));
+            putBE(value, 4);
+        } else {
+            out_.put(static_cast<char>(type | 27));
+            putBE(value, 8);
+        }
+    }
+
+    void containerHead(size_t count, uint8_t fix, uint8_t head16) {  // msgpack的map/array
+        if (count < 16) {
+            out_.put(static_cast<char>(fix | count));
+        } else if (count <= 0xffff) {
+            out_.put(static_cast<char>(head16));
+            putBE(count, 2);
+        } else {
+            out_.put(static_cast<char>(head16 + 1));
+            putBE(count, 4);
+        }
+    }
+};
+
+template <typename Emitter>
+void emitScalarSeries(Emitter& e, const ScalarSeries& series, bool integral, ReportIndex::Section* index) {
+    e.beginArray(series.size());
+    for (size_t i = 0; i < series.size(); ++i) {
+        if (index) index->mark(i, series.time_ms[i], e.position());
+        e.beginObject(2);
+        e.key("data");
+        if (integral) {
+            e.integer(static_cast<int64_t>(series.values[i]));
+        } else {
+            e.number(series.values[i]);
+        }
+        e.key("time_ms");
+        e.integer(series.time_ms[i]);
+        e.endObject();
+    }
+    if (index) index->finishFrames(series.size(), e.position());
+    e.endArray();
+}
+
+template <typename Emitter>
+void emitChannelSeries(Emitter& e, const ChannelSeries& series, const std::string& value_key, bool integral,
+                       ReportIndex::Section* index) {
+    e.beginArray(series.size());
+    for (size_t i = 0; i < series.size(); ++i) {
+        if (index) index->mark(i, series.time_ms[i], e.position());
+        e.beginObject(2);
+        e.key("data");
+        e.beginArray(series.offsets[i + 1] - series.offsets[i]);
+        for (size_t v = series.offsets[i]; v < series.offsets[i + 1]; ++v) {
+            e.beginObject(2);
+            e.key(value_key);
+            if (integral) {
+                e.integer(static_cast<int64_t>(series.values[v].value));
+            } else {
+                e.number(series.values[v].value);
+            }
+            e.key("name");
+            e.string(series.channels[series.values[v].channel]);
+            e.endObject();
+        }
+        e.endArray();
+        e.key("time_ms");
+        e.integer(series.time_ms[i]);
+        e.endObject();
+    }
+    if (index) index->finishFrames(series.size(), e.position());
+    e.endArray();
+}
+
+template <typename Emitter>
+void emitThreadSeries(Emitter& e, const ThreadSeries& series, ReportIndex::Section* index) {
+    e.beginArray(series.size());
+    for (size_t f = 0; f < series.size(); ++f) {
+        if (index) index->mark(f, series.frames[f].time_ms, e.position());
+        e.beginObject(2);
+        e.key("data");
+        e.beginArray(series.processEnd(f) - series.frames[f].first_process);
+        for (size_t p = series.frames[f].first_process; p < series.processEnd(f); ++p) {
+            const auto& process = series.processes[p];
+            e.beginObject(3);
+            e.key("name");
+            e.string(series.strings[process.name]);
+            e.key("pid");
+            e.integer(process.pid);
+            e.key("threads");
+            e.beginArray(series.threadEnd(p) - process.first_thread);
+            for (size_t t = process.first_thread; t < series.threadEnd(p); ++t) {
+                const auto& thread = series.threads[t];
+                bool has_uclamp = thread.uclamp_min >= 0;
+                e.beginObject(4 + (thread.cgroup != 0) + (thread.cpuset != 0) + (has_uclamp ? 2 : 0));
+                if (thread.cgroup != 0) {
+                    e.key("cgroup");
+                    e.string(series.strings[thread.cgroup]);
+                }
+                e.key("cpu-set");
+                e.string(series.strings[thread.affinity]);
+                if (thread.cpuset != 0) {
+                    e.key("cpuset");
+                    e.string(series.strings[thread.cpuset]);
+                }
+                e.key("load");
+                e.number(thread.load);
+                e.key("name");
+                e.string(series.strings[thread.name]);
+                e.key("tid");
+                e.integer(thread.tid);
+                if (has_uclamp) {
+                    e.key("uclamp_max");
+                    e.integer(thread.uclamp_max);
+                    e.key("uclamp_min");
+                    e.integer(thread.uclamp_min);
+                }
+                e.endObject();
+            }
+            e.endArray();
+            e.endObject();
+        }
+        e.endArray();
+        e.key("time_ms");
+        e.integer(series.frames[f].time_ms);
+        e.endObject();
+    }
+    if (index) index->finishFrames(series.size(), e.position());
+    e.endArray();
+}
+
+template <typename Emitter>
+void emitMarkers(Emitter& e, const std::vector<Marker>& markers) {
+    e.beginArray(markers.size());
+    for (const auto& marker : markers) {
+        e.beginObject(2);
+        e.key("name");
+        e.string(marker.name);
+        e.key("time_ms");
+        e.integer(marker.time_ms);
+        e.endObject();
+    }
+    e.endArray();
+}
+
+template <typename Emitter>
+void emitReport(Emitter& e, const ReportData& report, ReportIndex* index = nullptr) {  //顶层键按字母序，没有标记、功耗时不写这两项
+    ReportIndex::Section* section = nullptr;
+    auto beginSection = [&](const char* name) {  //记下值的起点，返回给帧序列记录偏移
+        if (!index) return;
+        index->sections.push_back({name, e.position(), 0, {}});
+        section = &index->sections.back();
+    };
+    auto endSection = [&] {
+        if (section) section->end = e.position();
+    };
+
+    e.beginObject(6 + !report.markers.empty() + !report.memory.time_ms.empty() + !report.power.time_ms.empty());
+    e.key("cpu_freq");
+    beginSection("cpu_freq");
+    emitChannelSeries(e, report.cpu_freq, "freq", true, section);
+    endSection();
+    e.key("cpu_load");
+    beginSection("cpu_load");
+    emitChannelSeries(e, report.cpu_load, "load", false, section);
+    endSection();
+    e.key("fps");
+    beginSection("fps");
+    emitScalarSeries(e, report.fps, false, section);
+    endSection();
+    e.key("info");
+    beginSection("info");
+    e.beginObject(2);
+    e.key("name");
+    e.string(report.name);
+    e.key("time");
+    e.string(report.time);
+    e.endObject();
+    endSection();
+    if (!report.markers.empty()) {
+        e.key("markers");
+        beginSection("markers");
+        emitMarkers(e, report.markers);
+        endSection();
+    }
+    if (!report.memory.time_ms.empty()) {
+        e.key("memory");
+        beginSection("memory");
+        emitChannelSeries(e, report.memory, "value", false, section);
+        endSection();
+    }
+    if (!report.power.time_ms.empty()) {
+        e.key("power");
+        beginSection("power");
+        emitScalarSeries(e, report.power, false, section);
+        endSection();
+    }
+    e.key("thermal");
+    beginSection("thermal");
+    emitScalarSeries(e, report.thermal, true, section);
+    endSection();
+    e.key("thread");
+    beginSection("thread");
+    emitThreadSeries(e, report.thread, section);
+    endSection();
+    e.endObject();
+}
+
+inline bool writeReport(const std::string& path, const ReportData& report, ReportFormat format,
+                        size_t buffer_size = 64 * 1024) {
+    BufferedFile out(path, buffer_size);
+    if (!out.is_open()) {
+        return false;
+    }
+
+    ReportIndex index;
+    switch (format) {
+    case ReportFormat::Json: {
+        JsonEmitter e(out, 4);
+        emitReport(e, report, &index);
+        break;
+    }
+    case ReportFormat::JsonCompact: {
+        JsonEmitter e(out, 0);
+        emitReport(e, report, &index);
+        break;
+    }
+    case ReportFormat::Cbor:
+    case ReportFormat::Msgpack: {
+        BinaryEmitter e(out, format == ReportFormat::Msgpack);
+        emitReport(e, report, &index);
+        break;
+    }
+    }
+    if (!out.flush()) return false;
+
+    index.file_size = out.position();
+    index.content_hash = reportContentHash(path, index);
+    index.format = format;
+    if (!writeReportIndex(path + ".idx", index)) {  //索引只用于加速窗口读取，旁边的记录文件已经完整
+        std::cerr << "无法写入索引 " << path << ".idx" << std::endl;
+    }
+    return true;
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <time.h>
+
+// 采样用的时钟：平时就是steady_clock
+// 回放(--replay)时是离散的虚拟时钟：参与的线程(主线程和SessionClock::thread启动的线程)全部睡下后，
+// 时间才直接跳到最早的唤醒时刻，同一时刻醒来的线程看到的now()完全相同，结果与机器快慢无关；
+// speed只限制跳转不超过真实时间的倍数，不影响结果
+class SessionClock {
+public:
+    using clock = std::chrono::steady_clock;
+
+    static void setSpeed(double speed) {  //切换到虚拟时钟，调用线程(主线程)算作参与者；只能在启动任何线程前调用
+        std::lock_guard<std::mutex> lock(mutex_);
+        origin_ = clock::now();
+        now_ = origin_;
+        speed_ = speed;
+        participants_ = 1;
+        participant_ = true;
+        virtual_ = true;
+    }
+
+    static bool isVirtual() { return virtual_; }
+
+    static clock::time_point now() {
+        if (!virtual_) return clock::now();
+        std::lock_guard<std::mutex> lock(mutex_);
+        return now_;
+    }
+
+    static void sleepUntil(clock::time_point time) {
+        if (!virtual_) {
+            std::this_thread::sleep_until(time);
+            return;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!participant_) {  //不参与推进时间的线程只是等
+            cv_.wait(lock, [time] { return now_ >= time; });
+            return;
+        }
+        auto wakeup = wakeups_.insert(time);
+        cv_.notify_all();  //settle()在等大家睡下
+        while (now_ < time) {
+            if (wakeups_.size() == participants_ && *wakeups_.begin() > now_) {
+                advance(lock);
+            } else {
+                cv_.wait(lock);
+            }
+        }
+        wakeups_.erase(wakeup);
+    }
+
+    template <typename Rep, typename Period>
+    static void sleepFor(std::chrono::duration<Rep, Period> duration) {
+        sleepUntil(now() + std::chrono::duration_cast<clock::duration>(duration));
+    }
+
+    static timespec monotonic() {  //同一时钟的timespec形式
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now().time_since_epoch()).count();
+        return {static_cast<time_t>(ns / 1000000000), static_cast<long>(ns % 1000000000)};
+    }
+
+    // 代替std::thread启动采样线程：虚拟时钟下新线程在启动前就计入参与者，线程结束时退出
+    template <typename F, typename... Args>
+    static std::thread thread(F&& fn, Args&&... args) {
+        bool counted = false;
+        if (virtual_) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++participants_;
+            counted = true;
+        }
+        return std::thread(
+            [counted](auto fn, auto... args) {
+                participant_ = counted;
+                std::invoke(fn, args...);
+                if (counted) leave();
+            },
+            std::forward<F>(fn), std::forward<Args>(args)...);
+    }
+
+    // 等其余参与者都睡下(都做完了当前时刻的工作)，主线程结束记录前调用
+    static void settle() {
+        if (!virtual_) return;
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [] { return wakeups_.size() + 1 >= participants_ && (wakeups_.empty() || *wakeups_.begin() > now_); });
+    }
+
+    static void leave() {  //调用线程不再参与，之后时间不再等它
+        if (!virtual_ || !participant_) return;
+        std::lock_guard<std::mutex> lock(mutex_);
+        participant_ = false;
+        --participants_;
+        cv_.notify_all();
+    }
+
+private:
+    static void advance(std::unique_lock<std::mutex>& lock) {  //所有参与者都在睡：跳到最早的唤醒时刻
+        clock::time_point target = *wakeups_.begin();
+        auto real = origin_ + std::chrono::duration_cast<clock::duration>((target - origin_) / speed_);
+        cv_.wait_until(lock, real, [] { return false; });  //倍速限制，期间不会有别的参与者醒来
+        now_ = std::max(now_, target);
+        cv_.notify_all();
+    }
+
+    inline static clock::time_point origin_{};
+    inline static double speed_ = 1.0;
+    inline static bool virtual_ = false;
+
+    inline static std::mutex mutex_;
+    inline static std::condition_variable cv_;
+    inline static clock::time_point now_{};
+    inline static std::multiset<clock::time_point> wakeups_;  //睡着的参与者各自的唤醒时刻
+    inline static size_t participants_ = 0;
+    inline static thread_local bool participant_ = false;
+};
@@ -0,0 +1,334 @@
+#pragma once
+#include "SessionClock.hpp"
+#include "SysRoot.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <dirent.h>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+// 节点快照(--snapshot)与回放(--replay)
+// 快照文件是按时间排列的增量帧，内容没变的节点不重复写：
+//   BLSNAP 1 <记录时长(秒)> <包名>
+//   T <毫秒>                 一帧开始，时间从记录开始算
+//   F <字节数> <路径>\n<内容>\n   文件内容
+//   D <字节数> <路径>\n<子目录名，每行一个>\n   目录里的子目录(进程、线程、cpuN、thermal_zoneN)
+//   X <路径>                 节点消失(进程/线程退出)
+// 快照线程每个间隔重读一遍登记过的节点，时刻错开半个间隔，避开监控器的采样时刻
+
+class SnapshotRecorder : public SysRootTracer {
+public:
+    SnapshotRecorder(const std::string& path, const std::string& package, int duration_s, int interval_ms = 1000)
+        : path_(path), package_(package), duration_s_(duration_s), interval_ms_(interval_ms) {}
+
+    ~SnapshotRecorder() override { stop(); }
+
+    bool open() {  //写文件头，监控器启动前调用
+        out_.open(path_, std::ios::binary | std::ios::trunc);
+        if (!out_) return false;
+        out_ << "BLSNAP 1 " << duration_s_ << ' ' << package_ << '\n';
+        return true;
+    }
+
+    void start(SessionClock::clock::time_point started) {  //监控器启动后调用，started与监控器同一起点
+        started_ = started;
+        running_ = true;
+        thread_ = SessionClock::thread(&SnapshotRecorder::loop, this);
+    }
+
+    void stop() {  //监控器停止后调用，最后再抓一帧
+        if (!running_) return;
+        running_ = false;
+        thread_.join();
+        capture(elapsedMs());
+        out_.close();
+    }
+
+    void touch(const std::string& path) override {
+        std::string key = path;
+        while (key.size() > 1 && key.back() == '/') key.pop_back();
+        std::lock_guard<std::mutex> lock(mutex_);
+        touched_[key] = tick_;
+    }
+
+    void put(const std::string& path, const std::string& content) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        puts_[path] = content;
+    }
+
+private:
+    void loop() {
+        auto next = started_ + std::chrono::milliseconds(interval_ms_ / 2);
+        while (running_) {
+            SessionClock::sleepUntil(next);
+            next += std::chrono::milliseconds(interval_ms_);
+            if (running_) capture(elapsedMs());
+        }
+    }
+
+    uint64_t elapsedMs() const {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(SessionClock::now() - started_).count();
+    }
+
+    // 进程、线程下的节点监控器每次都重新经过SysRoot::path()，一段时间没读就不再跟踪(回放时保留最后的内容)；
+    // 其余节点(cpufreq、thermal等)监控器只在启动时解析一次路径，一直跟踪
+    static bool isProcessNode(const std::string& path) {
+        return path.compare(0, 6, "/proc/") == 0 && path.size() > 6 && path[6] >= '0' && path[6] <= '9';
+    }
+
+    void capture(uint64_t time_ms) {
+        std::vector<std::string> paths;
+        std::map<std::string, std::string> puts;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto it = touched_.begin(); it != touched_.end();) {
+                if (isProcessNode(it->first) && it->second + EXPIRE_TICKS < tick_) {
+                    written_.erase(it->first);
+                    it = touched_.erase(it);
+                } else {
+                    paths.push_back(it->first);
+                    ++it;
+                }
+            }
+            ++tick_;
+            puts.swap(puts_);
+        }
+
+        out_ << "T " << time_ms << '\n';
+        std::string content;
+        for (const auto& path : paths) {
+            bool is_dir = false;
+            if (!readNode(SysRoot::root() + path, content, is_dir)) {  //--root时抓的是那棵目录树
+                if (written_.erase(path)) out_ << "X " << path << '\n';
+                continue;
+            }
+            emit(is_dir ? 'D' : 'F', path, content);
+        }
+        for (auto& [path, output] : puts) emit('F', path, output);
+        out_.flush();
+    }
+
+    void emit(char type, const std::string& path, const std::string& content) {
+        std::string key = std::string(1, type) + path;  //同一路径从文件变成目录时也要重写
+        auto it = written_.find(path);
+        if (it != written_.end() && it->second == key + '\0' + content) return;
+        out_ << type << ' ' << content.size() << ' ' << path << '\n';
+        out_.write(content.data(), static_cast<std::streamsize>(content.size()));
+        out_ << '\n';
+        written_[path] = key + '\0' + content;
+    }
+
+    static bool readNode(const std::string& path, std::string& content, bool& is_dir) {
+        content.clear();
+        struct stat st;
+        if (::stat(path.c_str(), &st) != 0) return false;
+        is_dir = S_ISDIR(st.st_mode);
+        if (!is_dir) {
+            std::ifstream file(path, std::ios::binary);
+            if (!file) return false;
+            std::stringstream ss;
+            ss << file.rdbuf();
+            content = ss.str();
+            return true;
+        }
+
+        DIR* dir = opendir(path.c_str());
+        if (!dir) return false;
+        std::vector<std::string> names;
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != nullptr) {
+            std::string name = entry->d_name;
+            if (name == "." || name == "..") continue;
+            bool sub_dir = entry->d_type == DT_DIR;
+            if (entry->d_type == DT_LNK || entry->d_type == DT_UNKNOWN) {  // /sys/class/thermal下是符号链接
+                struct stat sub;
+                sub_dir = ::stat((path + "/" + name).c_str(), &sub) == 0 && S_ISDIR(sub.st_mode);
+            }
+            if (sub_dir) names.push_back(std::move(name));
+        }
+        closedir(dir);
+        std::sort(names.begin(), names.end());
+        for (const auto& name : names) content += name + '\n';
+        return true;
+    }
+
+    static constexpr uint64_t EXPIRE_TICKS = 3;
+
+    std::string path_;
+    std::string package_;
+    int duration_s_;
+    int interval_ms_;
+    std::ofstream out_;
+    SessionClock::clock::time_point started_;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, uint64_t> touched_;  //路径 -> 最近一次被读时的帧号
+    std::map<std::string, std::string> puts_;
+    uint64_t tick_ = 0;
+
+    std::unordered_map<std::string, std::string> written_;  //已写进文件的内容，只有快照线程访问
+};
+
+// 回放：把快照还原到临时目录，作为SysRoot的根；第一帧在监控器启动前同步写好，
+// 之后的帧由单独的线程按虚拟时间(SessionClock)写入，文件先写到临时名再rename，监控器读不到写了一半的内容
+class ReplayDriver {
+public:
+    explicit ReplayDriver(const std::string& path) : path_(path) {}
+
+    ~ReplayDriver() {
+        stop();
+        std::error_code ec;
+        if (!root_.empty()) std::filesystem::remove_all(root_, ec);
+    }
+
+    // 读文件头，建根目录并写入第一帧
+    bool open() {
+        in_.open(path_, std::ios::binary);
+        std::string magic, version;
+        std::string line;
+        if (!in_ || !std::getline(in_, line)) return false;
+        std::istringstream header(line);
+        header >> magic >> version >> duration_s_ >> package_;
+        if (magic != "BLSNAP" || version != "1") return false;
+
+        std::error_code ec;
+        std::filesystem::path dir = std::filesystem::temp_directory_path(ec) / ("bmonitor_replay_" + std::to_string(getpid()));
+        std::filesystem::remove_all(dir, ec);
+        if (!std::filesystem::create_directories(dir, ec)) return false;
+        root_ = dir.string();
+
+        Record record;
+        if (!readRecord(record) || record.type != 'T') return false;
+        uint64_t next_ms = 0;
+        applyFrame(next_ms);
+        next_ms_ = next_ms;
+        return true;
+    }
+
+    const std::string& root() const { return root_; }
+    const std::string& package() const { return package_; }
+    int duration() const { return duration_s_; }  //记录时的-t
+
+    void start() {  //之后的帧相对于此刻的虚拟时间写入
+        started_ = SessionClock::now();
+        running_ = true;
+        thread_ = SessionClock::thread(&ReplayDriver::loop, this);
+    }
+
+    void stop() {
+        if (!running_) return;
+        running_ = false;
+        thread_.join();
+    }
+
+private:
+    struct Record {
+        char type = 0;
+        uint64_t time_ms = 0;
+        std::string path;
+        std::string content;
+    };
+
+    bool readRecord(Record& record) {
+        std::string line;
+        if (!std::getline(in_, line) || line.size() < 3 || line[1] != ' ') return false;
+        record.type = line[0];
+        record.path.clear();
+        record.content.clear();
+        if (record.type == 'T') {
+            record.time_ms = std::stoull(line.substr(2));
+            return true;
+        }
+        if (record.type == 'X') {
+            record.path = line.substr(2);
+            return true;
+        }
+        if (record.type != 'F' && record.type != 'D') return false;
+        size_t space = line.find(' ', 2);
+        if (space == std::string::npos) return false;
+        size_t size = std::stoull(line.substr(2, space - 2));
+        record.path = line.substr(space + 1);
+        record.content.resize(size);
+        in_.read(&record.content[0], static_cast<std::streamsize>(size));
+        return in_.gcount() == static_cast<std::streamsize>(size) && in_.get() == '\n';
+    }
+
+    // 应用到下一个T为止的记录，next_ms返回下一帧的时间(没有下一帧时为UINT64_MAX)
+    void applyFrame(uint64_t& next_ms) {
+        std::vector<Record> dirs, files, removed;
+        Record record;
+        next_ms = UINT64_MAX;
+        while (readRecord(record)) {
+            if (record.type == 'T') {
+                next_ms = record.time_ms;
+                break;
+            }
+            (record.type == 'D' ? dirs : record.type == 'F' ? files : removed).push_back(std::move(record));
+        }
+
+        namespace fs = std::filesystem;
+        std::error_code ec;
+        for (const auto& dir : dirs) {  //先建目录、删掉消失的子目录，再写文件
+            fs::path target = root_ + dir.path;
+            fs::create_directories(target, ec);
+            std::istringstream names(dir.content);
+            std::vector<std::string> listed;
+            std::string name;
+            while (std::getline(names, name)) {
+                listed.push_back(name);
+                fs::create_directory(target / name, ec);
+            }
+            std::sort(listed.begin(), listed.end());
+            for (const auto& entry : fs::directory_iterator(target, ec)) {
+                if (entry.is_directory(ec) &&
+                    !std::binary_search(listed.begin(), listed.end(), entry.path().filename().string())) {
+                    fs::remove_all(entry.path(), ec);
+                }
+            }
+        }
+        for (const auto& node : removed) fs::remove_all(root_ + node.path, ec);
+
+        std::string staging = root_ + "/.replay_tmp";
+        for (const auto& file : files) {
+            fs::path target = root_ + file.path;
+            fs::create_directories(target.parent_path(), ec);
+            {
+                std::ofstream out(staging, std::ios::binary | std::ios::trunc);
+                out.write(file.content.data(), static_cast<std::streamsize>(file.content.size()));
+            }
+            fs::rename(staging, target, ec);
+        }
+    }
+
+    void loop() {
+        while (running_ && next_ms_ != UINT64_MAX) {
+            SessionClock::sleepUntil(started_ + std::chrono::milliseconds(next_ms_));
+            if (!running_) break;
+            uint64_t next_ms = 0;
+            applyFrame(next_ms);
+            next_ms_ = next_ms;
+        }
+    }
+
+    std::string path_;
+    std::ifstream in_;
+    std::string package_;
+    std::string root_;
+    int duration_s_ = 0;
+    uint64_t next_ms_ = UINT64_MAX;
+    SessionClock::clock::time_point started_;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+};
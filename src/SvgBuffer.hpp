@@ -0,0 +1,64 @@
+#pragma once
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+//生成svg用的字节缓冲：预分配、只追加，数字用to_chars格式化，不经过iostream和locale
+//double默认按%g(6位有效数字)输出，与std::ostream的默认格式一致
+class SvgBuffer {
+public:
+    explicit SvgBuffer(size_t reserve_bytes = 64 * 1024) { data_.reserve(reserve_bytes); }
+
+    SvgBuffer& operator<<(std::string_view str) {
+        data_.append(str.data(), str.size());
+        return *this;
+    }
+    SvgBuffer& operator<<(const char* str) { return *this << std::string_view(str); }
+    SvgBuffer& operator<<(const std::string& str) { return *this << std::string_view(str); }
+    SvgBuffer& operator<<(char c) {
+        data_.push_back(c);
+        return *this;
+    }
+
+    SvgBuffer& operator<<(int value) { return integer(value); }
+    SvgBuffer& operator<<(long value) { return integer(value); }
+    SvgBuffer& operator<<(long long value) { return integer(value); }
+    SvgBuffer& operator<<(unsigned value) { return integer(value); }
+    SvgBuffer& operator<<(unsigned long value) { return integer(value); }
+    SvgBuffer& operator<<(unsigned long long value) { return integer(value); }
+
+    SvgBuffer& operator<<(double value) {
+        char buf[32];
+        auto res = std::to_chars(buf, buf + sizeof(buf), value, std::chars_format::general, 6);
+        data_.append(buf, res.ptr - buf);
+        return *this;
+    }
+    SvgBuffer& operator<<(float value) { return *this << static_cast<double>(value); }
+
+    SvgBuffer& fixed(double value, int precision) {  //定点小数，同std::fixed + setprecision
+        char buf[64];
+        auto res = std::to_chars(buf, buf + sizeof(buf), value, std::chars_format::fixed, precision);
+        data_.append(buf, res.ptr - buf);
+        return *this;
+    }
+
+    void reserve(size_t bytes) { data_.reserve(bytes); }
+    void clear() { data_.clear(); }  //保留容量，可以反复使用
+    size_t size() const { return data_.size(); }
+    bool empty() const { return data_.empty(); }
+    const std::string& str() const { return data_; }
+    std::string release() { return std::move(data_); }
+
+private:
+    std::string data_;
+
+    template <typename T>
+    SvgBuffer& integer(T value) {
+        char buf[24];
+        auto res = std::to_chars(buf, buf + sizeof(buf), value);
+        data_.append(buf, res.ptr - buf);
+        return *this;
+    }
+};
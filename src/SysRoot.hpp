@@ -0,0 +1,40 @@
+#pragma once
+#include <string>
+
+// 监控器读的/proc、/sys、/dev节点都经过path()：
+//   --root <目录> 或回放时拼上根目录，可以离线读一份抓取下来的节点树
+//   抓快照(--snapshot)时顺带登记读过哪些节点，由快照线程定期重读
+// 两者都没开时原样返回，不多一次分配
+
+class SysRootTracer {  //快照抓取实现这个接口
+public:
+    virtual ~SysRootTracer() = default;
+    virtual void touch(const std::string& path) = 0;                               //节点(文件或目录)被读过
+    virtual void put(const std::string& path, const std::string& content) = 0;  //命令输出等不能重读的内容
+};
+
+class SysRoot {
+public:
+    static void set(const std::string& root) {  //监控器启动前设置
+        root_ = root;
+        while (!root_.empty() && root_.back() == '/') root_.pop_back();
+    }
+    static bool active() { return !root_.empty(); }
+    static const std::string& root() { return root_; }
+
+    static void trace(SysRootTracer* tracer) { tracer_ = tracer; }  //监控器启动前设置、停止后清除
+
+    static std::string path(std::string path) {
+        if (tracer_) tracer_->touch(path);
+        if (root_.empty()) return path;
+        return root_ + path;
+    }
+
+    static void put(const std::string& path, const std::string& content) {
+        if (tracer_) tracer_->put(path, content);
+    }
+
+private:
+    inline static std::string root_;
+    inline static SysRootTracer* tracer_ = nullptr;
+};
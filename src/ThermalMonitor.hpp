@@ -6,7 +6,8 @@
 class ThermalMonitor : public MonitorBase {
 private:
     std::vector<std::string> temp_nodes_;
-    std::vector<nlohmann::json> data_;
+    ScalarSeries data_;
+    SeqLock<LiveScalar> latest_;
     int interval_ms_ = 1000;
     
 public:
@@ -16,16 +17,33 @@ public:
         interval_ms_ = interval_ms;
         discoverThermalNodes();
         running_ = true;
-        worker_thread_ = std::thread(&ThermalMonitor::worker, this);
+        worker_thread_ = SessionClock::thread(&ThermalMonitor::worker, this);
         return true;
     }
     
-    nlohmann::json stop() override {
+    void stop() override {
         running_ = false;
         if (worker_thread_.joinable()) {
             worker_thread_.join();
         }
-        return data_;
+    }
+
+    void exportTo(ReportData& report) override {
+        report.thermal = std::move(data_);
+    }
+
+    void appendLive(ReportData& live) override {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        live.thermal.appendFrom(data_);
+    }
+
+    void drainTo(ReportData& out) override {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        out.thermal.takeFrom(data_);
+    }
+
+    void readLatest(LiveSample& sample) override {
+        latest_.load(sample.thermal);
     }
     
 private:
@@ -33,7 +51,7 @@ private:
         temp_nodes_.clear();
         
         std::string thermal_base = "/sys/devices/virtual/thermal";
-        DIR* thermal_dir = opendir(thermal_base.c_str());
+        DIR* thermal_dir = opendir(SysRoot::path(thermal_base).c_str());
         if (thermal_dir) {
             struct dirent* entry;
             while ((entry = readdir(thermal_dir)) != nullptr) {
@@ -41,8 +59,8 @@ private:
                 if (dir_name == "." || dir_name == "..") continue;
                 
                 std::string device_path = thermal_base + "/" + dir_name;
-                std::string type_path = device_path + "/type";
-                std::string temp_path = device_path + "/temp";
+                std::string type_path = SysRoot::path(device_path + "/type");
+                std::string temp_path = SysRoot::path(device_path + "/temp");
                 
                 std::ifstream type_file(type_path);
                 if (!type_file) continue;
@@ -64,10 +82,10 @@ private:
     }
     
     void worker() {
-        auto start_time = std::chrono::steady_clock::now();
+        auto start_time = SessionClock::now();
         
         while (running_) {
-            auto sample_time = std::chrono::steady_clock::now();
+            auto sample_time = SessionClock::now();
             auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
                 sample_time - start_time).count();
             
@@ -93,11 +111,11 @@ private:
                 }
             }
             
-            nlohmann::json sample;
-            sample["time_ms"] = timestamp;
-            sample["data"] = max_temp;
-            
-            data_.push_back(sample);
+            {
+                std::lock_guard<std::mutex> lock(data_mutex_);
+                data_.push(timestamp, max_temp);
+            }
+            latest_.store({static_cast<uint64_t>(timestamp), static_cast<double>(max_temp), true});
             _Sleep__();
         }
     }
@@ -1,16 +1,30 @@
 #pragma once
 #include "MonitorBase.hpp"
 #include <map>
+#include <sys/syscall.h>
 #include <time.h>
 #include <unordered_set>
 
 class ThreadMonitor : public MonitorBase {  //监控所有进程
+    friend struct MonitorBench;
+
+public:
+    struct ProcessRef {
+        int pid;
+        std::string name;
+    };
+
 private:
     struct ThreadInfo {
         std::string name;
         int tid;
         double cpu_usage = 0;
         std::string affinity;
+        std::string cgroup;     // cpu控制组(cpuctl/schedtune或v2)
+        std::string cpuset;     // cpuset路径
+        int uclamp_min = -1;    // -1表示内核不支持
+        int uclamp_max = -1;
+        int classify_age = 0;   // 距上次复查分组的扫描次数
         unsigned long long last_user_time = 0;
         unsigned long long last_sys_time = 0;
         unsigned long long last_total_time = 0;
@@ -23,22 +37,39 @@ private:
         int pid;
         std::string name;
         std::map<int, ThreadInfo> threads;
+        std::string cgroup_raw;  // 上次读取的/proc/<pid>/cgroup
         bool valid = true;
         timespec last_scan_time = {0, 0};
         timespec last_change_time = {0, 0};
     };
     
-    std::string package_name_;
+    std::atomic<bool> rescan_{false};  //前台切换后下一轮立即重扫进程
     int self_pid_;
-    std::vector<nlohmann::json> data_;
+    ThreadSeries data_;
+    SeqLock<LiveThreads> latest_;
     int interval_ms_ = 1000;
     std::map<int, ProcessInfo> processes_;
     double load_threshold_ = 0.1;
     
     const long THREAD_SCAN_INTERVAL_NS = 2 * 1000000000L;
     const long MIN_SLEEP_US = 100;
+    const int CLASSIFY_REFRESH_SCANS = 5;  // 进程未迁移时，每个线程每N次扫描复查一次分组
+
+    struct SchedAttr {  // 与内核struct sched_attr (SCHED_ATTR_SIZE_VER1) 一致
+        uint32_t size;
+        uint32_t sched_policy;
+        uint64_t sched_flags;
+        int32_t sched_nice;
+        uint32_t sched_priority;
+        uint64_t sched_runtime;
+        uint64_t sched_deadline;
+        uint64_t sched_period;
+        uint32_t sched_util_min;
+        uint32_t sched_util_max;
+    };
     
     timespec last_process_scan_time_ = {0, 0};
+    std::shared_ptr<const std::vector<ProcessRef>> process_list_ = std::make_shared<const std::vector<ProcessRef>>();
     
     std::map<std::pair<int, int>, ThreadInfo> global_thread_stats_;
     
@@ -50,32 +81,57 @@ public:
     std::string name() override { return "thread"; }
     
     bool start(const std::string& pkgName, int interval_ms = 1000) override {
-        package_name_ = pkgName;
+        setPackage(pkgName);
         interval_ms_ = interval_ms;
         running_ = true;
-        worker_thread_ = std::thread(&ThreadMonitor::worker, this);
+        worker_thread_ = SessionClock::thread(&ThreadMonitor::worker, this);
         return true;
     }
     
-    nlohmann::json stop() override {
+    void stop() override {
         running_ = false;
         if (worker_thread_.joinable()) {
             worker_thread_.join();
         }
-        return data_;
+    }
+
+    void exportTo(ReportData& report) override {
+        report.thread = std::move(data_);
+    }
+
+    void appendLive(ReportData& live) override {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        live.thread.appendFrom(data_);
+    }
+
+    void drainTo(ReportData& out) override {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        out.thread.takeFrom(data_);
+    }
+
+    void readLatest(LiveSample& sample) override {
+        latest_.load(sample.thread);
+    }
+
+    void retarget(const std::string& pkgName) override {
+        setPackage(pkgName);
+        rescan_ = true;
     }
     
     void setLoadThreshold(double threshold) {
         load_threshold_ = threshold;
     }
+
+    // 最近一次扫描到的目标进程，其它按进程采样的监控器直接用，不再各自遍历/proc
+    std::shared_ptr<const std::vector<ProcessRef>> processList() const { return std::atomic_load(&process_list_); }
     
 private:
     void worker() {
-        auto start_time = std::chrono::steady_clock::now();
+        auto start_time = SessionClock::now();
         init_clock(interval_ms_);
         
         while (running_) {
-            if (shouldScanProcesses()) {
+            if (rescan_.exchange(false) || shouldScanProcesses()) {
                 ScanProcess();    //不总是扫进程
             }
             
@@ -102,7 +158,7 @@ private:
         std::vector<ProcessInfo> new_processes;
         FindProcesses(new_processes);
         
-        clock_gettime(CLOCK_MONOTONIC, &last_process_scan_time_);
+        last_process_scan_time_ = SessionClock::monotonic();
         
         std::map<int, ProcessInfo> new_process_map;
         std::unordered_set<int> current_pids;
@@ -115,18 +171,21 @@ private:
         for (auto& [pid, old_proc] : processes_) {
             if (current_pids.count(pid)) {
                 new_process_map[pid].threads = std::move(old_proc.threads);
+                new_process_map[pid].cgroup_raw = std::move(old_proc.cgroup_raw);
                 new_process_map[pid].last_scan_time = old_proc.last_scan_time;
                 new_process_map[pid].last_change_time = old_proc.last_change_time;
             }
         }
         
         processes_ = std::move(new_process_map);
-        
+
+        auto list = std::make_shared<std::vector<ProcessRef>>();
+        for (const auto& [pid, proc] : processes_) list->push_back({pid, proc.name});
+        std::atomic_store(&process_list_, std::shared_ptr<const std::vector<ProcessRef>>(std::move(list)));
     }
     
     void updateThreadsInfo() {  //更新线程数据
-        timespec current_time;
-        clock_gettime(CLOCK_MONOTONIC, &current_time);
+        timespec current_time = SessionClock::monotonic();
         static u_int8_t i=2;
         bool sc=false;
         if(++i>=2){
@@ -147,7 +206,7 @@ private:
     
     void scanAndUpdateThreads(ProcessInfo& proc, const timespec& current_time) {
         std::string task_dir = "/proc/" + std::to_string(proc.pid) + "/task/";
-        DIR* dir = opendir(task_dir.c_str());
+        DIR* dir = opendir(SysRoot::path(task_dir).c_str());
         if (!dir) {
             proc.valid = false;
             return;
@@ -155,6 +214,10 @@ private:
         
         std::unordered_set<int> current_tids;
         bool threads_changed = false;
+
+        std::string cgroup_raw = readWholeFile(SysRoot::path("/proc/" + std::to_string(proc.pid) + "/cgroup"));
+        bool proc_moved = (cgroup_raw != proc.cgroup_raw);  //整个进程被迁移，全部线程重新分组
+        proc.cgroup_raw = std::move(cgroup_raw);
         
         struct dirent* entry;
         while ((entry = readdir(dir)) != nullptr && running_) {
@@ -176,6 +239,9 @@ private:
                     if (updateThreadCPUUsage(proc.pid, tid, thread_it->second, current_time)) {
                         threads_changed = true;
                     }
+                    if (proc_moved || ++thread_it->second.classify_age >= CLASSIFY_REFRESH_SCANS) {
+                        classifyThread(proc.pid, tid, thread_it->second);
+                    }
                 }
             }
         }
@@ -209,7 +275,7 @@ private:
         
         std::string comm_path = "/proc/" + std::to_string(pid) + "/task/" + 
                                std::to_string(tid) + "/comm";
-        std::ifstream comm_file(comm_path);
+        std::ifstream comm_file(SysRoot::path(comm_path));
         if (comm_file) {
             std::getline(comm_file, thread_info.name);
             if (!thread_info.name.empty() && thread_info.name.back() == '\n') {
@@ -219,7 +285,7 @@ private:
             thread_info.name = "thread-" + std::to_string(tid);
         }
         
-        thread_info.affinity = getThreadAffinity(pid, tid);
+        classifyThread(pid, tid, thread_info);
         
         if (!readThreadStat(pid, tid, thread_info)) {
             return false;
@@ -234,7 +300,7 @@ private:
     bool readThreadStat(int pid, int tid, ThreadInfo& thread_info) {
         std::string stat_path = "/proc/" + std::to_string(pid) + "/task/" + 
                                std::to_string(tid) + "/stat";
-        std::ifstream stat_file(stat_path);
+        std::ifstream stat_file(SysRoot::path(stat_path));
         if (!stat_file) {
             return false;
         }
@@ -308,51 +374,54 @@ private:
     }
     
     void OptData(std::chrono::steady_clock::time_point starttime) { //整理数据
-        nlohmann::json sample;
-        sample["time_ms"] = std::chrono::duration_cast<std::chrono::milliseconds>(
-                std::chrono::steady_clock::now() - starttime).count();
-        sample["data"] = nlohmann::json::array();
+        uint64_t time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                SessionClock::now() - starttime).count();
         
-        bool has_data = false;
+        LiveThreads latest{};
+        latest.time_ms = time_ms;
+        std::unique_lock<std::mutex> lock(data_mutex_);
+        size_t first_process = data_.processes.size();
         
         for (const auto& [pid, proc] : processes_) {
             if (!proc.valid) continue;
             
-            nlohmann::json process_data = nlohmann::json::array();
-            int active_threads = 0;
+            size_t first_thread = data_.threads.size();
             
             for (const auto& [tid, thread] : proc.threads) {
                 if (thread.cpu_usage >= load_threshold_) {
-                    nlohmann::json thread_data;
-                    thread_data["name"] = thread.name;
-                    thread_data["tid"] = tid;
-                    thread_data["load"] = thread.cpu_usage;
-                    thread_data["cpu-set"] = thread.affinity;
-                    process_data.push_back(thread_data);
-                    active_threads++;
+                    ThreadSeries::Thread thread_data;
+                    thread_data.name = data_.strings.intern(thread.name);
+                    thread_data.tid = tid;
+                    thread_data.load = thread.cpu_usage;
+                    thread_data.affinity = data_.strings.intern(thread.affinity);
+                    thread_data.cgroup = data_.strings.intern(thread.cgroup);
+                    thread_data.cpuset = data_.strings.intern(thread.cpuset);
+                    thread_data.uclamp_min = thread.uclamp_min;
+                    thread_data.uclamp_max = thread.uclamp_max;
+                    data_.threads.push_back(thread_data);
+                    latest.offer(thread.name, proc.name, pid, tid, thread.cpu_usage);
                 }
             }
             
-            if (active_threads > 0) {
-                sample["data"].push_back({
-                    {"pid", pid},
-                    {"name", proc.name},
-                    {"threads", process_data}
-                });
-                has_data = true;
+            if (data_.threads.size() > first_thread) {
+                data_.processes.push_back({pid, data_.strings.intern(proc.name), first_thread});
             }
         }
         
-        if (has_data) {
-            data_.push_back(sample);
+        if (data_.processes.size() > first_process) {
+            data_.frames.push_back({time_ms, first_process});
         }
+        lock.unlock();
+        latest_.store(latest);
     }
     
 
     void FindProcesses(std::vector<ProcessInfo>& processes) {   //寻找进程
         processes.clear();
+        auto package = this->package();
+        const std::string& package_name = *package;
         
-        DIR* proc_dir = opendir("/proc");
+        DIR* proc_dir = opendir(SysRoot::path("/proc").c_str());
         if (!proc_dir) return;
         
         struct dirent* entry;
@@ -361,14 +430,14 @@ private:
             if (dir_name.find_first_not_of("0123456789") == std::string::npos) {
                 int pid = std::stoi(dir_name);
                 
-                if (pid == self_pid_) continue;
+                if (pid == self_pid_ && !SysRoot::active()) continue;  //读别的根目录时pid不是本机的
                 
                 ProcessInfo proc_info;
                 proc_info.pid = pid;
                 proc_info.valid = true;
                 
                 std::string comm_path = "/proc/" + dir_name + "/comm";
-                std::ifstream comm_file(comm_path);
+                std::ifstream comm_file(SysRoot::path(comm_path));
                 if (comm_file) {
                     std::getline(comm_file, proc_info.name);
 
@@ -378,7 +447,7 @@ private:
                 }
                 
                 std::string cmdline_path = "/proc/" + dir_name + "/cmdline";
-                std::ifstream cmdline_file(cmdline_path);
+                std::ifstream cmdline_file(SysRoot::path(cmdline_path));
                 if (cmdline_file) {
                     std::string cmdline;
                     std::getline(cmdline_file, cmdline);
@@ -393,12 +462,12 @@ private:
                         cmdline = cmdline.substr(last_slash + 1);
                     }
                     
-                    if (proc_info.name.find(package_name_) != std::string::npos ||
-                        cmdline.find(package_name_) != std::string::npos) {
+                    if (proc_info.name.find(package_name) != std::string::npos ||
+                        cmdline.find(package_name) != std::string::npos) {
                             processes.push_back(proc_info);
                     }
                 } else if (!proc_info.name.empty() && 
-                          proc_info.name.find(package_name_) != std::string::npos) {
+                          proc_info.name.find(package_name) != std::string::npos) {
                         processes.push_back(proc_info);
                 }
             }
@@ -407,10 +476,68 @@ private:
         closedir(proc_dir);
     }
     
+    void classifyThread(int pid, int tid, ThreadInfo& thread_info) {  //读取线程分组，结果缓存在ThreadInfo中
+        thread_info.classify_age = 0;
+        thread_info.affinity = getThreadAffinity(pid, tid);
+
+        std::string cgroup_path = "/proc/" + std::to_string(pid) + "/task/" +
+                                  std::to_string(tid) + "/cgroup";
+        std::ifstream cgroup_file(SysRoot::path(cgroup_path));
+        if (cgroup_file) {
+            std::string cpu_group;
+            std::string v2_group;
+            std::string cpuset_group;
+            std::string line;
+            while (std::getline(cgroup_file, line)) {  // 格式 id:控制器:路径
+                size_t first = line.find(':');
+                size_t second = line.find(':', first + 1);
+                if (first == std::string::npos || second == std::string::npos) continue;
+
+                std::string controllers = "," + line.substr(first + 1, second - first - 1) + ",";
+                std::string path = line.substr(second + 1);
+
+                if (controllers == ",,") {
+                    v2_group = path;
+                } else if (controllers.find(",cpuset,") != std::string::npos) {
+                    cpuset_group = path;
+                } else if (controllers.find(",cpu,") != std::string::npos ||
+                           controllers.find(",schedtune,") != std::string::npos) {
+                    cpu_group = path;
+                }
+            }
+            thread_info.cgroup = cpu_group.empty() ? v2_group : cpu_group;
+            thread_info.cpuset = cpuset_group;
+        }
+
+        getThreadUclamp(tid, thread_info.uclamp_min, thread_info.uclamp_max);
+    }
+
+    void getThreadUclamp(int tid, int& uclamp_min, int& uclamp_max) {  //读取uclamp
+        uclamp_min = -1;
+        uclamp_max = -1;
+#ifdef SYS_sched_getattr
+        if (SysRoot::active()) return;  //系统调用读的是本机线程，快照里没有
+        SchedAttr attr{};
+        if (syscall(SYS_sched_getattr, tid, &attr, sizeof(attr), 0) == 0 &&
+            attr.size >= sizeof(SchedAttr)) {  //旧内核没有util字段
+            uclamp_min = static_cast<int>(attr.sched_util_min);
+            uclamp_max = static_cast<int>(attr.sched_util_max);
+        }
+#endif
+    }
+
+    std::string readWholeFile(const std::string& path) {
+        std::ifstream file(path);
+        if (!file) return "";
+        std::stringstream ss;
+        ss << file.rdbuf();
+        return ss.str();
+    }
+
     std::string getThreadAffinity(int pid, int tid) {   //读取核心亲和性
         std::string status_path = "/proc/" + std::to_string(pid) + "/task/" + 
                                  std::to_string(tid) + "/status";
-        std::ifstream status_file(status_path);
+        std::ifstream status_file(SysRoot::path(status_path));
         if (status_file) {
             std::string line;
             while (std::getline(status_file, line)) {
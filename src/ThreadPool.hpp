@@ -0,0 +1,194 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//工作窃取线程池：每个工作线程一个队列，自己从尾部取，空闲时从别人头部偷
+//任务里可以再提交任务并等待(TaskGroup)，等待的线程会帮忙执行，不会死锁
+
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned thread_count = std::thread::hardware_concurrency()) {
+        thread_count = std::max(1u, thread_count);
+        for (unsigned i = 0; i < thread_count; ++i) {
+            queues_.push_back(std::make_unique<Queue>());
+        }
+        for (unsigned i = 0; i < thread_count; ++i) {
+            workers_.emplace_back(&ThreadPool::workerLoop, this, static_cast<int>(i));
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            stop_ = true;
+        }
+        sleep_cv_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers_.size(); }
+
+    void submit(std::function<void()> task) {
+        size_t index;
+        if (current_pool_ == this) {
+            index = worker_index_;  //工作线程提交的任务放进自己的队列
+        } else {
+            index = next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+            queues_[index]->tasks.push_back(std::move(task));
+        }
+        pending_.fetch_add(1);
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+        }
+        sleep_cv_.notify_one();
+    }
+
+    bool runPending() {  //在当前线程执行一个排队的任务，没有任务返回false
+        std::function<void()> task;
+        int index = current_pool_ == this ? worker_index_ : -1;
+        if (!take(index, task)) {
+            return false;
+        }
+        task();
+        return true;
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<size_t> pending_{0};  // 已提交还没被取走的任务数
+    std::atomic<size_t> next_queue_{0};
+    bool stop_ = false;
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cv_;
+
+    static inline thread_local ThreadPool* current_pool_ = nullptr;
+    static inline thread_local int worker_index_ = -1;
+
+    bool take(int index, std::function<void()>& task) {
+        if (pending_.load() == 0) {
+            return false;
+        }
+
+        if (index >= 0) {  //先取自己的，后进先出
+            Queue& own = *queues_[index];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                pending_.fetch_sub(1);
+                return true;
+            }
+        }
+
+        size_t start = index >= 0 ? index + 1 : 0;
+        for (size_t i = 0; i < queues_.size(); ++i) {  //再从别人的队列头部偷
+            Queue& victim = *queues_[(start + i) % queues_.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                pending_.fetch_sub(1);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void workerLoop(int index) {
+        current_pool_ = this;
+        worker_index_ = index;
+
+        while (true) {
+            std::function<void()> task;
+            if (take(index, task)) {
+                task();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            sleep_cv_.wait(lock, [this] { return stop_ || pending_.load() > 0; });
+            if (stop_ && pending_.load() == 0) {
+                return;
+            }
+        }
+    }
+};
+
+class TaskGroup {  //一组任务，wait()等待全部完成；pool为空时任务直接串行执行
+public:
+    explicit TaskGroup(ThreadPool* pool) : pool_(pool) {}
+
+    ~TaskGroup() { waitQuietly(); }
+
+    void run(std::function<void()> task) {
+        if (!pool_) {
+            task();
+            return;
+        }
+
+        remaining_.fetch_add(1);
+        pool_->submit([this, task = std::move(task)] {
+            try {
+                task();
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!error_) error_ = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(mutex_);  //解锁之后不再访问this
+            if (remaining_.fetch_sub(1) == 1) {
+                done_cv_.notify_all();
+            }
+        });
+    }
+
+    void wait() {  //第一个任务异常会在这里重新抛出
+        waitQuietly();
+        if (error_) {
+            std::exception_ptr error = error_;
+            error_ = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+
+private:
+    ThreadPool* pool_;
+    std::atomic<size_t> remaining_{0};
+    std::mutex mutex_;
+    std::condition_variable done_cv_;
+    std::exception_ptr error_;
+
+    void waitQuietly() {
+        while (remaining_.load() > 0) {
+            if (pool_->runPending()) continue;  //等待时帮忙干活
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            done_cv_.wait_for(lock, std::chrono::milliseconds(1),
+                              [this] { return remaining_.load() == 0; });
+        }
+        std::lock_guard<std::mutex> lock(mutex_);  //等最后一个任务退出临界区
+    }
+};
@@ -1,12 +1,118 @@
+#pragma once
+#include "SvgBuffer.hpp"
 #include <algorithm>
+#include <array>
+#include <charconv>
 #include <cmath>
 #include <fstream>
-#include <iomanip>
+#include <limits>
 #include <map>
 #include <set>
-#include <sstream>
 #include <string>
+#include <string_view>
+#include <tuple>
 #include <vector>
+//图表的绘制接口：布局只算一次，svg输出和位图光栅化各自实现
+//坐标为整数像素，y向下；文字坐标是基线位置
+class ChartCanvas {
+public:
+    enum class Anchor { Start, Middle, End };
+
+    virtual ~ChartCanvas() = default;
+    virtual void begin(int width, int height, const std::string& background) = 0;
+    virtual void end() = 0;
+    virtual void rect(int x, int y, int width, int height,
+                      const std::string& fill, const std::string& stroke, double stroke_width) = 0;  // fill为"none"时空心
+    virtual void line(int x1, int y1, int x2, int y2, const std::string& color, double width) = 0;
+    virtual void polyline(const std::vector<std::pair<int, int>>& points,
+                          const std::string& color, double width, double opacity) = 0;
+    virtual void polygon(const std::vector<std::pair<int, int>>& points,  //闭合填充，无描边
+                         const std::string& fill, double opacity) = 0;
+    virtual void text(int x, int y, int font_size, const std::string& color, std::string_view str,
+                      Anchor anchor = Anchor::Start, bool bold = false) = 0;
+};
+
+class SvgCanvas : public ChartCanvas {  //写成svg元素；standalone为false时用于嵌入文档，不带xml声明
+public:
+    SvgCanvas(SvgBuffer& out, bool standalone) : svg(out), standalone_(standalone) {}
+
+    void begin(int width, int height, const std::string& background) override {
+        if (standalone_) {
+            svg << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+        } else {
+            svg << '\n';  //嵌入时去掉xml声明，保留其后的换行
+        }
+        svg << "<svg width=\"" << width << "\" height=\"" << height
+            << "\" xmlns=\"http://www.w3.org/2000/svg\">\n";
+
+        svg << "  <rect width=\"100%\" height=\"100%\" fill=\"" << background << "\"/>\n";
+    }
+
+    void end() override { svg << "</svg>"; }
+
+    void rect(int x, int y, int width, int height,
+              const std::string& fill, const std::string& stroke, double stroke_width) override {
+        svg << "  <rect x=\"" << x << "\" y=\"" << y
+            << "\" width=\"" << width << "\" height=\"" << height
+            << "\" fill=\"" << fill << "\" stroke=\"" << stroke
+            << "\" stroke-width=\"" << stroke_width << "\"/>\n";
+    }
+
+    void line(int x1, int y1, int x2, int y2, const std::string& color, double width) override {
+        svg << "  <line x1=\"" << x1 << "\" y1=\"" << y1
+            << "\" x2=\"" << x2 << "\" y2=\"" << y2
+            << "\" stroke=\"" << color
+            << "\" stroke-width=\"" << width << "\"/>\n";
+    }
+
+    void polyline(const std::vector<std::pair<int, int>>& points,
+                  const std::string& color, double width, double opacity) override {
+        svg << "  <path d=\"M ";  //路径直接写进缓冲，不再单独拼接
+        for (size_t i = 0; i < points.size(); ++i) {
+            if (i != 0) svg << " L ";
+            svg << points[i].first << ' ' << points[i].second;
+        }
+
+        svg << "\" fill=\"none\" stroke=\""
+            << color << "\" stroke-width=\"" << width << "\" stroke-opacity=\"" << opacity << "\"/>\n";
+    }
+
+    void polygon(const std::vector<std::pair<int, int>>& points,
+                 const std::string& fill, double opacity) override {
+        if (points.empty()) return;
+        svg << "  <path d=\"M ";
+        for (size_t i = 0; i < points.size(); ++i) {
+            if (i != 0) svg << " L ";
+            svg << points[i].first << ' ' << points[i].second;
+        }
+        svg << " Z\" fill=\"" << fill << "\" fill-opacity=\"" << opacity << "\" stroke=\"none\"/>\n";
+    }
+
+    void text(int x, int y, int font_size, const std::string& color, std::string_view str,
+              Anchor anchor, bool bold) override {
+        svg << "  <text x=\"" << x << "\" y=\"" << y << "\" font-size=\"" << font_size << '"';
+        if (bold) svg << " font-weight=\"bold\"";
+        if (anchor == Anchor::Middle) svg << " text-anchor=\"middle\"";
+        if (anchor == Anchor::End) svg << " text-anchor=\"end\"";
+        svg << " fill=\"" << color << "\">";
+        if (str.find_first_of("<>&") == std::string_view::npos) {  //标记名等外部输入才可能带这些字符
+            svg << str;
+        } else {
+            for (char c : str) {
+                if (c == '<') svg << "&lt;";
+                else if (c == '>') svg << "&gt;";
+                else if (c == '&') svg << "&amp;";
+                else svg << c;
+            }
+        }
+        svg << "</text>\n";
+    }
+
+private:
+    SvgBuffer& svg;
+    bool standalone_;
+};
+
 //用于将数据画成折线图，svg格式
 //最早是画频率图的，改改用来画别的。变量名懒得改了
 class SVGFreqPlotter {
@@ -16,6 +122,106 @@ public:
         std::map<std::string, float> frequencies;
     };
 
+    struct SparseSeries {  //稀疏序列：只按段存储有采样的帧，段外的帧按hold补值
+        struct Segment {
+            uint32_t first_frame;
+            uint32_t count;
+            uint32_t offset;  // 在values中的起点
+        };
+        std::vector<Segment> segments;
+        std::vector<float> values;
+        bool hold = false;  // 缺失的帧沿用上一个值，否则为0
+
+        void push(uint32_t frame, float value) {  //帧号递增，同一帧重复时后者覆盖
+            if (!segments.empty()) {
+                Segment& last = segments.back();
+                if (last.first_frame + last.count == frame + 1) {
+                    values.back() = value;
+                    return;
+                }
+                if (last.first_frame + last.count == frame) {
+                    ++last.count;
+                    values.push_back(value);
+                    return;
+                }
+            }
+            segments.push_back({frame, 1, static_cast<uint32_t>(values.size())});
+            values.push_back(value);
+        }
+
+        template <typename Fn>
+        void forEach(size_t frame_count, Fn&& fn) const {  //按帧展开，fn(帧号, 值)
+            float gap = 0.0f;
+            size_t i = 0;
+            for (const auto& seg : segments) {
+                for (; i < seg.first_frame; ++i) fn(i, gap);
+                for (uint32_t k = 0; k < seg.count; ++k, ++i) fn(i, values[seg.offset + k]);
+                if (hold) gap = values[seg.offset + seg.count - 1];
+            }
+            for (; i < frame_count; ++i) fn(i, gap);
+        }
+
+        template <typename Fn>
+        void forEach(size_t begin, size_t end, Fn&& fn) const {  //只展开[begin, end)，补值与完整展开一致
+            auto it = std::upper_bound(segments.begin(), segments.end(), begin,
+                                       [](size_t frame, const Segment& seg) { return frame < seg.first_frame + seg.count; });
+            float gap = 0.0f;
+            if (hold && it != segments.begin()) {
+                const Segment& prev = *(it - 1);
+                gap = values[prev.offset + prev.count - 1];
+            }
+            size_t i = begin;
+            for (; it != segments.end() && i < end; ++it) {
+                const Segment& seg = *it;
+                for (; i < seg.first_frame && i < end; ++i) fn(i, gap);
+                for (; i < seg.first_frame + seg.count && i < end; ++i) fn(i, values[seg.offset + (i - seg.first_frame)]);
+                if (hold) gap = values[seg.offset + seg.count - 1];
+            }
+            for (; i < end; ++i) fn(i, gap);
+        }
+
+        float sum() const {
+            float total = 0.0f;
+            for (float value : values) total += value;
+            return total;
+        }
+    };
+
+    struct SeriesData {  //共享时间轴的多条稀疏序列
+        std::vector<uint64_t> time_ms;
+        std::map<std::string, SparseSeries> series;
+    };
+
+    // 实时报告用：跨多次绘制缓存每条折线的统计值和已定稿的抽稀结果
+    // 数据只在尾部追加，坐标映射不变时每次只处理新增的帧；映射变化或数据被改写时重算
+    struct PathCache {
+        struct Entry {
+            size_t frames = 0;       // 已统计过的帧数
+            uint64_t last_time = 0;  // 第frames-1帧的时间，不一致说明数据不是在尾部追加
+            float min_val = std::numeric_limits<float>::max();
+            float max_val = std::numeric_limits<float>::lowest();
+            size_t path_frames = 0;                  // 已转换成像素点的帧数
+            std::vector<std::pair<int, int>> done;   // 已定稿列的抽稀输出
+            std::vector<std::pair<int, int>> tail;   // 未定稿的最后两列的原始像素点
+            bool used = false;
+        };
+        std::array<double, 7> mapping{};  // 时间/数值到像素的映射参数
+        std::map<std::string, Entry> entries;
+    };
+
+    enum class ChartType {
+        Line,     // 每个序列一条折线
+        Heatmap,  // 每个序列一行，按时间分列，颜色表示数值
+        StackedArea,  // 按顺序自下而上累加，每个序列一块填充区域
+        MultiAxis,    // 每个序列(最多3个)各用一根y轴，共享时间轴
+        Table,        // 不画数据，只画style.table里的文字表格
+    };
+
+    struct TimeMarker {  //画在时间轴上的竖线，label为空时只画线
+        uint64_t time_ms;
+        std::string label;
+    };
+
     struct StyleParams {
         int width;
         int height;
@@ -62,6 +268,15 @@ public:
         std::string label;  //指定标签
         std::vector<std::string> order;     //指定顺序
 
+        bool decimate;  //点数远多于像素列时抽稀折线，像素精度内保持形状
+        uint64_t time_axis_max = 0;  //大于0时x轴右端至少延伸到这个时间，实时报告用来固定坐标
+
+        ChartType chart_type = ChartType::Line;
+        int heatmap_bucket_width = 5;  //热力图每列的像素宽度
+
+        std::vector<TimeMarker> markers;             //标记，所有图表类型都画
+        std::vector<std::vector<std::string>> table;  // Table用，第一行为表头
+
         StyleParams() : width(1440), height(720),
                         chart_top(80), chart_bottom(580),
                         left_margin(100), right_margin(50), bottom_margin(120),
@@ -74,28 +289,35 @@ public:
                         max_y_ticks(3), max_x_ticks(6),
                         legend_items_per_row(5), legend_item_height(35),
                         custom_min_value(0.0f), custom_max_value(100.0f), use_custom_range(false),
-                        use_custom_max_range(true), use_custom_min_range(true), ticks({}), label("") {}
+                        use_custom_max_range(true), use_custom_min_range(true), ticks({}), label(""),
+                        decimate(true) {}
     };
 
 private:
     StyleParams params;
     std::map<std::string, std::string> core_colors;
-    std::stringstream svg;
-
-    std::vector<std::string> color_palette = {
-        "#1F3A93", "#2878C9", "#32B8C2", "#00CC99", "#66CC33",
-        "#99CC00", "#CCCC00", "#FFCC00", "#FF9933", "#FF6633",
-        "#FF3366", "#FF3399", "#CC33CC", "#9966CC", "#6699FF",
-        "#3366CC", "#0044CC", "#0066AA", "#008888", "#00AA66",
-        "#66AA00", "#AAAA00", "#CC6600", "#CC3300", "#6A5ACD",
-        "#20B2AA", "#87CEEB", "#98FB98", "#DDA0DD", "#FFB6C1",
-        "#F0E68C", "#D2B48C", "#BC8F8F", "#A0522D", "#8FBC8F",
-        "#48D1CC"};
+    SvgBuffer svg;
+    PathCache* path_cache = nullptr;  //不为空时统计值和抽稀结果跨多次绘制复用
 
 public:
+    static const std::vector<std::string>& colorPalette() {  //按序号循环取色
+        static const std::vector<std::string> palette = {
+            "#1F3A93", "#2878C9", "#32B8C2", "#00CC99", "#66CC33",
+            "#99CC00", "#CCCC00", "#FFCC00", "#FF9933", "#FF6633",
+            "#FF3366", "#FF3399", "#CC33CC", "#9966CC", "#6699FF",
+            "#3366CC", "#0044CC", "#0066AA", "#008888", "#00AA66",
+            "#66AA00", "#AAAA00", "#CC6600", "#CC3300", "#6A5ACD",
+            "#20B2AA", "#87CEEB", "#98FB98", "#DDA0DD", "#FFB6C1",
+            "#F0E68C", "#D2B48C", "#BC8F8F", "#A0522D", "#8FBC8F",
+            "#48D1CC"};
+        return palette;
+    }
+
     SVGFreqPlotter(const StyleParams& style_params = StyleParams())
         : params(style_params) {}
 
+    void setPathCache(PathCache* cache) { path_cache = cache; }
+
     void drawChart(const std::vector<FrameData>& frames,
                    const std::string& title = "数据监控",
                    const std::string& y_label = "数值",
@@ -103,103 +325,129 @@ public:
 
         if (frames.empty()) return;
 
-        auto core_order = detectAndSortCores(frames);
-        generateColors(core_order);
-        auto [time_data, value_data] = extractValueData(frames, core_order);
-        auto [min_time, max_time] = getTimeRange(time_data);
-        auto [min_val, max_val] = getValueRange(value_data);
-
-        float data_min = std::numeric_limits<float>::max();
-        float data_max = std::numeric_limits<float>::lowest();
-
-        float realmax = 0.0f;
-        for (const auto& [core, values] : value_data) {
-            for (float val : values) {
-                if (val > realmax) realmax = val;
-            }
-        }
-
-        svg.str("");
         svg.clear();
-        generateSVG(svg, title, y_label, core_order, time_data, value_data,
-                    min_time, max_time, min_val, max_val, realmax);
+        SvgCanvas canvas(svg, true);
+        render(frames, title, y_label, canvas);
 
         if (!filename.empty()) {
             saveSVG(filename);
         }
     }
 
-    std::string getSVG() {
-        return svg.str();
+    // 嵌入文档用：图表直接追加到out，不带xml声明
+    void drawChart(const std::vector<FrameData>& frames,
+                   const std::string& title,
+                   const std::string& y_label,
+                   SvgBuffer& out) {
+        if (frames.empty()) return;
+        SvgCanvas canvas(out, false);
+        render(frames, title, y_label, canvas);
     }
 
-    void saveSVG(const std::string& filename) {
-        std::ofstream file(filename);
-        file << svg.str();
-        file.close();
+    void drawChart(const SeriesData& data,
+                   const std::string& title,
+                   const std::string& y_label,
+                   SvgBuffer& out) {
+        SvgCanvas canvas(out, false);
+        drawChart(data, title, y_label, canvas);
     }
 
-    static std::string concatenateSVGsVertically(const std::vector<std::string>& svgContents,  //将多个svg纵向拼合
-                                                 double svgWidth, double svgHeight,
-                                                 double spacing = 0.0,
-                                                 const std::string& title = "",
-                                                 const std::string& timestamp = "") {
-        if (svgContents.empty()) return "";
+    void drawChart(const SeriesData& data,  //画到任意画布(svg/位图)
+                   const std::string& title,
+                   const std::string& y_label,
+                   ChartCanvas& canvas) {
+        if (params.chart_type == ChartType::Table) {
+            renderTable(title, canvas);
+            return;
+        }
+        if (data.time_ms.empty()) return;
 
-        double headerHeight = 0;
-        if (!title.empty() || !timestamp.empty()) {
-            headerHeight = 150;
+        std::vector<std::string> core_order = params.order;
+        if (core_order.empty()) {
+            for (const auto& [name, series] : data.series) core_order.push_back(name);
         }
+        renderSeries(data, core_order, title, y_label, canvas);
+    }
 
-        double totalHeight = headerHeight + svgHeight * svgContents.size() + spacing * (svgContents.size() - 1);
+    std::string getSVG() {
+        return svg.str();
+    }
 
-        std::ostringstream result;
-        result << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
-        result << "<svg xmlns=\"http://www.w3.org/2000/svg\" "
-               << "viewBox=\"0 0 " << svgWidth << " " << totalHeight << "\" "
-               << "width=\"" << svgWidth << "\" height=\"" << totalHeight << "\">\n";
+    void saveSVG(const std::string& filename) {
+        std::ofstream file(filename);
+        file.write(svg.str().data(), svg.size());
+        file.close();
+    }
 
-        result << "  <rect width=\"100%\" height=\"100%\" fill=\"white\"/>\n";
+private:
+    void render(const std::vector<FrameData>& frames,
+                const std::string& title,
+                const std::string& y_label,
+                ChartCanvas& canvas) {
+        auto core_order = detectAndSortCores(frames);
+        SeriesData data = extractValueData(frames, core_order);
+        renderSeries(data, core_order, title, y_label, canvas);
+    }
 
-        if (!title.empty() || !timestamp.empty()) {  //尝试添加标题
-            result << "  <!-- Header Section -->\n";
-            result << "  <g font-family=\"Arial, sans-serif\">\n";
+public:
+    // 按帧的数据转成稀疏序列，只保留要画的序列(样式指定的顺序，或全部)
+    SeriesData seriesFromFrames(const std::vector<FrameData>& frames) {
+        return extractValueData(frames, detectAndSortCores(frames));
+    }
 
-            if (!title.empty()) {
-                result << "    <text x=\"" << 100 << "\" y=\"55\" font-size=\"48\" font-weight=\"bold\">"
-                       << title << "</text>\n";
-            }
+private:
 
-            if (!timestamp.empty()) {
-                result << "    <text x=\"" << 100 << "\" y=\"85\" font-size=\"30\" fill=\"#666\">"
-                       << timestamp << "</text>\n";
-            }
+    void renderSeries(const SeriesData& data,
+                      const std::vector<std::string>& core_order,
+                      const std::string& title,
+                      const std::string& y_label,
+                      ChartCanvas& canvas) {
+        if (params.chart_type == ChartType::Heatmap) {
+            renderHeatmap(data, core_order, title, y_label, canvas);
+            return;
+        }
+        if (params.chart_type == ChartType::StackedArea) {
+            renderStacked(data, core_order, title, canvas);
+            return;
+        }
+        if (params.chart_type == ChartType::MultiAxis) {
+            renderMultiAxis(data, core_order, title, canvas);
+            return;
+        }
 
-            result << "  </g>\n";
+        generateColors(core_order);
+        if (path_cache) {
+            for (auto& [name, entry] : path_cache->entries) entry.used = false;
         }
+        auto [min_time, max_time] = getTimeRange(data.time_ms);
+        auto [min_val, max_val, realmax] = getValueRange(data, core_order);
 
-        for (size_t i = 0; i < svgContents.size(); ++i) {  //嵌入所有svg
-            std::string content = svgContents[i];
+        generateSVG(canvas, title, y_label, core_order, data,
+                    min_time, max_time, min_val, max_val, realmax);
 
-            if (content.find("<?xml") == 0) {
-                size_t xmlEnd = content.find("?>");
-                if (xmlEnd != std::string::npos) {
-                    content = content.substr(xmlEnd + 2);
-                }
+        if (path_cache) {  //这次没画的序列(比如掉出了前15)不再保留，再出现时从头算
+            for (auto it = path_cache->entries.begin(); it != path_cache->entries.end();) {
+                it = it->second.used ? std::next(it) : path_cache->entries.erase(it);
             }
+        }
+    }
 
-            double yPosition = headerHeight + i * (svgHeight + spacing);
-
-            result << "  <g transform=\"translate(0 " << yPosition << ")\">\n";
-            result << content << "\n";
-            result << "  </g>\n";
+    PathCache::Entry& cacheEntry(const SeriesData& data, const std::string& core) {
+        PathCache::Entry& entry = path_cache->entries[core];
+        size_t frames = data.time_ms.size();
+        if (entry.frames > frames || (entry.frames > 0 && data.time_ms[entry.frames - 1] != entry.last_time)) {
+            entry = PathCache::Entry{};
         }
+        entry.used = true;
+        return entry;
+    }
 
-        result << "</svg>";
-        return result.str();
+    const SparseSeries& seriesOf(const SeriesData& data, const std::string& core) const {  //不存在的序列全为0
+        static const SparseSeries empty;
+        auto it = data.series.find(core);
+        return it != data.series.end() ? it->second : empty;
     }
 
-private:
     std::vector<std::string> detectAndSortCores(const std::vector<FrameData>& frames) {
         if (params.order.empty()) {
             std::set<std::string> core_set;
@@ -219,54 +467,68 @@ private:
         core_colors.clear();
 
         for (size_t i = 0; i < core_order.size(); ++i) {
-            int color_index = i % color_palette.size();
-            core_colors[core_order[i]] = color_palette[color_index];
+            int color_index = i % colorPalette().size();
+            core_colors[core_order[i]] = colorPalette()[color_index];
         }
     }
 
-    std::pair<std::vector<uint64_t>, std::map<std::string, std::vector<float>>>
-    extractValueData(const std::vector<FrameData>& frames,
-                     const std::vector<std::string>& core_order) {
-        std::vector<uint64_t> time_data;
-        std::map<std::string, std::vector<float>> value_data;
+    // 按帧的map转成稀疏序列：缺失的帧沿用上一个值
+    SeriesData extractValueData(const std::vector<FrameData>& frames,
+                                const std::vector<std::string>& core_order) {
+        SeriesData data;
+        data.time_ms.reserve(frames.size());
 
         for (const auto& core : core_order) {
-            value_data[core] = std::vector<float>();
+            data.series[core].hold = true;
         }
 
-        for (const auto& frame : frames) {
-            time_data.push_back(frame.time_ms);
+        for (size_t i = 0; i < frames.size(); ++i) {
+            data.time_ms.push_back(frames[i].time_ms);
 
-            for (const auto& core : core_order) {
-                if (frame.frequencies.find(core) != frame.frequencies.end()) {
-                    value_data[core].push_back(frame.frequencies.at(core));
-                } else {
-                    if (!value_data[core].empty()) {
-                        value_data[core].push_back(value_data[core].back());
-                    } else {
-                        value_data[core].push_back(0.0f);
-                    }
+            for (auto& [core, series] : data.series) {
+                auto it = frames[i].frequencies.find(core);
+                if (it != frames[i].frequencies.end()) {
+                    series.push(static_cast<uint32_t>(i), it->second);
                 }
             }
         }
 
-        return {time_data, value_data};
+        return data;
     }
 
     std::pair<uint64_t, uint64_t> getTimeRange(const std::vector<uint64_t>& time_data) {
         if (time_data.empty()) return {0, 1};
-        return {time_data.front(), time_data.back()};
+        return {time_data.front(), std::max(time_data.back(), params.time_axis_max)};
     }
 
-    std::pair<float, float> getValueRange(const std::map<std::string, std::vector<float>>& value_data) {
+    // 返回 {下限, 上限, 实际最大值}，补出来的值也参与计算
+    std::tuple<float, float, float> getValueRange(const SeriesData& data, const std::vector<std::string>& core_order) {
         float min_val = std::numeric_limits<float>::max();
         float max_val = std::numeric_limits<float>::lowest();
+        float realmax = 0.0f;
 
-        for (const auto& [core, values] : value_data) {
-            for (float val : values) {
+        std::set<std::string> seen;
+        for (const auto& core : core_order) {
+            if (!seen.insert(core).second) continue;
+            if (path_cache) {  //只统计新增的帧
+                PathCache::Entry& entry = cacheEntry(data, core);
+                size_t frames = data.time_ms.size();
+                seriesOf(data, core).forEach(entry.frames, frames, [&](size_t, float val) {
+                    entry.min_val = std::min(entry.min_val, val);
+                    entry.max_val = std::max(entry.max_val, val);
+                });
+                entry.frames = frames;
+                entry.last_time = frames > 0 ? data.time_ms[frames - 1] : 0;
+                min_val = std::min(min_val, entry.min_val);
+                max_val = std::max(max_val, entry.max_val);
+                realmax = std::max(realmax, entry.max_val);
+                continue;
+            }
+            seriesOf(data, core).forEach(data.time_ms.size(), [&](size_t, float val) {
                 if (val < min_val) min_val = val;
                 if (val > max_val) max_val = val;
-            }
+                if (val > realmax) realmax = val;
+            });
         }
 
         if (min_val == std::numeric_limits<float>::max()) {
@@ -278,51 +540,43 @@ private:
         float final_min = (params.use_custom_range && params.use_custom_min_range) ? params.custom_min_value : std::max(0.0f, min_val - margin);
         float final_max = (params.use_custom_max_range && params.use_custom_range) ? params.custom_max_value : max_val + margin;
 
-        return {final_min, final_max};
+        return {final_min, final_max, realmax};
     }
 
-    void generateSVG(std::stringstream& svg,
+    void generateSVG(ChartCanvas& canvas,
                      const std::string& title,
                      const std::string& y_label,
                      const std::vector<std::string>& core_order,
-                     const std::vector<uint64_t>& time_data,
-                     const std::map<std::string, std::vector<float>>& value_data,
+                     const SeriesData& data,
                      uint64_t min_time, uint64_t max_time,
                      float min_val, float max_val, float realmax) {
 
-        svg << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
-        svg << "<svg width=\"" << params.width << "\" height=\"" << params.height
-            << "\" xmlns=\"http://www.w3.org/2000/svg\">\n";
-
-        svg << "  <rect width=\"100%\" height=\"100%\" fill=\"" << params.background_color << "\"/>\n";
+        canvas.begin(params.width, params.height, params.background_color);
 
-        svg << "  <text x=\"" << params.left_margin << "\" y=\"40\" font-size=\""  //标题
-            << params.title_font_size << "\" font-weight=\"bold\" fill=\""
-            << params.text_color << "\">" << title << "</text>\n";
+        canvas.text(params.left_margin, 40, params.title_font_size, params.text_color, title,  //标题
+                    ChartCanvas::Anchor::Start, true);
 
-        svg << "  <text x=\"" << params.left_margin << "\" y=\"70\" font-size=\""
-            << params.subtitle_font_size << "\" fill=\"" << params.text_color
-            << "\">" << params.label << " </text>\n";
+        std::string subtitle = params.label + " ";
+        canvas.text(params.left_margin, 70, params.subtitle_font_size, params.text_color, subtitle);
 
         int chart_width = params.width - params.left_margin - params.right_margin;
         int chart_height = params.chart_bottom - params.chart_top;
 
-        svg << "  <rect x=\"" << params.left_margin << "\" y=\"" << params.chart_top
-            << "\" width=\"" << chart_width << "\" height=\"" << chart_height
-            << "\" fill=\"none\" stroke=\"" << params.axis_color
-            << "\" stroke-width=\"" << params.axis_line_width << "\"/>\n";
+        canvas.rect(params.left_margin, params.chart_top, chart_width, chart_height,
+                    "none", params.axis_color, params.axis_line_width);
 
-        drawGridAndTicks(svg, min_time, max_time, min_val, max_val, chart_width, chart_height, realmax);  // 网格线和刻度
+        drawGridAndTicks(canvas, min_time, max_time, min_val, max_val, chart_width, chart_height, realmax);  // 网格线和刻度
 
-        drawDataLines(svg, time_data, value_data, min_time, max_time, min_val, max_val,  // 数据线条
+        drawDataLines(canvas, data, min_time, max_time, min_val, max_val,  // 数据线条
                       chart_width, chart_height, core_order);
 
-        drawLegend(svg, core_order);  // 图例
+        drawLegend(canvas, core_order);  // 图例
+        drawMarkers(canvas, min_time, max_time, chart_width);
 
-        svg << "</svg>";
+        canvas.end();
     }
 
-    void drawGridAndTicks(std::stringstream& svg,
+    void drawGridAndTicks(ChartCanvas& canvas,
                           uint64_t min_time, uint64_t max_time,
                           float min_val, float max_val,
                           int chart_width, int chart_height, float realmax) {
@@ -332,20 +586,22 @@ private:
         for (float val : y_ticks) {
             int y = valueToY(val, min_val, max_val, chart_height);
 
-            svg << "  <line x1=\"" << params.left_margin << "\" y1=\"" << y
-                << "\" x2=\"" << (params.width - params.right_margin) << "\" y2=\"" << y
-                << "\" stroke=\"" << params.grid_color
-                << "\" stroke-width=\"" << params.grid_line_width << "\"/>\n";
+            canvas.line(params.left_margin, y, params.width - params.right_margin, y,
+                        params.grid_color, params.grid_line_width);
 
-            std::string val_str = formatValue(val);
-            svg << "  <text x=\"" << (params.left_margin - 10) << "\" y=\"" << (y + 5)
-                << "\" font-size=\"" << params.tick_font_size << "\" text-anchor=\"end\" fill=\""
-                << params.text_color << "\">" << val_str << "</text>\n";
+            char label[32];
+            auto res = std::to_chars(label, label + sizeof(label), static_cast<double>(val), std::chars_format::fixed, 1);
+            canvas.text(params.left_margin - 10, y + 5, params.tick_font_size, params.text_color,
+                        std::string_view(label, res.ptr - label), ChartCanvas::Anchor::End);
         }
 
-        uint64_t time_range = max_time - min_time;  //x刻度
+        drawTimeTicks(canvas, min_time, max_time, chart_width, true);
+    }
+
+    void drawTimeTicks(ChartCanvas& canvas, uint64_t min_time, uint64_t max_time, int chart_width,
+                       bool grid) {  // x刻度，grid为false时只在轴下画短刻度线
+        uint64_t time_range = max_time - min_time;
         uint64_t x_tick_interval = chooseTimeTickInterval(time_range);
-        int x_ticks_drawn = 0;
 
         for (uint64_t t = (min_time / x_tick_interval) * x_tick_interval;
              t <= max_time;
@@ -354,17 +610,30 @@ private:
 
             int x = timeToX(t, min_time, max_time, chart_width);
 
-            svg << "  <line x1=\"" << x << "\" y1=\"" << params.chart_top
-                << "\" x2=\"" << x << "\" y2=\"" << params.chart_bottom
-                << "\" stroke=\"" << params.grid_color
-                << "\" stroke-width=\"" << params.grid_line_width << "\"/>\n";
+            if (grid) {
+                canvas.line(x, params.chart_top, x, params.chart_bottom, params.grid_color, params.grid_line_width);
+            } else {
+                canvas.line(x, params.chart_bottom, x, params.chart_bottom + 6, params.axis_color, params.grid_line_width);
+            }
 
-            std::string time_str = formatTime(t);
-            svg << "  <text x=\"" << x << "\" y=\"" << (params.chart_bottom + 25)
-                << "\" font-size=\"" << params.tick_font_size << "\" text-anchor=\"middle\" fill=\""
-                << params.text_color << "\">" << time_str << "</text>\n";
+            char label[32];
+            canvas.text(x, params.chart_bottom + 25, params.tick_font_size, params.text_color,
+                        formatTime(label, t), ChartCanvas::Anchor::Middle);
+        }
+    }
 
-            x_ticks_drawn++;
+    // 标记竖线，名字写在线右侧靠上；相邻标记的名字分三行错开，避免挤在一起
+    void drawMarkers(ChartCanvas& canvas, uint64_t min_time, uint64_t max_time, int chart_width) {
+        static const std::string color = "#D9534F";
+        int font_size = params.tick_font_size - 2;
+        size_t shown = 0;
+        for (const auto& marker : params.markers) {
+            if (marker.time_ms < min_time || marker.time_ms > max_time) continue;
+            int x = timeToX(marker.time_ms, min_time, max_time, chart_width);
+            canvas.line(x, params.chart_top, x, params.chart_bottom, color, params.grid_line_width * 1.5);
+            if (marker.label.empty()) continue;
+            int y = params.chart_top + font_size + 2 + static_cast<int>(shown++ % 3) * (font_size + 4);
+            canvas.text(x + 4, y, font_size, color, marker.label);
         }
     }
 
@@ -449,41 +718,517 @@ private:
         return ticks;
     }
 
-    void drawDataLines(std::stringstream& svg,
-                       const std::vector<uint64_t>& time_data,
-                       const std::map<std::string, std::vector<float>>& value_data,
+    void drawDataLines(ChartCanvas& canvas,
+                       const SeriesData& data,
                        uint64_t min_time, uint64_t max_time,
                        float min_val, float max_val,
                        int chart_width, int chart_height,
                        const std::vector<std::string>& core_order) {
 
+        if (path_cache) {  //坐标映射变了，缓存的像素点全部作废
+            std::array<double, 7> mapping = {static_cast<double>(min_time), static_cast<double>(max_time),
+                                             min_val, max_val, static_cast<double>(chart_width),
+                                             static_cast<double>(chart_height),
+                                             static_cast<double>(params.left_margin) * 65536 + params.chart_bottom};
+            if (mapping != path_cache->mapping) {
+                path_cache->mapping = mapping;
+                for (auto& [name, entry] : path_cache->entries) {
+                    entry.path_frames = 0;
+                    entry.done.clear();
+                    entry.tail.clear();
+                }
+            }
+        }
+
         for (auto it = core_order.rbegin(); it != core_order.rend(); ++it) {
             const auto& core = *it;
-            if (value_data.find(core) == value_data.end()) continue;
-
-            const auto& values = value_data.at(core);
             const auto& color = core_colors[core];
+            const auto& time_data = data.time_ms;
+            bool decimate = params.decimate && time_data.size() > static_cast<size_t>(chart_width) * 2;
+
+            std::vector<std::pair<int, int>> points;
+            if (path_cache && decimate) {  //只转换新增的帧，已定稿的列直接复用
+                PathCache::Entry& entry = cacheEntry(data, core);
+                seriesOf(data, core).forEach(entry.path_frames, time_data.size(), [&](size_t i, float value) {
+                    entry.tail.emplace_back(timeToX(time_data[i], min_time, max_time, chart_width),
+                                            valueToY(value, min_val, max_val, chart_height));
+                });
+                entry.path_frames = time_data.size();
+                std::vector<std::pair<int, int>> live = decimateIncremental(entry.tail, entry.done);
+                points.reserve(entry.done.size() + live.size());
+                points.insert(points.end(), entry.done.begin(), entry.done.end());
+                points.insert(points.end(), live.begin(), live.end());
+                canvas.polyline(points, color, params.data_line_width, params.data_line_opacity);
+                continue;
+            }
 
-            std::stringstream path;
-            path << "M ";
+            points.reserve(time_data.size());
+            seriesOf(data, core).forEach(time_data.size(), [&](size_t i, float value) {
+                points.emplace_back(timeToX(time_data[i], min_time, max_time, chart_width),
+                                    valueToY(value, min_val, max_val, chart_height));
+            });
+            if (decimate) {
+                points = decimatePolyline(points);
+            }
 
-            for (size_t i = 0; i < time_data.size(); ++i) {
-                int x = timeToX(time_data[i], min_time, max_time, chart_width);
-                int y = valueToY(values[i], min_val, max_val, chart_height);
+            canvas.polyline(points, color, params.data_line_width, params.data_line_opacity);
+        }
+    }
+
+    // 按像素列抽稀：坐标已经取整，同一列内的点只影响这一列的竖线
+    // 列内起伏超过1像素时保留 首/最低/最高/末 四个点(包络，尖峰不会丢)
+    // 起伏不超过1像素时只保留一个点，用LTTB(最大三角形)在列内挑选
+    struct Column {
+        size_t begin, end;  // [begin, end)
+        size_t min_i, max_i;
+        double avg_x, avg_y;
+    };
+
+    static std::vector<Column> splitColumns(const std::vector<std::pair<int, int>>& points) {
+        std::vector<Column> columns;
+        for (size_t i = 0; i < points.size();) {
+            Column col{i, i, i, i, 0.0, 0.0};
+            while (col.end < points.size() && points[col.end].first == points[i].first) {
+                const auto& p = points[col.end];
+                if (p.second < points[col.min_i].second) col.min_i = col.end;
+                if (p.second > points[col.max_i].second) col.max_i = col.end;
+                col.avg_x += p.first;
+                col.avg_y += p.second;
+                ++col.end;
+            }
+            col.avg_x /= (col.end - col.begin);
+            col.avg_y /= (col.end - col.begin);
+            columns.push_back(col);
+            i = col.end;
+        }
+        return columns;
+    }
+
+    // 第c列的输出追加到result；非边缘列要用result.back()作为上一个选中点
+    static void decimateColumn(const std::vector<std::pair<int, int>>& points, const std::vector<Column>& columns,
+                               size_t c, bool is_edge, std::vector<std::pair<int, int>>& result) {
+        const Column& col = columns[c];
+        int spread = points[col.max_i].second - points[col.min_i].second;
+
+        if (spread > 1 || is_edge) {  //包络，首尾列也完整保留
+            size_t picks[4] = {col.begin, std::min(col.min_i, col.max_i),
+                               std::max(col.min_i, col.max_i), col.end - 1};
+            for (size_t k = 0; k < 4; ++k) {
+                if (k > 0 && picks[k] == picks[k - 1]) continue;
+                result.push_back(points[picks[k]]);
+            }
+            return;
+        }
+
+        const auto prev = result.back();  // LTTB：与上一个选中点、下一列均值构成的三角形面积最大
+        const Column& next = columns[c + 1];
+        size_t best = col.begin;
+        double best_area = -1.0;
+        for (size_t i = col.begin; i < col.end; ++i) {
+            double area = std::abs((prev.first - next.avg_x) * (points[i].second - prev.second) -
+                                   (prev.first - points[i].first) * (next.avg_y - prev.second));
+            if (area > best_area) {
+                best_area = area;
+                best = i;
+            }
+        }
+        result.push_back(points[best]);
+    }
+
+    static std::vector<std::pair<int, int>> decimatePolyline(const std::vector<std::pair<int, int>>& points) {
+        std::vector<Column> columns = splitColumns(points);
+        std::vector<std::pair<int, int>> result;
+        result.reserve(columns.size() * 2);
+
+        for (size_t c = 0; c < columns.size(); ++c) {
+            decimateColumn(points, columns, c, c == 0 || c + 1 == columns.size(), result);
+        }
+        return result;
+    }
+
+    // 可续算的抽稀：tail是还没定稿的原始点，done是此前已定稿的输出
+    // 一列的结果取决于下一列，最后一列还可能有新点，所以除最后两列外都可以定稿：
+    // 定稿的输出移入done，对应的原始点从tail删除；返回最后两列的临时输出
+    // done与返回值拼接后和对全部点做decimatePolyline的结果相同
+    static std::vector<std::pair<int, int>> decimateIncremental(std::vector<std::pair<int, int>>& tail,
+                                                                std::vector<std::pair<int, int>>& done) {
+        std::vector<Column> columns = splitColumns(tail);
+        std::vector<std::pair<int, int>> result;
+        if (!done.empty()) result.push_back(done.back());  //上一个选中点，LTTB要用
+        size_t seed = result.size();
+
+        size_t final_columns = columns.size() >= 2 ? columns.size() - 2 : 0;
+        size_t final_end = seed;
+        for (size_t c = 0; c < columns.size(); ++c) {
+            bool is_edge = (c == 0 && done.empty()) || c + 1 == columns.size();
+            decimateColumn(tail, columns, c, is_edge, result);
+            if (c + 1 == final_columns) final_end = result.size();
+        }
+
+        if (final_columns > 0) {
+            done.insert(done.end(), result.begin() + seed, result.begin() + final_end);
+            tail.erase(tail.begin(), tail.begin() + columns[final_columns].begin);
+        }
+        result.erase(result.begin(), result.begin() + final_end);
+        return result;
+    }
+
+    // 热力图：每个序列一行，每heatmap_bucket_width个像素一列，颜色为该列时间段内的平均值
+    // 相邻同色的列合并成一个矩形，输出只与 行数×像素列数 有关，与采样数无关
+    void renderHeatmap(const SeriesData& data,
+                       const std::vector<std::string>& rows,
+                       const std::string& title,
+                       const std::string& y_label,
+                       ChartCanvas& canvas) {
+        auto [min_time, max_time] = getTimeRange(data.time_ms);
+        int chart_width = params.width - params.left_margin - params.right_margin;
+        int chart_height = params.chart_bottom - params.chart_top;
+        int bucket_width = std::max(1, params.heatmap_bucket_width);
+        size_t buckets = static_cast<size_t>((chart_width + bucket_width - 1) / bucket_width);
+        size_t frames = data.time_ms.size();
+        std::vector<size_t> bucket_begin = bucketRanges(data.time_ms, min_time, max_time, chart_width, bucket_width);
+
+        // 逐行展开成连续数组后按列归约，没有采样的列为NaN
+        std::vector<float> cells(rows.size() * buckets, std::numeric_limits<float>::quiet_NaN());
+        std::vector<float> dense(frames);
+        float min_val = std::numeric_limits<float>::max();
+        float max_val = std::numeric_limits<float>::lowest();
+        for (size_t r = 0; r < rows.size(); ++r) {
+            seriesOf(data, rows[r]).forEach(frames, [&](size_t i, float value) { dense[i] = value; });
+            for (size_t b = 0; b < buckets; ++b) {
+                size_t begin = bucket_begin[b], end = bucket_begin[b + 1];
+                if (end <= begin) continue;
+                float mean = sumRange(dense.data() + begin, end - begin) / static_cast<float>(end - begin);
+                cells[r * buckets + b] = mean;
+                min_val = std::min(min_val, mean);
+                max_val = std::max(max_val, mean);
+            }
+        }
+        if (params.use_custom_range && params.use_custom_min_range) min_val = params.custom_min_value;
+        if (params.use_custom_range && params.use_custom_max_range) max_val = params.custom_max_value;
+        if (min_val > max_val) {
+            min_val = 0.0f;
+            max_val = 1.0f;
+        }
+
+        canvas.begin(params.width, params.height, params.background_color);
+        canvas.text(params.left_margin, 40, params.title_font_size, params.text_color, title,
+                    ChartCanvas::Anchor::Start, true);
+        std::string subtitle = params.label + " ";
+        canvas.text(params.left_margin, 70, params.subtitle_font_size, params.text_color, subtitle);
+
+        const auto& palette = heatPalette();
+        auto levelOf = [&](float value) {
+            if (std::isnan(value)) return -1;
+            float ratio = max_val > min_val ? (value - min_val) / (max_val - min_val) : 0.0f;
+            int level = static_cast<int>(ratio * palette.size());
+            return std::clamp(level, 0, static_cast<int>(palette.size()) - 1);
+        };
+
+        int row_count = static_cast<int>(rows.size());
+        for (int r = 0; r < row_count; ++r) {
+            int y0 = params.chart_top + r * chart_height / row_count;
+            int y1 = params.chart_top + (r + 1) * chart_height / row_count;
+
+            for (size_t b = 0; b < buckets;) {
+                int level = levelOf(cells[r * buckets + b]);
+                size_t run_end = b + 1;
+                while (run_end < buckets && levelOf(cells[r * buckets + run_end]) == level) ++run_end;
+                if (level >= 0) {
+                    int x0 = params.left_margin + static_cast<int>(b) * bucket_width;
+                    int x1 = std::min(params.left_margin + chart_width,
+                                      params.left_margin + static_cast<int>(run_end) * bucket_width);
+                    canvas.rect(x0, y0, x1 - x0, y1 - y0, palette[level], "none", 0);
+                }
+                b = run_end;
+            }
+
+            int font_size = std::min(params.tick_font_size, std::max(8, y1 - y0 - 2));
+            canvas.text(params.left_margin - 10, (y0 + y1) / 2 + font_size / 3, font_size, params.text_color,
+                        rows[r], ChartCanvas::Anchor::End);
+        }
+
+        canvas.rect(params.left_margin, params.chart_top, chart_width, chart_height,
+                    "none", params.axis_color, params.axis_line_width);
+        drawTimeTicks(canvas, min_time, max_time, chart_width, false);
+        drawColorScale(canvas, min_val, max_val, y_label);
+        drawMarkers(canvas, min_time, max_time, chart_width);
+
+        canvas.end();
+    }
+
+    // 每列对应的帧区间 [result[b], result[b+1])，时间递增所以一次扫描；没有帧的列区间为空
+    std::vector<size_t> bucketRanges(const std::vector<uint64_t>& time_data, uint64_t min_time, uint64_t max_time,
+                                     int chart_width, int bucket_width) {
+        size_t buckets = static_cast<size_t>((chart_width + bucket_width - 1) / bucket_width);
+        std::vector<size_t> bucket_begin(buckets + 1, time_data.size());
+        size_t next_bucket = 0;
+        for (size_t i = 0; i < time_data.size(); ++i) {
+            int offset = timeToX(time_data[i], min_time, max_time, chart_width) - params.left_margin;
+            size_t bucket = std::min(buckets - 1, static_cast<size_t>(std::max(0, offset)) / bucket_width);
+            while (next_bucket <= bucket) bucket_begin[next_bucket++] = i;
+        }
+        return bucket_begin;
+    }
+
+    // 堆叠面积图：序列按顺序自下而上累加，每层是一个闭合路径(上沿向右，再沿下一层的上沿返回)
+    // 点数远多于像素列时先按像素列取平均再累加，各层边界仍然严丝合缝
+    void renderStacked(const SeriesData& data,
+                       const std::vector<std::string>& layers,
+                       const std::string& title,
+                       ChartCanvas& canvas) {
+        generateColors(layers);
+        auto [min_time, max_time] = getTimeRange(data.time_ms);
+        int chart_width = params.width - params.left_margin - params.right_margin;
+        int chart_height = params.chart_bottom - params.chart_top;
+        size_t frames = data.time_ms.size();
+
+        // 横坐标：逐帧，或每个像素列一个点
+        std::vector<int> xs;
+        std::vector<size_t> bucket_begin;
+        bool bucketed = params.decimate && frames > static_cast<size_t>(chart_width) * 2;
+        if (bucketed) {
+            bucket_begin = bucketRanges(data.time_ms, min_time, max_time, chart_width, 1);
+            for (size_t b = 0; b + 1 < bucket_begin.size(); ++b) {
+                if (bucket_begin[b + 1] > bucket_begin[b]) xs.push_back(params.left_margin + static_cast<int>(b));
+            }
+        } else {
+            for (uint64_t t : data.time_ms) xs.push_back(timeToX(t, min_time, max_time, chart_width));
+        }
+
+        // tops[k]为第k层的上沿(累加值)
+        std::vector<std::vector<float>> tops(layers.size(), std::vector<float>(xs.size()));
+        std::vector<float> dense(frames);
+        for (size_t k = 0; k < layers.size(); ++k) {
+            seriesOf(data, layers[k]).forEach(frames, [&](size_t i, float value) { dense[i] = value; });
+            std::vector<float>& top = tops[k];
+            if (bucketed) {
+                size_t p = 0;
+                for (size_t b = 0; b + 1 < bucket_begin.size(); ++b) {
+                    size_t begin = bucket_begin[b], end = bucket_begin[b + 1];
+                    if (end <= begin) continue;
+                    top[p++] = sumRange(dense.data() + begin, end - begin) / static_cast<float>(end - begin);
+                }
+            } else {
+                top.assign(dense.begin(), dense.end());
+            }
+            if (k > 0) {
+                const std::vector<float>& below = tops[k - 1];
+                for (size_t i = 0; i < top.size(); ++i) top[i] += below[i];
+            }
+        }
+
+        float realmax = 0.0f;
+        if (!tops.empty()) {
+            for (float v : tops.back()) realmax = std::max(realmax, v);
+        }
+        float margin = std::max(0.1f, realmax * 0.1f);
+        float min_val = (params.use_custom_range && params.use_custom_min_range) ? params.custom_min_value : 0.0f;
+        float max_val = (params.use_custom_max_range && params.use_custom_range) ? params.custom_max_value : realmax + margin;
+
+        canvas.begin(params.width, params.height, params.background_color);
+        canvas.text(params.left_margin, 40, params.title_font_size, params.text_color, title,
+                    ChartCanvas::Anchor::Start, true);
+        std::string subtitle = params.label + " ";
+        canvas.text(params.left_margin, 70, params.subtitle_font_size, params.text_color, subtitle);
+        canvas.rect(params.left_margin, params.chart_top, chart_width, chart_height,
+                    "none", params.axis_color, params.axis_line_width);
+        drawGridAndTicks(canvas, min_time, max_time, min_val, max_val, chart_width, chart_height, realmax);
+
+        std::vector<std::pair<int, int>> outline;
+        outline.reserve(xs.size() * 2);
+        for (size_t k = 0; k < layers.size(); ++k) {
+            outline.clear();
+            for (size_t i = 0; i < xs.size(); ++i) {
+                outline.emplace_back(xs[i], valueToY(tops[k][i], min_val, max_val, chart_height));
+            }
+            for (size_t i = xs.size(); i-- > 0;) {
+                float base = k > 0 ? tops[k - 1][i] : min_val;
+                outline.emplace_back(xs[i], valueToY(base, min_val, max_val, chart_height));
+            }
+            canvas.polygon(outline, core_colors[layers[k]], params.data_line_opacity);
+        }
+
+        drawLegend(canvas, layers);
+        drawMarkers(canvas, min_time, max_time, chart_width);
+        canvas.end();
+    }
 
-                if (i == 0) {
-                    path << x << " " << y;
+    // 多轴叠加：第1个序列用左轴(带网格线)，第2、3个序列的刻度依次排在右侧，刻度文字用序列颜色
+    // 每个序列按自己的范围映射，抽稀规则与折线图相同
+    void renderMultiAxis(const SeriesData& data,
+                         const std::vector<std::string>& order,
+                         const std::string& title,
+                         ChartCanvas& canvas) {
+        std::vector<std::string> names(order.begin(), order.begin() + std::min<size_t>(order.size(), 3));
+        generateColors(names);
+        auto [min_time, max_time] = getTimeRange(data.time_ms);
+        int chart_width = params.width - params.left_margin - params.right_margin;
+        int chart_height = params.chart_bottom - params.chart_top;
+        int chart_right = params.width - params.right_margin;
+
+        canvas.begin(params.width, params.height, params.background_color);
+        canvas.text(params.left_margin, 40, params.title_font_size, params.text_color, title,
+                    ChartCanvas::Anchor::Start, true);
+        std::string subtitle = params.label + " ";
+        canvas.text(params.left_margin, 70, params.subtitle_font_size, params.text_color, subtitle);
+        canvas.rect(params.left_margin, params.chart_top, chart_width, chart_height,
+                    "none", params.axis_color, params.axis_line_width);
+
+        std::vector<std::pair<float, float>> ranges;
+        for (size_t k = 0; k < names.size(); ++k) {
+            auto [min_val, max_val, realmax] = getValueRange(data, {names[k]});
+            ranges.emplace_back(min_val, max_val);
+            const std::string& color = core_colors[names[k]];
+
+            for (float val : generateYTicks(min_val, max_val, realmax)) {
+                int y = valueToY(val, min_val, max_val, chart_height);
+                char label[32];
+                auto res = std::to_chars(label, label + sizeof(label), static_cast<double>(val), std::chars_format::fixed, 1);
+                std::string_view text(label, res.ptr - label);
+                if (k == 0) {
+                    canvas.line(params.left_margin, y, chart_right, y, params.grid_color, params.grid_line_width);
+                    canvas.text(params.left_margin - 10, y + 5, params.tick_font_size, color, text, ChartCanvas::Anchor::End);
                 } else {
-                    path << " L " << x << " " << y;
+                    int x = chart_right + 8 + static_cast<int>(k - 1) * 70;
+                    canvas.line(chart_right, y, chart_right + 5, y, color, params.grid_line_width);
+                    canvas.text(x, y + 5, params.tick_font_size, color, text);
+                }
+            }
+        }
+        drawTimeTicks(canvas, min_time, max_time, chart_width, true);
+
+        const auto& time_data = data.time_ms;
+        bool decimate = params.decimate && time_data.size() > static_cast<size_t>(chart_width) * 2;
+        for (size_t k = names.size(); k-- > 0;) {
+            std::vector<std::pair<int, int>> points;
+            points.reserve(time_data.size());
+            seriesOf(data, names[k]).forEach(time_data.size(), [&](size_t i, float value) {
+                points.emplace_back(timeToX(time_data[i], min_time, max_time, chart_width),
+                                    valueToY(value, ranges[k].first, ranges[k].second, chart_height));
+            });
+            if (decimate) points = decimatePolyline(points);
+            canvas.polyline(points, core_colors[names[k]], params.data_line_width, params.data_line_opacity);
+        }
+
+        drawLegend(canvas, names);
+        drawMarkers(canvas, min_time, max_time, chart_width);
+        canvas.end();
+    }
+
+    // 文字表格：列宽按各列最长文字分配，行多时压缩行高
+    void renderTable(const std::string& title, ChartCanvas& canvas) {
+        const auto& rows = params.table;
+        canvas.begin(params.width, params.height, params.background_color);
+        canvas.text(params.left_margin, 40, params.title_font_size, params.text_color, title,
+                    ChartCanvas::Anchor::Start, true);
+        if (rows.empty()) {
+            canvas.end();
+            return;
+        }
+
+        size_t columns = rows[0].size();
+        std::vector<size_t> widths(columns, 1);
+        for (const auto& row : rows) {
+            for (size_t c = 0; c < columns && c < row.size(); ++c) widths[c] = std::max(widths[c], textUnits(row[c]) + 2);
+        }
+        size_t total_units = 0;
+        for (size_t w : widths) total_units += w;
+
+        int table_width = params.width - params.left_margin - params.right_margin;
+        int row_height = std::min(44, (params.height - params.chart_top - 20) / static_cast<int>(rows.size()));
+        int font_size = std::min(params.legend_font_size, row_height - 10);
+
+        for (size_t r = 0; r < rows.size(); ++r) {
+            int y = params.chart_top + static_cast<int>(r) * row_height;
+            if (r == 0) {
+                canvas.rect(params.left_margin, y, table_width, row_height, "#F0F0F0", "none", 0);
+            }
+            canvas.line(params.left_margin, y + row_height, params.left_margin + table_width, y + row_height,
+                        r == 0 ? params.axis_color : params.grid_color, params.grid_line_width);
+
+            double x = params.left_margin;
+            for (size_t c = 0; c < columns && c < rows[r].size(); ++c) {
+                double width = static_cast<double>(table_width) * widths[c] / total_units;
+                canvas.text(static_cast<int>(x + 8), y + row_height / 2 + font_size / 3, font_size, params.text_color,
+                            rows[r][c], ChartCanvas::Anchor::Start, r == 0);
+                x += width;
+            }
+        }
+        canvas.end();
+    }
+
+    static size_t textUnits(const std::string& text) {  //按半角宽度计：ASCII算1，其余(中文)算2
+        size_t units = 0;
+        for (unsigned char c : text) {
+            if (c < 0x80) {
+                ++units;
+            } else if ((c & 0xC0) != 0x80) {
+                units += 2;
+            }
+        }
+        return units;
+    }
+
+    // 8路独立累加，没有跨迭代依赖，编译器可以直接向量化
+    static float sumRange(const float* values, size_t count) {
+        float lanes[8] = {};
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            for (size_t k = 0; k < 8; ++k) lanes[k] += values[i + k];
+        }
+        float total = 0.0f;
+        for (; i < count; ++i) total += values[i];
+        for (float lane : lanes) total += lane;
+        return total;
+    }
+
+    static const std::vector<std::string>& heatPalette() {  //由低到高32级，从深紫经青绿到黄
+        static const std::vector<std::string> palette = [] {
+            static const int anchors[][3] = {{68, 1, 84}, {59, 82, 139}, {33, 145, 140}, {94, 201, 98}, {253, 231, 37}};
+            const int levels = 32;
+            std::vector<std::string> colors;
+            for (int i = 0; i < levels; ++i) {
+                double pos = static_cast<double>(i) / (levels - 1) * 4.0;
+                int k = std::min(3, static_cast<int>(pos));
+                double f = pos - k;
+                char color[8] = "#";
+                for (int c = 0; c < 3; ++c) {
+                    int v = static_cast<int>(std::lround(anchors[k][c] + (anchors[k + 1][c] - anchors[k][c]) * f));
+                    color[1 + c * 2] = "0123456789ABCDEF"[v >> 4];
+                    color[2 + c * 2] = "0123456789ABCDEF"[v & 15];
                 }
+                colors.emplace_back(color, 7);
             }
+            return colors;
+        }();
+        return palette;
+    }
+
+    void drawColorScale(ChartCanvas& canvas, float min_val, float max_val, const std::string& y_label) {  //热力图的图例：色条和两端数值
+        int top = params.chart_bottom + 40;
+        const auto& palette = heatPalette();
+        int step = 12;
+        int bar_right = params.left_margin + static_cast<int>(palette.size()) * step;
 
-            svg << "  <path d=\"" << path.str() << "\" fill=\"none\" stroke=\""
-                << color << "\" stroke-width=\"" << params.data_line_width << "\" stroke-opacity=\"" << params.data_line_opacity << "\"/>\n";
+        char label[32];
+        auto res = std::to_chars(label, label + sizeof(label), static_cast<double>(min_val), std::chars_format::fixed, 1);
+        canvas.text(params.left_margin - 10, top + 14, params.tick_font_size, params.text_color,
+                    std::string_view(label, res.ptr - label), ChartCanvas::Anchor::End);
+
+        for (size_t i = 0; i < palette.size(); ++i) {
+            canvas.rect(params.left_margin + static_cast<int>(i) * step, top, step, 18, palette[i], "none", 0);
         }
+        canvas.rect(params.left_margin, top, bar_right - params.left_margin, 18, "none", params.text_color,
+                    params.legend_border_width);
+
+        res = std::to_chars(label, label + sizeof(label), static_cast<double>(max_val), std::chars_format::fixed, 1);
+        canvas.text(bar_right + 10, top + 14, params.tick_font_size, params.text_color,
+                    std::string_view(label, res.ptr - label));
+        canvas.text(bar_right + 90, top + 14, params.legend_font_size, params.text_color, y_label);
     }
 
-    void drawLegend(std::stringstream& svg, const std::vector<std::string>& core_order) {
+    void drawLegend(ChartCanvas& canvas, const std::vector<std::string>& core_order) {
         int legend_top = params.chart_bottom + 40;
         int item_width = (params.width - params.left_margin - params.right_margin) / params.legend_items_per_row;
 
@@ -497,15 +1242,10 @@ private:
             const auto& color = core_colors[core];
 
             // 颜色方块
-            svg << "  <rect x=\"" << x << "\" y=\"" << y
-                << "\" width=\"25\" height=\"18\" fill=\"" << color
-                << "\" stroke=\"" << params.text_color
-                << "\" stroke-width=\"" << params.legend_border_width << "\"/>\n";
+            canvas.rect(x, y, 25, 18, color, params.text_color, params.legend_border_width);
 
             // 图例文字
-            svg << "  <text x=\"" << (x + 30) << "\" y=\"" << (y + 14)
-                << "\" font-size=\"" << params.legend_font_size << "\" fill=\""
-                << params.text_color << "\">" << core << "</text>\n";
+            canvas.text(x + 30, y + 14, params.legend_font_size, params.text_color, core);
         }
     }
 
@@ -521,18 +1261,15 @@ private:
         return params.chart_bottom - static_cast<int>(ratio * chart_height);
     }
 
-    std::string formatTime(uint64_t ms) {
+    std::string_view formatTime(char (&buf)[32], uint64_t ms) {  // m:ss
         int total_seconds = static_cast<int>(ms / 1000);
         int minutes = total_seconds / 60;
         int seconds = total_seconds % 60;
-        return std::to_string(minutes) + ":" +
-               (seconds < 10 ? "0" : "") + std::to_string(seconds);
-    }
-
-    std::string formatValue(float value) {
-        std::ostringstream oss;
-        oss << std::fixed << std::setprecision(1) << value;
-        return oss.str();
+        char* p = std::to_chars(buf, buf + 20, minutes).ptr;
+        *p++ = ':';
+        if (seconds < 10) *p++ = '0';
+        p = std::to_chars(p, buf + sizeof(buf), seconds).ptr;
+        return std::string_view(buf, p - buf);
     }
 
     uint64_t chooseTimeTickInterval(uint64_t time_range_ms) {
@@ -573,4 +1310,80 @@ private:
             return nice_intervals.front();
         }
     }
-};
\ No newline at end of file
+};
+
+class SVGDocument {  //将多个图表纵向拼合成一个svg，图表直接写进文档缓冲，不做中间拷贝
+public:
+    SVGDocument(size_t chart_count,
+                double svgWidth, double svgHeight,
+                double spacing = 0.0,
+                const std::string& title = "",
+                const std::string& timestamp = "",
+                size_t reserve_bytes = 1 << 20)
+        : out_(reserve_bytes), chart_count_(chart_count), svg_height_(svgHeight), spacing_(spacing) {
+        if (chart_count == 0) return;  //没有图表时输出为空
+
+        if (!title.empty() || !timestamp.empty()) {
+            header_height_ = 150;
+        }
+
+        double totalHeight = header_height_ + svgHeight * chart_count + spacing * (chart_count - 1);
+
+        out_ << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+        out_ << "<svg xmlns=\"http://www.w3.org/2000/svg\" "
+             << "viewBox=\"0 0 " << svgWidth << " " << totalHeight << "\" "
+             << "width=\"" << svgWidth << "\" height=\"" << totalHeight << "\">\n";
+
+        out_ << "  <rect width=\"100%\" height=\"100%\" fill=\"white\"/>\n";
+
+        if (!title.empty() || !timestamp.empty()) {  //尝试添加标题
+            out_ << "  <!-- Header Section -->\n";
+            out_ << "  <g font-family=\"Arial, sans-serif\">\n";
+
+            if (!title.empty()) {
+                out_ << "    <text x=\"" << 100 << "\" y=\"55\" font-size=\"48\" font-weight=\"bold\">"
+                     << title << "</text>\n";
+            }
+
+            if (!timestamp.empty()) {
+                out_ << "    <text x=\"" << 100 << "\" y=\"85\" font-size=\"30\" fill=\"#666\">"
+                     << timestamp << "</text>\n";
+            }
+
+            out_ << "  </g>\n";
+        }
+    }
+
+    SvgBuffer& beginChart() {  //返回的缓冲交给绘图器追加图表内容
+        double yPosition = header_height_ + chart_index_ * (svg_height_ + spacing_);
+        out_ << "  <g transform=\"translate(0 " << yPosition << ")\">\n";
+        return out_;
+    }
+
+    void endChart() {
+        out_ << "\n  </g>\n";
+        ++chart_index_;
+    }
+
+    void appendChart(const SvgBuffer& chart) {  //并行渲染好的图表按顺序拼入
+        beginChart() << chart.str();
+        endChart();
+    }
+
+    void reserve(size_t bytes) { out_.reserve(bytes); }
+
+    const SvgBuffer& finish() {
+        if (chart_count_ > 0) out_ << "</svg>";
+        return out_;
+    }
+
+    std::string release() { return out_.release(); }  // finish之后取走内容
+
+private:
+    SvgBuffer out_;
+    size_t chart_count_;
+    size_t chart_index_ = 0;
+    double header_height_ = 0;
+    double svg_height_;
+    double spacing_;
+};
@@ -0,0 +1,548 @@
+#pragma once
+#include "SvgBuffer.hpp"
+#include "draw_svg.hpp"
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+//交互式网页报告：数据紧凑编码后嵌入单个html，用canvas绘制，离线可用
+//时间轴和数值都是 zigzag差分 + 变长整数，再base64；数值按scale量化
+//页面按当前缩放窗口逐像素列抽稀(首/最低/最高/末)，所有图表共享时间窗口和光标
+
+namespace html_report {
+
+constexpr double VALUE_SCALE = 1000.0;  // 数值保留3位小数
+
+void putVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+void putZigzag(std::string& out, int64_t value) {
+    putVarint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+int64_t quantize(float value) {
+    double scaled = static_cast<double>(value) * VALUE_SCALE;
+    if (!std::isfinite(scaled)) return 0;
+    scaled = std::max(-9e15, std::min(9e15, scaled));
+    return std::llround(scaled);
+}
+
+void appendBase64(SvgBuffer& out, const std::string& bytes) {
+    static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    char quad[4];
+    size_t i = 0;
+    for (; i + 3 <= bytes.size(); i += 3) {
+        uint32_t n = (static_cast<uint8_t>(bytes[i]) << 16) | (static_cast<uint8_t>(bytes[i + 1]) << 8) |
+                     static_cast<uint8_t>(bytes[i + 2]);
+        quad[0] = table[n >> 18];
+        quad[1] = table[(n >> 12) & 63];
+        quad[2] = table[(n >> 6) & 63];
+        quad[3] = table[n & 63];
+        out << std::string_view(quad, 4);
+    }
+    if (i < bytes.size()) {
+        uint32_t n = static_cast<uint8_t>(bytes[i]) << 16;
+        if (i + 1 < bytes.size()) n |= static_cast<uint8_t>(bytes[i + 1]) << 8;
+        quad[0] = table[n >> 18];
+        quad[1] = table[(n >> 12) & 63];
+        quad[2] = i + 1 < bytes.size() ? table[(n >> 6) & 63] : '=';
+        quad[3] = '=';
+        out << std::string_view(quad, 4);
+    }
+}
+
+void appendJsString(SvgBuffer& out, const std::string& str) {  //可以直接放进<script>的字符串字面量
+    out << '"';
+    for (size_t i = 0; i < str.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(str[i]);
+        switch (c) {
+        case '"': out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+        case '\n': out << "\\n"; break;
+        case '\r': out << "\\r"; break;
+        case '\t': out << "\\t"; break;
+        case '<': out << "\\u003c"; break;  // 防止出现</script>
+        default:
+            if (c < 0x20) {
+                static const char hex[] = "0123456789abcdef";
+                out << "\\u00" << hex[c >> 4] << hex[c & 15];
+            } else if (c == 0xe2 && i + 2 < str.size() && static_cast<unsigned char>(str[i + 1]) == 0x80 &&
+                       (static_cast<unsigned char>(str[i + 2]) & 0xfe) == 0xa8) {  // U+2028/U+2029
+                out << (str[i + 2] == '\xa8' ? "\\u2028" : "\\u2029");
+                i += 2;
+            } else {
+                out << static_cast<char>(c);
+            }
+        }
+    }
+    out << '"';
+}
+
+// 每条序列：采样数、段数、hold，然后每段 与上一段末尾的间隔、长度、各值的差分
+void encodeSeries(std::string& out, const SVGFreqPlotter::SparseSeries& series) {
+    putVarint(out, series.values.size());
+    putVarint(out, series.segments.size());
+    putVarint(out, series.hold ? 1 : 0);
+
+    uint32_t end = 0;
+    int64_t prev = 0;
+    for (const auto& seg : series.segments) {
+        putVarint(out, seg.first_frame - end);
+        putVarint(out, seg.count);
+        for (uint32_t k = 0; k < seg.count; ++k) {
+            int64_t q = quantize(series.values[seg.offset + k]);
+            putZigzag(out, q - prev);
+            prev = q;
+        }
+        end = seg.first_frame + seg.count;
+    }
+}
+
+void appendChart(SvgBuffer& out, const ChartSpec& chart) {
+    const auto& style = chart.style;
+    const auto& data = chart.data;
+
+    std::vector<std::string> names = style.order;  //先按svg的顺序，其余序列默认隐藏
+    size_t shown = names.size();
+    std::set<std::string> listed(names.begin(), names.end());
+    for (const auto& [name, series] : data.series) {
+        if (listed.insert(name).second) names.push_back(name);
+    }
+    if (style.order.empty()) shown = names.size();
+
+    out << "{title:";
+    appendJsString(out, chart.title);
+    out << ",label:";
+    appendJsString(out, style.label);
+    out << ",unit:";
+    appendJsString(out, chart.y_label);
+    out << ",min:";
+    if (style.use_custom_range && style.use_custom_min_range) {
+        out << style.custom_min_value;
+    } else {
+        out << "null";
+    }
+    out << ",max:";
+    if (style.use_custom_range && style.use_custom_max_range) {
+        out << style.custom_max_value;
+    } else {
+        out << "null";
+    }
+    out << ",ticks:[";
+    for (size_t i = 0; i < style.ticks.size(); ++i) {
+        if (i) out << ',';
+        out << style.ticks[i];
+    }
+    out << "],scale:" << VALUE_SCALE << ",shown:" << shown << ",names:[";
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (i) out << ',';
+        appendJsString(out, names[i]);
+    }
+    out << "],\n t:\"";
+
+    std::string bytes;
+    putVarint(bytes, data.time_ms.size());
+    int64_t prev = 0;
+    for (uint64_t t : data.time_ms) {
+        putZigzag(bytes, static_cast<int64_t>(t) - prev);
+        prev = static_cast<int64_t>(t);
+    }
+    appendBase64(out, bytes);
+    out << "\",\n v:\"";
+
+    static const SVGFreqPlotter::SparseSeries empty;
+    bytes.clear();
+    for (const auto& name : names) {
+        auto it = data.series.find(name);
+        encodeSeries(bytes, it != data.series.end() ? it->second : empty);
+    }
+    appendBase64(out, bytes);
+    out << "\"}";
+}
+
+const char* const PAGE_HEAD = R"HTML(<!DOCTYPE html>
+<html lang="zh-CN">
+<head>
+<meta charset="utf-8">
+<meta name="viewport" content="width=device-width, initial-scale=1">
+<title>report</title>
+<style>
+body{margin:0;font:14px Arial,sans-serif;color:#000;background:#fff}
+header{position:sticky;top:0;z-index:2;padding:12px 24px;background:#fff;border-bottom:1px solid #ddd}
+header h1{margin:0;font-size:28px}
+header .time{color:#666}
+header .hint{float:right;color:#888;font-size:12px;margin-top:8px}
+.chart{padding:12px 24px 4px}
+.chart h2{display:inline;margin:0;font-size:20px}
+.chart .label{color:#555;font-size:13px;margin-left:10px}
+.plot{position:relative;height:320px;margin-top:6px;cursor:crosshair}
+.plot canvas{position:absolute;left:0;top:0;width:100%;height:100%}
+.readout{position:absolute;right:24px;top:16px;display:none;padding:4px 8px;font-size:12px;background:rgba(255,255,255,.92);border:1px solid #ccc;pointer-events:none;white-space:nowrap}
+.readout i,.legend i{display:inline-block;width:14px;height:10px;margin-right:4px;vertical-align:middle}
+.legend{font-size:12px;margin-top:4px}
+.legend span{display:inline-block;margin:2px 12px 2px 0;cursor:pointer;user-select:none}
+.legend span.off{opacity:.35}
+.legend summary{cursor:pointer;color:#555}
+</style>
+</head>
+<body>
+<header><span class="hint">滚轮缩放 · 拖动平移 · 双击还原 · 点击图例显示/隐藏</span><h1 id="title"></h1><div class="time" id="time"></div></header>
+<div id="charts"></div>
+<script>
+)HTML";
+
+const char* const PAGE_TAIL = R"HTML(
+(function () {
+  "use strict";
+  var R = REPORT, PAL = R.palette;
+  var M = {left: 64, right: 16, top: 10, bottom: 26};  // 绘图区边距，CSS像素
+  var TIME_STEPS = [100, 200, 500, 1000, 2000, 5000, 10000, 15000, 30000, 60000, 120000, 300000,
+                    600000, 900000, 1800000, 3600000, 7200000, 14400000, 43200000, 86400000];
+
+  document.title = R.title || "report";
+  document.getElementById("title").textContent = R.title;
+  document.getElementById("time").textContent = R.time;
+
+  function bytes(s) {
+    var b = atob(s), u = new Uint8Array(b.length);
+    for (var i = 0; i < b.length; i++) u[i] = b.charCodeAt(i);
+    return u;
+  }
+  function Reader(u) { this.u = u; this.p = 0; }
+  Reader.prototype.uv = function () {
+    var r = 0, m = 1, b;
+    do { b = this.u[this.p++]; r += (b & 127) * m; m *= 128; } while (b & 128);
+    return r;
+  };
+  Reader.prototype.sv = function () { var r = this.uv(); return r % 2 ? -(r + 1) / 2 : r / 2; };
+
+  function decode(c) {
+    var tr = new Reader(bytes(c.t)), n = tr.uv(), acc = 0;
+    c.time = new Float64Array(n);
+    for (var i = 0; i < n; i++) { acc += tr.sv(); c.time[i] = acc; }
+    var vr = new Reader(bytes(c.v));
+    c.series = c.names.map(function (name, k) {
+      var total = vr.uv(), segs = vr.uv(), hold = vr.uv() === 1;
+      var idx = new Uint32Array(total), val = new Float32Array(total), frame = 0, q = 0, j = 0;
+      for (var s = 0; s < segs; s++) {
+        frame += vr.uv();
+        var cnt = vr.uv();
+        for (var e = 0; e < cnt; e++, j++) { idx[j] = frame++; q += vr.sv(); val[j] = q / c.scale; }
+      }
+      return {name: name, idx: idx, val: val, hold: hold, color: PAL[k % PAL.length], on: k < c.shown};
+    });
+    delete c.t;
+    delete c.v;
+  }
+
+  function lowerBound(a, x) {
+    var lo = 0, hi = a.length;
+    while (lo < hi) { var m = (lo + hi) >> 1; if (a[m] < x) lo = m + 1; else hi = m; }
+    return lo;
+  }
+  function valueAt(s, i) {  // 缺失的帧：hold沿用上一个采样，否则为0
+    var j = lowerBound(s.idx, i);
+    if (j < s.idx.length && s.idx[j] === i) return s.val[j];
+    return s.hold && j > 0 ? s.val[j - 1] : 0;
+  }
+  function walk(s, i0, i1, fn) {
+    var j = lowerBound(s.idx, i0), gap = s.hold && j > 0 ? s.val[j - 1] : 0, v;
+    for (var i = i0; i <= i1; i++) {
+      if (j < s.idx.length && s.idx[j] === i) { v = s.val[j++]; if (s.hold) gap = v; } else v = gap;
+      fn(i, v);
+    }
+  }
+  function fmtTime(ms, fine) {
+    var sec = Math.floor(ms / 1000), m = Math.floor(sec / 60), s = sec % 60;
+    var str = m + ":" + (s < 10 ? "0" : "") + s;
+    return fine ? str + "." + Math.floor((ms % 1000) / 100) : str;
+  }
+  function fmtValue(v) { return Math.abs(v) < 10 ? v.toFixed(2) : v.toFixed(1); }
+
+  R.charts.forEach(decode);
+  var full0 = Infinity, full1 = -Infinity;
+  R.charts.forEach(function (c) {
+    if (!c.time.length) return;
+    full0 = Math.min(full0, c.time[0]);
+    full1 = Math.max(full1, c.time[c.time.length - 1]);
+  });
+  if (!isFinite(full0)) { full0 = 0; full1 = 1; }
+  if (full1 <= full0) full1 = full0 + 1;
+  var v0 = full0, v1 = full1, cursor = null, drag = null, pending = false;
+
+  var root = document.getElementById("charts");
+  var views = R.charts.map(function (c) {
+    var box = document.createElement("div"); box.className = "chart";
+    var h = document.createElement("h2"); h.textContent = c.title; box.appendChild(h);
+    var lb = document.createElement("span"); lb.className = "label";
+    lb.textContent = (c.label ? c.label + " · " : "") + c.unit; box.appendChild(lb);
+    var plot = document.createElement("div"); plot.className = "plot"; box.appendChild(plot);
+    var base = document.createElement("canvas"), over = document.createElement("canvas");
+    plot.appendChild(base); plot.appendChild(over);
+    var readout = document.createElement("div"); readout.className = "readout"; plot.appendChild(readout);
+    var view = {c: c, base: base, over: over, readout: readout, dirty: true, pw: 1, ph: 1, lo: 0, hi: 1};
+
+    var legend = document.createElement("div"); legend.className = "legend"; box.appendChild(legend);
+    var rest = null;
+    c.series.forEach(function (s, k) {
+      var item = document.createElement("span");
+      var sw = document.createElement("i"); sw.style.background = s.color;
+      item.appendChild(sw); item.appendChild(document.createTextNode(s.name));
+      if (!s.on) item.className = "off";
+      item.onclick = function () { s.on = !s.on; item.className = s.on ? "" : "off"; view.dirty = true; schedule(); };
+      if (k < c.shown) { legend.appendChild(item); return; }
+      if (!rest) {
+        rest = document.createElement("details");
+        var sum = document.createElement("summary");
+        sum.textContent = "其余 " + (c.series.length - c.shown) + " 条";
+        rest.appendChild(sum); legend.appendChild(rest);
+      }
+      rest.appendChild(item);
+    });
+
+    over.addEventListener("mousemove", function (e) {
+      var x = e.clientX - over.getBoundingClientRect().left;
+      if (drag) {
+        var dt = (e.clientX - drag.x) / view.pw * (drag.v1 - drag.v0);
+        setView(drag.v0 - dt, drag.v1 - dt);
+        return;
+      }
+      cursor = v0 + (x - M.left) / view.pw * (v1 - v0);
+      schedule();
+    });
+    over.addEventListener("mouseleave", function () { cursor = null; schedule(); });
+    over.addEventListener("mousedown", function (e) { drag = {x: e.clientX, v0: v0, v1: v1}; e.preventDefault(); });
+    over.addEventListener("dblclick", function () { setView(full0, full1); });
+    over.addEventListener("wheel", function (e) {
+      e.preventDefault();
+      var x = e.clientX - over.getBoundingClientRect().left;
+      var t = v0 + (x - M.left) / view.pw * (v1 - v0);
+      var span = Math.min(full1 - full0, Math.max(100, (v1 - v0) * (e.deltaY < 0 ? 0.8 : 1.25)));
+      var start = t - (t - v0) * span / (v1 - v0);
+      setView(start, start + span);
+    }, {passive: false});
+
+    root.appendChild(box);
+    return view;
+  });
+  window.addEventListener("mouseup", function () { drag = null; });
+  window.addEventListener("resize", function () { views.forEach(function (v) { v.dirty = true; }); schedule(); });
+
+  function setView(a, b) {  // 所有图表共用一个时间窗口
+    var span = b - a;
+    if (a < full0) { a = full0; b = a + span; }
+    if (b > full1) { b = full1; a = Math.max(full0, b - span); }
+    v0 = a; v1 = b;
+    views.forEach(function (v) { v.dirty = true; });
+    schedule();
+  }
+  function schedule() {
+    if (pending) return;
+    pending = true;
+    requestAnimationFrame(function () {
+      pending = false;
+      views.forEach(function (v) {
+        var r = v.base.getBoundingClientRect();
+        if (r.bottom < 0 || r.top > window.innerHeight) return;  // 只画可见的图表
+        if (v.dirty) { drawBase(v); v.dirty = false; }
+        drawOverlay(v);
+      });
+    });
+  }
+  window.addEventListener("scroll", schedule);
+
+  function frameRange(c) {  // 窗口内的帧，两侧各多取一帧保证线条连续
+    return [Math.max(0, lowerBound(c.time, v0) - 1), Math.min(c.time.length - 1, lowerBound(c.time, v1))];
+  }
+  function fit(cv) {
+    var dpr = window.devicePixelRatio || 1, w = cv.clientWidth, h = cv.clientHeight;
+    if (cv.width !== Math.round(w * dpr) || cv.height !== Math.round(h * dpr)) {
+      cv.width = Math.round(w * dpr); cv.height = Math.round(h * dpr);
+    }
+    var g = cv.getContext("2d");
+    g.setTransform(dpr, 0, 0, dpr, 0, 0);
+    g.clearRect(0, 0, w, h);
+    return g;
+  }
+  function niceStep(raw) {
+    var mag = Math.pow(10, Math.floor(Math.log10(raw))), r = raw / mag;
+    return (r <= 1 ? 1 : r <= 2 ? 2 : r <= 5 ? 5 : 10) * mag;
+  }
+
+  function drawBase(view) {
+    var c = view.c, g = fit(view.base), w = view.base.clientWidth, h = view.base.clientHeight;
+    var pw = view.pw = Math.max(1, w - M.left - M.right), ph = view.ph = Math.max(1, h - M.top - M.bottom);
+    var range = c.time.length ? frameRange(c) : [0, -1], i0 = range[0], i1 = range[1];
+
+    var lo = Infinity, hi = -Infinity;  // 自动量程只看窗口内显示的序列
+    if (c.min === null || c.max === null) {
+      c.series.forEach(function (s) {
+        if (s.on) walk(s, i0, i1, function (i, v) { if (v < lo) lo = v; if (v > hi) hi = v; });
+      });
+    }
+    if (lo === Infinity) { lo = 0; hi = 1; }
+    var margin = Math.max(0.1, (hi - lo) * 0.1);
+    lo = c.min !== null ? c.min : Math.max(0, lo - margin);
+    hi = c.max !== null ? c.max : hi + margin;
+    if (hi <= lo) hi = lo + 1;
+    view.lo = lo; view.hi = hi;
+
+    var X = function (t) { return M.left + (t - v0) / (v1 - v0) * pw; };
+    var Y = function (v) { return M.top + ph - (v - lo) / (hi - lo) * ph; };
+
+    g.font = "12px Arial"; g.fillStyle = "#000"; g.lineWidth = 1;
+    var step = niceStep((hi - lo) / 5), digits = Math.max(0, Math.min(3, -Math.floor(Math.log10(step))));
+    g.textAlign = "right"; g.textBaseline = "middle";
+    for (var v = Math.ceil(lo / step) * step; v <= hi + step * 1e-6; v += step) {
+      var y = Math.round(Y(v)) + 0.5;
+      g.strokeStyle = "#E0E0E0"; g.beginPath(); g.moveTo(M.left, y); g.lineTo(M.left + pw, y); g.stroke();
+      g.fillText(v.toFixed(digits), M.left - 6, y);
+    }
+    g.setLineDash([4, 4]); g.strokeStyle = "#BBBBBB";
+    c.ticks.forEach(function (v) {
+      if (v <= lo || v >= hi) return;
+      var y = Math.round(Y(v)) + 0.5;
+      g.beginPath(); g.moveTo(M.left, y); g.lineTo(M.left + pw, y); g.stroke();
+      g.fillText(String(v), M.left - 6, y);
+    });
+    g.setLineDash([]);
+
+    var interval = TIME_STEPS[TIME_STEPS.length - 1];
+    for (var k = 0; k < TIME_STEPS.length; k++) {
+      if (TIME_STEPS[k] / (v1 - v0) * pw >= 90) { interval = TIME_STEPS[k]; break; }
+    }
+    g.textAlign = "center"; g.textBaseline = "top";
+    for (var t = Math.ceil(v0 / interval) * interval; t <= v1; t += interval) {
+      var x = Math.round(X(t)) + 0.5;
+      g.strokeStyle = "#E0E0E0"; g.beginPath(); g.moveTo(x, M.top); g.lineTo(x, M.top + ph); g.stroke();
+      g.fillText(fmtTime(t, interval < 1000), x, M.top + ph + 6);
+    }
+    g.strokeStyle = "#333333"; g.lineWidth = 1.5; g.strokeRect(M.left, M.top, pw, ph);
+
+    g.save();
+    g.beginPath(); g.rect(M.left, M.top, pw, ph); g.clip();
+    g.lineWidth = 1.5; g.globalAlpha = 0.8; g.lineJoin = "round";
+    for (var n = c.series.length - 1; n >= 0; n--) {  // 与svg相同，排在前面的画在上层
+      var s = c.series[n];
+      if (!s.on) continue;
+      g.strokeStyle = s.color;
+      g.beginPath();
+      trace(g, c, s, i0, i1, X, Y);
+      g.stroke();
+    }
+    g.restore();
+  }
+
+  // 按像素列抽稀：一列只有一个点时原样连线，多个点时画 首/最低/最高/末
+  function trace(g, c, s, i0, i1, X, Y) {
+    var col = null, fx = 0, first = 0, last = 0, mn = 0, mx = 0, n = 0, started = false;
+    function to(x, v) { if (started) g.lineTo(x, Y(v)); else { g.moveTo(x, Y(v)); started = true; } }
+    function flush() {
+      if (!n) return;
+      if (n === 1) { to(fx, first); return; }
+      to(col, first); to(col, mn); to(col, mx); to(col, last);
+    }
+    walk(s, i0, i1, function (i, v) {
+      var x = X(c.time[i]), cx = Math.floor(x) + 0.5;
+      if (cx !== col) { flush(); col = cx; fx = x; first = mn = mx = last = v; n = 1; return; }
+      if (v < mn) mn = v;
+      if (v > mx) mx = v;
+      last = v; n++;
+    });
+    flush();
+  }
+
+  function drawOverlay(view) {
+    var c = view.c, g = fit(view.over), box = view.readout;
+    if (cursor === null || !c.time.length || cursor < v0 || cursor > v1) { box.style.display = "none"; return; }
+
+    var i = lowerBound(c.time, cursor);  // 最近的一帧
+    if (i >= c.time.length || (i > 0 && cursor - c.time[i - 1] < c.time[i] - cursor)) i--;
+    var X = function (t) { return M.left + (t - v0) / (v1 - v0) * view.pw; };
+    var Y = function (v) { return M.top + view.ph - (v - view.lo) / (view.hi - view.lo) * view.ph; };
+    var x = Math.round(X(cursor)) + 0.5;
+    g.strokeStyle = "#CC0000"; g.lineWidth = 1;
+    g.beginPath(); g.moveTo(x, M.top); g.lineTo(x, M.top + view.ph); g.stroke();
+
+    var rows = [];
+    c.series.forEach(function (s) { if (s.on) rows.push({s: s, v: valueAt(s, i)}); });
+    rows.sort(function (a, b) { return b.v - a.v; });
+    var more = rows.length - 10;
+    rows = rows.slice(0, 10);
+
+    var fx = X(c.time[i]);
+    rows.forEach(function (r) {
+      g.fillStyle = r.s.color;
+      g.beginPath(); g.arc(fx, Y(r.v), 3, 0, 2 * Math.PI); g.fill();
+    });
+
+    box.textContent = "";
+    var head = document.createElement("div"); head.textContent = fmtTime(c.time[i], true); box.appendChild(head);
+    rows.forEach(function (r) {
+      var line = document.createElement("div"), sw = document.createElement("i");
+      sw.style.background = r.s.color;
+      line.appendChild(sw); line.appendChild(document.createTextNode(r.s.name + "  " + fmtValue(r.v)));
+      box.appendChild(line);
+    });
+    if (more > 0) { var tail = document.createElement("div"); tail.textContent = "… 另有 " + more + " 条"; box.appendChild(tail); }
+    box.style.display = "block";
+  }
+
+  schedule();
+})();
+</script>
+</body>
+</html>
+)HTML";
+
+}  // namespace html_report
+
+// 数据和绘图脚本都在一个页面里
+std::string render_html(const std::vector<ChartSpec>& charts, const std::string& title, const std::string& time) {
+    SvgBuffer out(1 << 20);
+    out << html_report::PAGE_HEAD;
+
+    out << "var REPORT = {title:";
+    html_report::appendJsString(out, title);
+    out << ",time:";
+    html_report::appendJsString(out, time);
+    out << ",palette:[";
+    const auto& palette = SVGFreqPlotter::colorPalette();
+    for (size_t i = 0; i < palette.size(); ++i) {
+        if (i) out << ',';
+        html_report::appendJsString(out, palette[i]);
+    }
+    out << "],charts:[\n";
+    bool first = true;
+    for (const auto& chart : charts) {  //热力图在网页里仍按折线交互，只有驻留这类不能画成折线的跳过
+        if (!chart.line_view) continue;
+        if (!first) out << ",\n";
+        first = false;
+        html_report::appendChart(out, chart);
+    }
+    out << "]};\n";
+
+    out << html_report::PAGE_TAIL;
+    return out.release();
+}
+
+// 输出 pkg.html
+void draw_html(const std::vector<ChartSpec>& charts, const std::string& title, const std::string& time,
+               const std::string& pkg) {
+    std::string filename = pkg + ".html";
+    if (!writeFileAtomic(filename, render_html(charts, title, time))) {
+        std::cerr << "无法写入 " << filename << std::endl;
+        return;
+    }
+
+    std::cout << "网页报告已生成" << std::endl;
+}
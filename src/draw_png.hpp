@@ -0,0 +1,635 @@
+#pragma once
+#include "PngWriter.hpp"
+#include "draw_svg.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+//内置光栅化：不经过外部svg渲染器直接输出png
+//线条按到线段的距离算覆盖率(抗锯齿)，同一条折线先合并进覆盖率蒙版再一次性混合，交点处不会叠深
+//文字用5x8点阵字体，只有ASCII字形：图表里固定的中文词先换成英文，其它非ASCII字符(进程名、标记名)画成空心方框
+namespace png_report {
+
+// 0x20..0x7E，每个字符5列，每列一个字节，低位在上；第7位是下伸部
+static const uint8_t FONT_5X8[95][5] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00}, {0x00, 0x00, 0x5F, 0x00, 0x00}, {0x00, 0x07, 0x00, 0x07, 0x00},
+    {0x14, 0x7F, 0x14, 0x7F, 0x14}, {0x24, 0x2A, 0x7F, 0x2A, 0x12}, {0x23, 0x13, 0x08, 0x64, 0x62},
+    {0x36, 0x49, 0x56, 0x20, 0x50}, {0x00, 0x08, 0x07, 0x03, 0x00}, {0x00, 0x1C, 0x22, 0x41, 0x00},
+    {0x00, 0x41, 0x22, 0x1C, 0x00}, {0x2A, 0x1C, 0x7F, 0x1C, 0x2A}, {0x08, 0x08, 0x3E, 0x08, 0x08},
+    {0x00, 0x80, 0x70, 0x30, 0x00}, {0x08, 0x08, 0x08, 0x08, 0x08}, {0x00, 0x00, 0x60, 0x60, 0x00},
+    {0x20, 0x10, 0x08, 0x04, 0x02}, {0x3E, 0x51, 0x49, 0x45, 0x3E}, {0x00, 0x42, 0x7F, 0x40, 0x00},
+    {0x72, 0x49, 0x49, 0x49, 0x46}, {0x21, 0x41, 0x49, 0x4D, 0x33}, {0x18, 0x14, 0x12, 0x7F, 0x10},
+    {0x27, 0x45, 0x45, 0x45, 0x39}, {0x3C, 0x4A, 0x49, 0x49, 0x31}, {0x41, 0x21, 0x11, 0x09, 0x07},
+    {0x36, 0x49, 0x49, 0x49, 0x36}, {0x46, 0x49, 0x49, 0x29, 0x1E}, {0x00, 0x00, 0x14, 0x00, 0x00},
+    {0x00, 0x40, 0x34, 0x00, 0x00}, {0x00, 0x08, 0x14, 0x22, 0x41}, {0x14, 0x14, 0x14, 0x14, 0x14},
+    {0x00, 0x41, 0x22, 0x14, 0x08}, {0x02, 0x01, 0x59, 0x09, 0x06}, {0x3E, 0x41, 0x5D, 0x59, 0x4E},
+    {0x7C, 0x12, 0x11, 0x12, 0x7C}, {0x7F, 0x49, 0x49, 0x49, 0x36}, {0x3E, 0x41, 0x41, 0x41, 0x22},
+    {0x7F, 0x41, 0x41, 0x41, 0x3E}, {0x7F, 0x49, 0x49, 0x49, 0x41}, {0x7F, 0x09, 0x09, 0x09, 0x01},
+    {0x3E, 0x41, 0x41, 0x51, 0x73}, {0x7F, 0x08, 0x08, 0x08, 0x7F}, {0x00, 0x41, 0x7F, 0x41, 0x00},
+    {0x20, 0x40, 0x41, 0x3F, 0x01}, {0x7F, 0x08, 0x14, 0x22, 0x41}, {0x7F, 0x40, 0x40, 0x40, 0x40},
+    {0x7F, 0x02, 0x1C, 0x02, 0x7F}, {0x7F, 0x04, 0x08, 0x10, 0x7F}, {0x3E, 0x41, 0x41, 0x41, 0x3E},
+    {0x7F, 0x09, 0x09, 0x09, 0x06}, {0x3E, 0x41, 0x51, 0x21, 0x5E}, {0x7F, 0x09, 0x19, 0x29, 0x46},
+    {0x26, 0x49, 0x49, 0x49, 0x32}, {0x03, 0x01, 0x7F, 0x01, 0x03}, {0x3F, 0x40, 0x40, 0x40, 0x3F},
+    {0x1F, 0x20, 0x40, 0x20, 0x1F}, {0x3F, 0x40, 0x38, 0x40, 0x3F}, {0x63, 0x14, 0x08, 0x14, 0x63},
+    {0x03, 0x04, 0x78, 0x04, 0x03}, {0x61, 0x59, 0x49, 0x4D, 0x43}, {0x00, 0x7F, 0x41, 0x41, 0x41},
+    {0x02, 0x04, 0x08, 0x10, 0x20}, {0x00, 0x41, 0x41, 0x41, 0x7F}, {0x04, 0x02, 0x01, 0x02, 0x04},
+    {0x40, 0x40, 0x40, 0x40, 0x40}, {0x00, 0x03, 0x07, 0x08, 0x00}, {0x20, 0x54, 0x54, 0x78, 0x40},
+    {0x7F, 0x28, 0x44, 0x44, 0x38}, {0x38, 0x44, 0x44, 0x44, 0x28}, {0x38, 0x44, 0x44, 0x28, 0x7F},
+    {0x38, 0x54, 0x54, 0x54, 0x18}, {0x00, 0x08, 0x7E, 0x09, 0x02}, {0x18, 0xA4, 0xA4, 0x9C, 0x78},
+    {0x7F, 0x08, 0x04, 0x04, 0x78}, {0x00, 0x44, 0x7D, 0x40, 0x00}, {0x20, 0x40, 0x40, 0x3D, 0x00},
+    {0x7F, 0x10, 0x28, 0x44, 0x00}, {0x00, 0x41, 0x7F, 0x40, 0x00}, {0x7C, 0x04, 0x78, 0x04, 0x78},
+    {0x7C, 0x08, 0x04, 0x04, 0x78}, {0x38, 0x44, 0x44, 0x44, 0x38}, {0xFC, 0x18, 0x24, 0x24, 0x18},
+    {0x18, 0x24, 0x24, 0x18, 0xFC}, {0x7C, 0x08, 0x04, 0x04, 0x08}, {0x48, 0x54, 0x54, 0x54, 0x24},
+    {0x04, 0x04, 0x3F, 0x44, 0x24}, {0x3C, 0x40, 0x40, 0x20, 0x7C}, {0x1C, 0x20, 0x40, 0x20, 0x1C},
+    {0x3C, 0x40, 0x30, 0x40, 0x3C}, {0x44, 0x28, 0x10, 0x28, 0x44}, {0x4C, 0x90, 0x90, 0x90, 0x7C},
+    {0x44, 0x64, 0x54, 0x4C, 0x44}, {0x00, 0x08, 0x36, 0x41, 0x00}, {0x00, 0x00, 0x77, 0x00, 0x00},
+    {0x00, 0x41, 0x36, 0x08, 0x00}, {0x02, 0x01, 0x02, 0x04, 0x02}};
+
+// 图表标题、坐标轴、图例里出现的中文词，按最长匹配替换；格式化出来的标题(如"功耗  平均1.2W")逐词替换
+static const std::pair<std::string_view, std::string_view> ASCII_TERMS[] = {
+    {"每行一个线程，颜色为平均负载", "One row per thread, color = avg load"},
+    {"每行一个核心，颜色为平均负载", "One row per core, color = avg load"},
+    {"每行一个频点，颜色为处于该频点的时间占比", "One row per frequency, color = share of time"},
+    {"按cgroup/cpuset分组的线程负载之和", "Sum of thread load per cgroup/cpuset"},
+    {"按进程堆叠，其他为这些核心上的其余负载", "Stacked by process, Other = rest of the load on these cores"},
+    {"游戏内按线程名(去掉编号)汇总", "Game threads summed by name (numbers stripped)"},
+    {"整机，kswapd扫描为页数", "System-wide, kswapd scan in pages"},
+    {"目标进程各项相加", "Sum over target processes"},
+    {"缺页与内存回收", "Page faults & reclaim"},
+    {"线程负载", "Thread load"},
+    {"调度分组", "sched groups"},
+    {"频率驻留", "Frequency residency"},
+    {"负载构成", "Load breakdown"},
+    {"线程组", "thread groups"},
+    {"负载(单核%)", "Load(% of one core)"},
+    {"CPU负载", "CPU load"},
+    {"CPU温度", "CPU temperature"},
+    {"帧率(FPS)", "FPS"},
+    {"平均帧率", "Avg FPS"},
+    {"平均功耗", "Avg power"},
+    {"平均缺页", "avg faults "},
+    {"最高温度", "Max temp"},
+    {"P99周期平均帧时间", "P99 period-avg frame time"},
+    {"能耗", "Energy"},
+    {"区段统计", "Sections"},
+    {"区段", "Section"},
+    {"开始", "Start"},
+    {"时长", "Duration"},
+    {"指标叠加", "Overlay"},
+    {"其他线程", "Other threads"},
+    {"其他", "Other"},
+    {"驻留", "Residency"},
+    {"负载", "Load"},
+    {"帧率", "FPS"},
+    {"频率", "Frequency"},
+    {"温度", "Temperature"},
+    {"功耗", "Power"},
+    {"功率", "Power"},
+    {"内存", "Memory"},
+    {"PSS峰值", "PSS peak "},
+    {"脏页", "Dirty"},
+    {"主缺页", "Major faults"},
+    {"直接回收", "Direct reclaim"},
+    {"扫描", " scan"},
+    {"系统可用", "MemAvailable"},
+    {"次/秒", "/s"},
+    {"/帧", "/frame"},
+    {"平均", "avg "},
+    {"共", "total "},
+    {"滞后", "lag "},
+    {"超前", "lead "},
+    {"数据监控", "Monitor"},
+    {"数值", "Value"},
+    {"°C", "C"},
+    {"，", ", "},
+    {"；", "; "},
+};
+
+inline std::string asciiTerms(std::string_view str) {
+    std::string out;
+    out.reserve(str.size());
+    for (size_t i = 0; i < str.size();) {
+        size_t best = 0;
+        std::string_view replacement;
+        for (const auto& [term, ascii] : ASCII_TERMS) {
+            if (term.size() > best && str.compare(i, term.size(), term) == 0) {
+                best = term.size();
+                replacement = ascii;
+            }
+        }
+        if (best > 0) {
+            out += replacement;
+            i += best;
+        } else {
+            out += str[i++];
+        }
+    }
+    return out;
+}
+
+struct Rgb {
+    uint8_t r, g, b;
+    bool none;
+};
+
+Rgb parseColor(const std::string& color) {  //只需要支持图表里用到的写法
+    auto hex = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return 0;
+    };
+    if (color.size() == 7 && color[0] == '#') {
+        return {static_cast<uint8_t>(hex(color[1]) * 16 + hex(color[2])),
+                static_cast<uint8_t>(hex(color[3]) * 16 + hex(color[4])),
+                static_cast<uint8_t>(hex(color[5]) * 16 + hex(color[6])), false};
+    }
+    if (color.size() == 4 && color[0] == '#') {
+        return {static_cast<uint8_t>(hex(color[1]) * 17), static_cast<uint8_t>(hex(color[2]) * 17),
+                static_cast<uint8_t>(hex(color[3]) * 17), false};
+    }
+    if (color == "white") return {255, 255, 255, false};
+    if (color == "none") return {0, 0, 0, true};
+    return {0, 0, 0, false};  // black及其它
+}
+
+// 画到RasterImage中的一个矩形区域，区域之外的像素不会被改动，不同区域可以并行绘制
+class RasterCanvas : public ChartCanvas {
+public:
+    RasterCanvas(RasterImage& image, int origin_x, int origin_y, int width, int height)
+        : image_(image), ox_(origin_x), oy_(origin_y),
+          w_(std::min(width, image.width - origin_x)), h_(std::min(height, image.height - origin_y)) {}
+
+    void begin(int width, int height, const std::string& background) override {
+        fillRect(0, 0, width, height, parseColor(background), 1.0);
+    }
+
+    void end() override {}
+
+    void rect(int x, int y, int width, int height,
+              const std::string& fill, const std::string& stroke, double stroke_width) override {
+        Rgb fill_color = parseColor(fill);
+        if (!fill_color.none) fillRect(x, y, x + width, y + height, fill_color, 1.0);
+
+        Rgb stroke_color = parseColor(stroke);
+        if (stroke_color.none || stroke_width <= 0) return;
+        double h = stroke_width / 2;  //描边以边框为中心，四条边互不重叠
+        fillRect(x - h, y - h, x + width + h, y + h, stroke_color, 1.0);
+        fillRect(x - h, y + height - h, x + width + h, y + height + h, stroke_color, 1.0);
+        fillRect(x - h, y + h, x + h, y + height - h, stroke_color, 1.0);
+        fillRect(x + width - h, y + h, x + width + h, y + height - h, stroke_color, 1.0);
+    }
+
+    void line(int x1, int y1, int x2, int y2, const std::string& color, double width) override {
+        Rgb c = parseColor(color);
+        double h = width / 2;
+        if (x1 == x2) {  //网格线都是横竖线，按矩形填充(平头端点，同svg默认)
+            fillRect(x1 - h, std::min(y1, y2), x1 + h, std::max(y1, y2), c, 1.0);
+        } else if (y1 == y2) {
+            fillRect(std::min(x1, x2), y1 - h, std::max(x1, x2), y1 + h, c, 1.0);
+        } else {
+            std::vector<std::pair<int, int>> points = {{x1, y1}, {x2, y2}};
+            polyline(points, color, width, 1.0);
+        }
+    }
+
+    void polyline(const std::vector<std::pair<int, int>>& points,
+                  const std::string& color, double width, double opacity) override {
+        if (points.empty()) return;
+        ensureMask();
+        double r = width / 2;
+        if (points.size() == 1) {
+            coverSegment(points[0].first, points[0].second, points[0].first, points[0].second, r);
+        }
+        for (size_t i = 1; i < points.size(); ++i) {
+            coverSegment(points[i - 1].first, points[i - 1].second, points[i].first, points[i].second, r);
+        }
+        flushMask(parseColor(color), opacity);
+    }
+
+    // 奇偶规则扫描线填充：每个像素行取4条子扫描线，按跨度的小数端点累计覆盖率
+    // 活动边表按上端点排序逐步加入，每条子扫描线只计算穿过它的边
+    void polygon(const std::vector<std::pair<int, int>>& points,
+                 const std::string& fill, double opacity) override {
+        Rgb c = parseColor(fill);
+        if (points.size() < 3 || c.none) return;
+        ensureMask();
+
+        struct Edge {
+            double y_top, y_bottom, x_top, slope;
+        };
+        std::vector<Edge> edges;
+        edges.reserve(points.size());
+        for (size_t i = 0; i < points.size(); ++i) {
+            auto [x0, y0] = points[i];
+            auto [x1, y1] = points[(i + 1) % points.size()];
+            if (y0 == y1) continue;
+            if (y0 > y1) {
+                std::swap(x0, x1);
+                std::swap(y0, y1);
+            }
+            edges.push_back({static_cast<double>(y0), static_cast<double>(y1), static_cast<double>(x0),
+                             static_cast<double>(x1 - x0) / (y1 - y0)});
+        }
+        if (edges.empty()) return;
+        std::sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) { return a.y_top < b.y_top; });
+
+        constexpr int SUB = 4;
+        constexpr int WEIGHT = 64;  // 每条子扫描线满覆盖的贡献，4条合计256
+        int y_begin = std::max(0, floorInt(edges.front().y_top));
+        int y_end = h_;
+        std::vector<int> acc(w_ + 1, 0);
+        std::vector<const Edge*> active;
+        std::vector<double> crossings;
+        size_t next_edge = 0;
+
+        for (int y = y_begin; y < y_end; ++y) {
+            int x_min = w_, x_max = 0;
+            for (int s = 0; s < SUB; ++s) {
+                double py = y + (s + 0.5) / SUB;
+                while (next_edge < edges.size() && edges[next_edge].y_top <= py) active.push_back(&edges[next_edge++]);
+                active.erase(std::remove_if(active.begin(), active.end(),
+                                            [py](const Edge* e) { return e->y_bottom <= py; }),
+                             active.end());
+
+                crossings.clear();
+                for (const Edge* e : active) crossings.push_back(e->x_top + (py - e->y_top) * e->slope);
+                std::sort(crossings.begin(), crossings.end());
+                for (size_t i = 0; i + 1 < crossings.size(); i += 2) {
+                    double xa = std::max(0.0, crossings[i]);
+                    double xb = std::min<double>(w_, crossings[i + 1]);
+                    if (xb <= xa) continue;
+                    int ia = floorInt(xa), ib = floorInt(xb);
+                    x_min = std::min(x_min, ia);
+                    x_max = std::max(x_max, ib + 1);
+                    if (ia == ib) {
+                        acc[ia] += static_cast<int>((xb - xa) * WEIGHT + 0.5);
+                        continue;
+                    }
+                    acc[ia] += static_cast<int>((ia + 1 - xa) * WEIGHT + 0.5);
+                    for (int x = ia + 1; x < ib; ++x) acc[x] += WEIGHT;
+                    acc[ib] += static_cast<int>((xb - ib) * WEIGHT + 0.5);
+                }
+            }
+            if (active.empty() && next_edge == edges.size()) break;
+            x_max = std::min(x_max, w_);
+            if (x_min >= x_max) continue;
+
+            uint8_t* row = mask_.data() + static_cast<size_t>(y) * w_;
+            for (int x = x_min; x < x_max; ++x) {
+                row[x] = static_cast<uint8_t>(std::min(255, acc[x]));
+                acc[x] = 0;
+            }
+            acc[x_max] = 0;
+            touch(y, x_min, x_max);
+        }
+        flushMask(c, opacity);
+    }
+
+    void text(int x, int y, int font_size, const std::string& color, std::string_view str,
+              Anchor anchor, bool bold) override {
+        std::string translated;
+        if (std::any_of(str.begin(), str.end(), [](char ch) { return static_cast<unsigned char>(ch) >= 0x80; })) {
+            translated = asciiTerms(str);
+            str = translated;
+        }
+        int s = glyphScale(font_size);
+        int width = textWidth(str, s);
+        if (anchor == Anchor::Middle) x -= width / 2;
+        if (anchor == Anchor::End) x -= width;
+
+        Rgb c = parseColor(color);
+        int bold_offset = bold ? std::max(1, s / 3) : 0;
+        for (size_t i = 0; i < str.size();) {
+            unsigned char ch = static_cast<unsigned char>(str[i]);
+            if (ch < 0x80) {
+                if (ch >= 0x20 && ch < 0x7F) drawGlyph(FONT_5X8[ch - 0x20], x, y, s, bold_offset, c);
+                x += 6 * s;
+                ++i;
+            } else {  //非ASCII按一个全角字符的空心框占位
+                drawBox(x, y, s, c);
+                x += 10 * s;
+                i += utf8Length(ch);
+            }
+        }
+    }
+
+    static int glyphScale(int font_size) {  //点阵字高7格，大致对齐同字号矢量字体的大写字母高度
+        return std::max(1, (font_size * 10 + 48) / 97);
+    }
+
+    static int textWidth(std::string_view str, int s) {
+        int width = 0;
+        for (size_t i = 0; i < str.size();) {
+            unsigned char ch = static_cast<unsigned char>(str[i]);
+            if (ch < 0x80) {
+                width += 6 * s;
+                ++i;
+            } else {
+                width += 10 * s;
+                i += utf8Length(ch);
+            }
+        }
+        return width > 0 ? width - s : 0;  //去掉最后一个字符后面的间隔
+    }
+
+private:
+    RasterImage& image_;
+    int ox_, oy_, w_, h_;
+    std::vector<uint8_t> mask_;              //当前折线的覆盖率，0..255
+    std::vector<std::pair<int, int>> span_;  //每行蒙版被写过的[x0,x1)，混合时只扫这部分
+
+    static size_t utf8Length(unsigned char lead) {
+        if (lead >= 0xF0) return 4;
+        if (lead >= 0xE0) return 3;
+        if (lead >= 0xC0) return 2;
+        return 1;
+    }
+
+    static void blend(uint8_t* p, const Rgb& c, int alpha) {  // alpha为0..256的定点数
+        p[0] = static_cast<uint8_t>(p[0] + (((c.r - p[0]) * alpha + 128) >> 8));
+        p[1] = static_cast<uint8_t>(p[1] + (((c.g - p[1]) * alpha + 128) >> 8));
+        p[2] = static_cast<uint8_t>(p[2] + (((c.b - p[2]) * alpha + 128) >> 8));
+    }
+
+    void plot(int x, int y, const Rgb& c) {
+        if (x < 0 || y < 0 || x >= w_ || y >= h_) return;
+        uint8_t* p = image_.row(oy_ + y) + (ox_ + x) * 3;
+        p[0] = c.r;
+        p[1] = c.g;
+        p[2] = c.b;
+    }
+
+    // 轴对齐矩形，边缘按覆盖面积做抗锯齿
+    void fillRect(double x0, double y0, double x1, double y1, const Rgb& c, double alpha) {
+        if (c.none || x1 <= x0 || y1 <= y0) return;
+        int ix0 = std::max(0, floorInt(x0));
+        int iy0 = std::max(0, floorInt(y0));
+        int ix1 = std::min(w_, ceilInt(x1));
+        int iy1 = std::min(h_, ceilInt(y1));
+        // 整列落在矩形内的像素，整行也覆盖时直接写颜色，只有四周一圈需要按面积算
+        int full_x0 = std::min(ix1, std::max(ix0, ceilInt(x0)));
+        int full_x1 = std::max(full_x0, std::min(ix1, floorInt(x1)));
+        for (int y = iy0; y < iy1; ++y) {
+            double cy = std::min<double>(y + 1, y1) - std::max<double>(y, y0);
+            uint8_t* row = image_.row(oy_ + y) + ox_ * 3;
+            bool solid = static_cast<int>(cy * alpha * 256 + 0.5) >= 256;
+            for (int x = ix0; x < ix1; ++x) {
+                if (solid && x == full_x0) {
+                    for (; x < full_x1; ++x) {
+                        row[x * 3] = c.r;
+                        row[x * 3 + 1] = c.g;
+                        row[x * 3 + 2] = c.b;
+                    }
+                    if (x >= ix1) break;
+                }
+                double cx = std::min<double>(x + 1, x1) - std::max<double>(x, x0);
+                int a = static_cast<int>(cx * cy * alpha * 256 + 0.5);
+                if (a >= 256) {
+                    row[x * 3] = c.r;
+                    row[x * 3 + 1] = c.g;
+                    row[x * 3 + 2] = c.b;
+                } else if (a > 0) {
+                    blend(row + x * 3, c, a);
+                }
+            }
+        }
+    }
+
+    static int floorInt(double v) {  //不走libm，逐行调用很频繁
+        int i = static_cast<int>(v);
+        return i - (i > v);
+    }
+    static int ceilInt(double v) {
+        int i = static_cast<int>(v);
+        return i + (i < v);
+    }
+
+    void ensureMask() {
+        if (mask_.empty()) {
+            mask_.assign(static_cast<size_t>(w_) * h_, 0);
+            span_.assign(h_, {w_, 0});
+        }
+    }
+
+    void touch(int y, int x0, int x1) {  //记下第y行[x0,x1)写过蒙版
+        auto& span = span_[y];
+        span.first = std::min(span.first, x0);
+        span.second = std::max(span.second, x1);
+    }
+
+    // 线段加粗成两端圆头的胶囊形，像素中心到线段的距离决定覆盖率；每行只扫描线段经过的x范围
+    // 投影落在线段中间的像素到直线的距离是x的线性函数，只有两端圆头处需要开方
+    void coverSegment(double ax, double ay, double bx, double by, double r) {
+        double dx = bx - ax, dy = by - ay;
+        double reach = r + 0.5;  //距离超过它的像素覆盖率为0
+
+        int y_begin = std::max(0, floorInt((std::min(ay, by) - reach)));
+        int y_end = std::min(h_, ceilInt((std::max(ay, by) + reach)));
+
+        if (dx == 0 && dy != 0) {  //抽稀后每列的最低到最高是竖线：中间各行覆盖率相同，算一行复用
+            int x_begin = std::max(0, floorInt(ax - reach));
+            int x_end = std::min(w_, ceilInt(ax + reach));
+            if (x_begin >= x_end) return;
+            uint8_t pattern[64];
+            int n = std::min(x_end - x_begin, 64);
+            for (int i = 0; i < n; ++i) {
+                double coverage = reach - std::abs(x_begin + i + 0.5 - ax);
+                pattern[i] = coverage <= 0 ? 0 : coverage >= 1.0 ? 255 : static_cast<uint8_t>(coverage * 255 + 0.5);
+            }
+            // 像素中心严格落在两端点之间的行
+            int inner_begin = std::max(y_begin, floorInt((std::min(ay, by) - 0.5)) + 1);
+            int inner_end = std::min(y_end, ceilInt((std::max(ay, by) - 0.5)));
+            for (int y = inner_begin; y < inner_end; ++y) {
+                uint8_t* row = mask_.data() + static_cast<size_t>(y) * w_ + x_begin;
+                for (int i = 0; i < n; ++i) {
+                    if (pattern[i] > row[i]) row[i] = pattern[i];
+                }
+                touch(y, x_begin, x_begin + n);
+            }
+            //两端圆头按一般情况处理
+            coverRows(ax, ay, dx, dy, reach, y_begin, std::max(y_begin, inner_begin));
+            coverRows(ax, ay, dx, dy, reach, std::min(y_end, std::max(inner_end, inner_begin)), y_end);
+            return;
+        }
+        if (std::abs(dy) >= std::abs(dx)) {  //陡的线段(密集数据的大多数)：中间各行逐行平移，两端圆头按一般情况处理
+            double len = std::sqrt(dx * dx + dy * dy);
+            double hw = reach * len / std::abs(dy);           //一行内覆盖的半宽
+            double margin = hw * std::abs(dx) / (len * len);  //半宽内的像素投影到线段上最多偏移的t
+            if (margin < 0.5) {
+                double p0 = ay + dy * margin, p1 = ay + dy * (1.0 - margin);
+                int inner_begin = std::max(y_begin, floorInt(std::min(p0, p1) - 0.5) + 1);
+                int inner_end = std::min(y_end, std::max(inner_begin, ceilInt(std::max(p0, p1) - 0.5)));
+                coverRows(ax, ay, dx, dy, reach, y_begin, inner_begin);
+                coverSteepRows(ax, ay, dx / dy, std::abs(dy) / len, reach, hw, inner_begin, inner_end);
+                coverRows(ax, ay, dx, dy, reach, inner_end, y_end);
+                return;
+            }
+        }
+        coverRows(ax, ay, dx, dy, reach, y_begin, y_end);
+    }
+
+    // 像素中心到直线的距离 = 水平距离 × cos，这些行里的像素都投影在线段中间，不会碰到圆头
+    void coverSteepRows(double ax, double ay, double slope, double cos, double reach, double hw, int y_begin, int y_end) {
+        for (int y = y_begin; y < y_end; ++y) {
+            double xc = ax + (y + 0.5 - ay) * slope;
+            int x_begin = std::max(0, floorInt(xc - hw));
+            int x_end = std::min(w_, ceilInt(xc + hw));
+            if (x_begin >= x_end) continue;
+            touch(y, x_begin, x_end);
+            uint8_t* row = mask_.data() + static_cast<size_t>(y) * w_;
+            for (int x = x_begin; x < x_end; ++x) {
+                double coverage = reach - std::abs(x + 0.5 - xc) * cos;
+                if (coverage <= 0) continue;
+                uint8_t v = coverage >= 1.0 ? 255 : static_cast<uint8_t>(coverage * 255 + 0.5);
+                if (v > row[x]) row[x] = v;
+            }
+        }
+    }
+
+    void coverRows(double ax, double ay, double dx, double dy, double reach, int y_begin, int y_end) {
+        double len2 = dx * dx + dy * dy;
+        double inv_len2 = len2 > 0 ? 1.0 / len2 : 0.0;
+        double inv_len = len2 > 0 ? std::sqrt(inv_len2) : 0.0;
+        double nx = -dy * inv_len, ny = dx * inv_len;  //单位法向量
+        double by = ay + dy;
+        double inv_dy = dy != 0 ? 1.0 / dy : 0.0;
+        for (int y = y_begin; y < y_end; ++y) {
+            double py = y + 0.5;
+            // 线段上y落在[py-reach, py+reach]内的部分，其x范围再向两边扩reach
+            double t0 = 0.0, t1 = 1.0;
+            if (dy != 0) {
+                double ta = (py - reach - ay) * inv_dy, tb = (py + reach - ay) * inv_dy;
+                t0 = std::max(0.0, std::min(ta, tb));
+                t1 = std::min(1.0, std::max(ta, tb));
+                if (t0 > t1) {  //只有端点圆头碰到这一行
+                    t0 = t1 = (std::abs(py - ay) < std::abs(py - by)) ? 0.0 : 1.0;
+                }
+            }
+            double xa = ax + dx * t0, xb = ax + dx * t1;
+            int x_begin = std::max(0, floorInt((std::min(xa, xb) - reach)));
+            int x_end = std::min(w_, ceilInt((std::max(xa, xb) + reach)));
+            if (x_begin >= x_end) continue;
+
+            uint8_t* row = mask_.data() + static_cast<size_t>(y) * w_;
+            double ry = py - ay;
+            for (int x = x_begin; x < x_end; ++x) {
+                double rx = x + 0.5 - ax;
+                double t = (rx * dx + ry * dy) * inv_len2;
+                double dist;
+                if (t <= 0.0) {
+                    dist = std::sqrt(rx * rx + ry * ry);
+                } else if (t >= 1.0) {
+                    double ex = rx - dx, ey = ry - dy;
+                    dist = std::sqrt(ex * ex + ey * ey);
+                } else {
+                    dist = std::abs(rx * nx + ry * ny);
+                }
+                double coverage = reach - dist;
+                if (coverage <= 0) continue;
+                uint8_t v = coverage >= 1.0 ? 255 : static_cast<uint8_t>(coverage * 255 + 0.5);
+                if (v > row[x]) row[x] = v;
+            }
+            touch(y, x_begin, x_end);
+        }
+    }
+
+    void flushMask(const Rgb& c, double opacity) {  //按蒙版混合颜色并清空蒙版
+        int alpha[256];
+        for (int i = 0; i < 256; ++i) alpha[i] = static_cast<int>(i * opacity * 256 / 255 + 0.5);
+
+        for (int y = 0; y < h_; ++y) {
+            auto& span = span_[y];
+            if (span.first >= span.second) continue;
+            uint8_t* row = mask_.data() + static_cast<size_t>(y) * w_;
+            uint8_t* pixels = image_.row(oy_ + y) + ox_ * 3;
+            for (int x = span.first; x < span.second; ++x) {
+                if (x + 8 <= span.second) {  //折线在一行里通常很稀疏，整8字节为0时跳过
+                    uint64_t word;
+                    std::memcpy(&word, row + x, 8);
+                    if (word == 0) {
+                        x += 7;
+                        continue;
+                    }
+                }
+                if (row[x]) {
+                    blend(pixels + x * 3, c, alpha[row[x]]);
+                    row[x] = 0;
+                }
+            }
+            span = {w_, 0};
+        }
+    }
+
+    void drawGlyph(const uint8_t (&glyph)[5], int x, int y, int s, int bold_offset, const Rgb& c) {
+        int top = y - 7 * s;  // 第0~6行在基线以上，第7行是下伸部
+        for (int col = 0; col < 5; ++col) {
+            uint8_t bits = glyph[col];
+            for (int row = 0; row < 8; ++row) {
+                if (!(bits & (1 << row))) continue;
+                for (int dy = 0; dy < s; ++dy) {
+                    for (int dx = 0; dx < s + bold_offset; ++dx) {
+                        plot(x + col * s + dx, top + row * s + dy, c);
+                    }
+                }
+            }
+        }
+    }
+
+    void drawBox(int x, int y, int s, const Rgb& c) {
+        int left = x + s, right = x + 9 * s, top = y - 8 * s, bottom = y + s;
+        int t = std::max(1, s / 2);
+        for (int yy = top; yy < bottom; ++yy) {
+            for (int xx = left; xx < right; ++xx) {
+                if (yy < top + t || yy >= bottom - t || xx < left + t || xx >= right - t) plot(xx, yy, c);
+            }
+        }
+    }
+};
+
+}  // namespace png_report
+
+// 与draw_svg相同的版面，各图表并行光栅化到同一张图的不同区域，再分块并行压缩
+void draw_png(const std::vector<ChartSpec>& charts, const std::string& title, const std::string& time,
+              const std::string& pkg, ThreadPool* pool = nullptr) {
+    using png_report::RasterCanvas;
+    if (charts.empty()) return;
+
+    const int width = 1440, chart_height = 720, spacing = 50;
+    int header_height = (!title.empty() || !time.empty()) ? 150 : 0;
+    int total_height = header_height + chart_height * static_cast<int>(charts.size()) +
+                       spacing * static_cast<int>(charts.size() - 1);
+    RasterImage image(width, total_height);
+
+    if (header_height > 0) {
+        RasterCanvas header(image, 0, 0, width, header_height);
+        if (!title.empty()) header.text(100, 55, 48, "black", title, ChartCanvas::Anchor::Start, true);
+        if (!time.empty()) header.text(100, 85, 30, "#666", time, ChartCanvas::Anchor::Start, false);
+    }
+
+    TaskGroup group(pool);
+    for (size_t i = 0; i < charts.size(); ++i) {
+        group.run([&, i] {
+            RasterCanvas canvas(image, 0, header_height + static_cast<int>(i) * (chart_height + spacing),
+                                width, chart_height);
+            SVGFreqPlotter plotter(charts[i].style);
+            plotter.drawChart(charts[i].data, charts[i].title, charts[i].y_label, canvas);
+        });
+    }
+    group.wait();
+
+    std::string filename = pkg + ".png";
+    if (!writeFileAtomic(filename, encodePng(image, pool))) {
+        std::cerr << "无法写入 " << filename << std::endl;
+        return;
+    }
+
+    std::cout << "位图已生成" << std::endl;
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include "draw_html.hpp"
+#include "draw_png.hpp"
+#include "draw_svg.hpp"
+
+// 生成报告：图表模型只构建一次，再按选项输出各种格式
+void draw_report(const ReportData& result, const std::string& pkg, const RenderOptions& options = {},
+                 ThreadPool* pool = nullptr) {
+    std::vector<ChartSpec> charts = buildCharts(result, options, pool);
+    draw_svg(charts, result.name, result.time, pkg, pool);
+    if (options.html) {
+        draw_html(charts, result.name, result.time, pkg);
+    }
+    if (options.png) {
+        draw_png(charts, result.name, result.time, pkg, pool);
+    }
+}
@@ -1,7 +1,14 @@
+#pragma once
+#include "ReportData.hpp"
+#include "ThreadPool.hpp"
 #include "draw_auto.hpp"
-#include "nlohmann/json.hpp"
 #include <algorithm>
+#include <charconv>
 #include <climits>
+#include <cstring>
+#include <cmath>
+#include <cstdio>
+#include <functional>
 #include <fstream>
 #include <iostream>
 #include <map>
@@ -10,8 +17,18 @@
 #include <set>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+struct RenderOptions {  //绘图选项
+    bool decimate = true;  // 折线抽稀
+    bool html = false;     // 额外输出交互式网页
+    bool png = false;      // 额外输出内置光栅化的png
+    bool heatmap = false;  // 负载图画成热力图，并增加频率驻留图
+    bool stacked = false;  // 增加按进程/线程组堆叠的负载构成图
+    std::vector<std::string> overlay;  // 多轴叠加图的指标(最多3个)，为空时不画
+};
+
 double data_line_width(std::size_t size) {
     if (size > 100) {
         if (size <= 800) {
@@ -26,141 +43,144 @@ double data_line_width(std::size_t size) {
 
 std::string sanitizeCpuSet(const std::string& cpu_set);
 
-struct ThreadInfo {
-    std::string name;
-    std::string cpu_set;
-    std::vector<std::pair<uint64_t, float>> time_load_pairs;  // 时间戳和负载的对应关系
+struct ChartSpec {  //一张图表：样式和数据，svg/html等输出共用
+    std::string title;
+    std::string key;  //标题里带统计值的图表另给一个固定名字，实时报告按它找折线缓存；为空时用标题
+    std::string y_label;
+    SVGFreqPlotter::StyleParams style;
+    SVGFreqPlotter::SeriesData data;
+    SVGFreqPlotter::PathCache* path_cache = nullptr;  //实时报告跨刷新复用的折线缓存
+    bool line_view = true;  //数据能否按折线显示，网页报告只收录这类图表
 };
 
-// 解析线程数据的主函数
-std::map<std::string, std::vector<SVGFreqPlotter::FrameData>> parseThreadData(const nlohmann::json& result) {
-    std::map<std::string, std::vector<SVGFreqPlotter::FrameData>> cpu_set_frames;
-    std::map<std::string, ThreadInfo> all_threads;  // 线程唯一标识 -> 线程信息
+void useHeatmap(SVGFreqPlotter::StyleParams& style, int left_margin) {  //行标签在左侧，需要加宽左边距
+    style.chart_type = SVGFreqPlotter::ChartType::Heatmap;
+    style.left_margin = left_margin;
+}
 
-    if (!result.contains("thread") || !result["thread"].is_array()) {
-        return cpu_set_frames;
+// 先写临时文件再rename，同时在读的浏览器/同步工具看到的要么是旧文件要么是新文件
+bool writeFileAtomic(const std::string& filename, const std::string& content) {
+    std::string temp = filename + ".tmp";
+    {
+        std::ofstream file(temp, std::ios::binary);
+        if (!file) return false;
+        file.write(content.data(), content.size());
+        if (!file) return false;
     }
-
-    // 第一遍：收集所有线程信息，确定每个线程的主要cpu-set
-    std::map<std::string, std::map<std::string, int>> thread_cpu_set_counts;
-    std::map<std::string, std::vector<float>> thread_loads;
-
-    for (const auto& frame : result["thread"]) {
-        uint64_t time_ms = frame["time_ms"];
-
-        if (frame.contains("data") && frame["data"].is_array()) {
-            for (const auto& process : frame["data"]) {
-                if (process.contains("threads") && process["threads"].is_array()) {
-                    for (const auto& thread : process["threads"]) {
-                        std::string thread_name = thread["name"];
-                        int tid = thread["tid"];
-                        std::string cpu_set = thread["cpu-set"];
-                        float load = thread["load"];
-
-                        std::string thread_id = thread_name + "(" + std::to_string(tid) + ")";  // 线程名(tid),防重名
-
-                        thread_cpu_set_counts[thread_id][cpu_set]++;  //记录cpu-set
-
-                        thread_loads[thread_id].push_back(load);
-
-                        if (all_threads.find(thread_id) == all_threads.end()) {
-                            all_threads[thread_id] = {thread_id, "", {}};
-                        }
-                    }
-                }
-            }
-        }
+    if (std::rename(temp.c_str(), filename.c_str()) != 0) {
+        std::remove(temp.c_str());
+        return false;
     }
+    return true;
+}
 
-    for (auto& [thread_id, thread_info] : all_threads) {  //寻找主要存在的cpu-set
-        if (thread_cpu_set_counts.find(thread_id) != thread_cpu_set_counts.end()) {
-            const auto& cpu_set_counts = thread_cpu_set_counts[thread_id];
-            std::string main_cpu_set = "";
-            int max_count = 0;
+// 线程名(tid),防重名
+std::string threadIdOf(const ThreadSeries& series, const ThreadSeries::Thread& thread) {
+    return series.strings[thread.name] + "(" + std::to_string(thread.tid) + ")";
+}
 
-            for (const auto& [cpu_set, count] : cpu_set_counts) {
-                if (count > max_count) {
-                    max_count = count;
-                    main_cpu_set = cpu_set;
-                }
-            }
+// 解析线程数据的主函数：按线程的主要cpu-set分组，每个线程一条稀疏序列
+// 只存线程实际出现的帧，不再给每帧补0，内存和时间只与采样数有关
+std::map<std::string, SVGFreqPlotter::SeriesData> parseThreadData(const ReportData& result) {
+    std::map<std::string, SVGFreqPlotter::SeriesData> cpu_set_series;
+    const ThreadSeries& series = result.thread;
 
-            thread_info.cpu_set = main_cpu_set;
-        }
+    if (series.frames.empty()) {
+        return cpu_set_series;
     }
 
-    for (const auto& frame : result["thread"]) {
-        uint64_t time_ms = frame["time_ms"];
-
-        std::map<std::string, SVGFreqPlotter::FrameData> current_frame_by_cpuset;
-
-        if (frame.contains("data") && frame["data"].is_array()) {
-            for (const auto& process : frame["data"]) {
-                if (process.contains("threads") && process["threads"].is_array()) {
-                    for (const auto& thread : process["threads"]) {
-                        std::string thread_name = thread["name"];
-                        int tid = thread["tid"];
-                        std::string cpu_set = thread["cpu-set"];
-                        float load = thread["load"];
-
-                        std::string thread_id = thread_name + "(" + std::to_string(tid) + ")";
-
-                        if (all_threads.find(thread_id) != all_threads.end()) {  //按cpu—set分组
-                            std::string main_cpu_set = all_threads[thread_id].cpu_set;
-
-                            if (current_frame_by_cpuset.find(main_cpu_set) == current_frame_by_cpuset.end()) {
-                                current_frame_by_cpuset[main_cpu_set] = {time_ms, {}};
-                            }
-
-                            current_frame_by_cpuset[main_cpu_set].frequencies[thread_id] = load;
-                        }
-                    }
-                }
-            }
+    struct ThreadInfo {
+        const ThreadSeries::Thread* first;                  // 用于取线程名
+        std::vector<std::pair<uint32_t, int>> cpu_set_counts;  // cpu-set字符串id -> 次数
+        size_t group;                                       // 所属cpu-set分组
+        SVGFreqPlotter::SparseSeries values;
+    };
+
+    auto keyOf = [](const ThreadSeries::Thread& thread) {  //线程名已经去重，(名字id, tid)即唯一标识
+        return (static_cast<uint64_t>(thread.name) << 32) | static_cast<uint32_t>(thread.tid);
+    };
+
+    // 第一遍：收集所有线程信息，记录每个线程出现在各cpu-set的次数
+    std::vector<ThreadInfo> threads;
+    std::vector<uint32_t> thread_index(series.threads.size());
+    std::unordered_map<uint64_t, uint32_t> index_of;
+
+    for (size_t t = 0; t < series.threads.size(); ++t) {
+        const auto& thread = series.threads[t];
+        auto [it, inserted] = index_of.emplace(keyOf(thread), static_cast<uint32_t>(threads.size()));
+        if (inserted) {
+            threads.push_back({&thread, {}, 0, {}});
         }
+        thread_index[t] = it->second;
 
-        for (const auto& [cpu_set, frame_data] : current_frame_by_cpuset) {
-            cpu_set_frames[cpu_set].push_back(frame_data);
+        auto& counts = threads[it->second].cpu_set_counts;
+        auto count = std::find_if(counts.begin(), counts.end(),
+                                  [&](const auto& c) { return c.first == thread.affinity; });
+        if (count == counts.end()) {
+            counts.emplace_back(thread.affinity, 1);
+        } else {
+            ++count->second;
         }
     }
 
-    for (auto& [cpu_set, frames] : cpu_set_frames) {  //修补数据
-        std::set<std::string> cpu_set_threads;
-        for (const auto& thread_info : all_threads) {
-            if (thread_info.second.cpu_set == cpu_set) {
-                cpu_set_threads.insert(thread_info.first);
+    std::vector<std::string> groups;  //寻找主要存在的cpu-set，次数相同时取字典序靠前的
+    std::map<std::string, size_t> group_of;
+    for (auto& info : threads) {
+        const std::string* main_cpu_set = nullptr;
+        int max_count = 0;
+        for (const auto& [cpu_set, count] : info.cpu_set_counts) {
+            const std::string& name = series.strings[cpu_set];
+            if (count > max_count || (count == max_count && name < *main_cpu_set)) {
+                max_count = count;
+                main_cpu_set = &name;
             }
         }
 
-        for (auto& frame : frames) {
-            for (const auto& thread_id : cpu_set_threads) {
-                if (frame.frequencies.find(thread_id) == frame.frequencies.end()) {
-                    frame.frequencies[thread_id] = 0.0f;
+        auto [it, inserted] = group_of.emplace(*main_cpu_set, groups.size());
+        if (inserted) groups.push_back(*main_cpu_set);
+        info.group = it->second;
+    }
+
+    // 第二遍：按帧填充，分组只在有它的线程出现的帧上有时间点
+    std::vector<SVGFreqPlotter::SeriesData> group_data(groups.size());
+    std::vector<size_t> group_frame(groups.size(), SIZE_MAX);  // 分组最近一次出现的帧
+    for (size_t f = 0; f < series.frames.size(); ++f) {
+        uint64_t time_ms = series.frames[f].time_ms;
+
+        for (size_t p = series.frames[f].first_process; p < series.processEnd(f); ++p) {
+            for (size_t t = series.processes[p].first_thread; t < series.threadEnd(p); ++t) {
+                ThreadInfo& info = threads[thread_index[t]];
+                auto& time_axis = group_data[info.group].time_ms;
+                if (group_frame[info.group] != f) {
+                    group_frame[info.group] = f;
+                    time_axis.push_back(time_ms);
                 }
+                info.values.push(static_cast<uint32_t>(time_axis.size() - 1), static_cast<float>(series.threads[t].load));
             }
         }
     }
 
-    return cpu_set_frames;
-}
-
-std::vector<std::string> processCPUFramesEfficient(const std::vector<SVGFreqPlotter::FrameData>& frames, int keep_count) {
-
-    std::map<std::string, float> totdata;
-    for (auto& [name, value] : frames[0].frequencies) {
-        totdata[name] = 0.0f;
+    for (auto& info : threads) {
+        group_data[info.group].series[threadIdOf(series, *info.first)] = std::move(info.values);
+    }
+    for (size_t g = 0; g < groups.size(); ++g) {
+        cpu_set_series[groups[g]] = std::move(group_data[g]);
     }
 
-    for (auto& frame : frames) {
-        for (auto& [name, value] : frame.frequencies) {
-            totdata[name] += value;
-        }
+    return cpu_set_series;
+}
+
+// 按总负载取前keep_count个线程，只累加实际采样(缺失的帧为0，不影响总和)
+std::vector<std::string> processCPUFramesEfficient(const SVGFreqPlotter::SeriesData& data, size_t keep_count) {
+    std::vector<std::pair<std::string, float>> temp;
+    temp.reserve(data.series.size());
+    for (const auto& [name, series] : data.series) {
+        temp.emplace_back(name, series.sum());
     }
-    std::vector<std::string> tmpdata;
-    std::vector<std::pair<std::string, float>> temp(totdata.begin(), totdata.end());
 
     std::sort(temp.begin(), temp.end(), [](auto& a, auto& b) { return a.second > b.second; });
 
+    std::vector<std::string> tmpdata;
     std::transform(temp.begin(), temp.end(), std::back_inserter(tmpdata),
                    [](auto& pair) { return pair.first; });
     if (tmpdata.size() > keep_count) {
@@ -170,184 +190,172 @@ std::vector<std::string> processCPUFramesEfficient(const std::vector<SVGFreqPlot
     return tmpdata;
 }
 
-void drawThreadCharts(const nlohmann::json& result, std::vector<std::string>& svgs) {  //绘图
-    auto cpu_set_frames = parseThreadData(result);
-
-    if (cpu_set_frames.empty()) {
-        return;
-    }
-
-    for (const auto& [cpu_set, frames] : cpu_set_frames) {  //分组绘图
-        if (frames.empty())
+void addThreadCharts(std::map<std::string, SVGFreqPlotter::SeriesData>&& cpu_set_series,
+                     std::vector<ChartSpec>& charts, const RenderOptions& options) {  //每个cpu-set一张图
+    for (auto& [cpu_set, data] : cpu_set_series) {  //分组绘图
+        if (data.time_ms.empty())
             continue;
 
-        // 创建绘图器
-        SVGFreqPlotter::StyleParams style;
+        ChartSpec chart;
+        chart.title = "线程负载 - CPU Set: " + cpu_set;
+        chart.y_label = "负载(%)";
+
+        SVGFreqPlotter::StyleParams& style = chart.style;
         style.use_custom_range = true;
         style.custom_min_value = 0.0f;
         style.custom_max_value = 100.0f;
-        style.order = processCPUFramesEfficient(frames, 15);
+        style.order = processCPUFramesEfficient(data, 15);
         style.legend_font_size=18;
-        style.data_line_width = data_line_width(frames.size());
-
-        SVGFreqPlotter plotter(style);
-
-        std::string title = "线程负载 - CPU Set: " + cpu_set;
+        style.data_line_width = data_line_width(data.time_ms.size());
+        style.decimate = options.decimate;
+        if (options.heatmap) {
+            useHeatmap(style, 260);
+            style.label = "每行一个线程，颜色为平均负载";
+        }
 
-        plotter.drawChart(frames, title, "负载(%)");
-        svgs.push_back(plotter.getSVG());
+        chart.data = std::move(data);
+        charts.push_back(std::move(chart));
     }
 }
 
-// 辅助函数：清理cpu-set字符串用于文件名
-std::string sanitizeCpuSet(const std::string& cpu_set) {
-    std::string sanitized = cpu_set;
-    std::replace(sanitized.begin(), sanitized.end(), ',', '_');
-    std::replace(sanitized.begin(), sanitized.end(), '-', '_');
-    std::replace(sanitized.begin(), sanitized.end(), ' ', '_');
-    return sanitized;
+// 线程调度分组：优先使用cpuset路径，cpu控制组不同时附加
+std::string threadClassOf(const ThreadSeries& series, const ThreadSeries::Thread& thread) {
+    std::string cpuset = series.strings[thread.cpuset];
+    std::string cgroup = series.strings[thread.cgroup];
+    if (cpuset.empty() && cgroup.empty()) {
+        return "";
+    }
+
+    if (!cpuset.empty() && cpuset[0] == '/') cpuset.erase(0, 1);
+    if (!cgroup.empty() && cgroup[0] == '/') cgroup.erase(0, 1);
+    if (cpuset.empty()) return "cpu:" + (cgroup.empty() ? "root" : cgroup);
+    if (cgroup.empty() || cgroup == cpuset) return cpuset;
+    return cpuset + " (cpu:" + cgroup + ")";
 }
 
-std::vector<SVGFreqPlotter::FrameData> parseThermalData(const nlohmann::json& result) {
+// 按调度分组汇总线程负载，旧记录没有分组信息时返回空
+std::vector<SVGFreqPlotter::FrameData> parseThreadClassData(const ReportData& result) {
     std::vector<SVGFreqPlotter::FrameData> frames;
+    std::set<std::string> all_classes;
+    const ThreadSeries& series = result.thread;
 
-    if (!result.is_object() || !result.contains("thermal") || !result["thermal"].is_array()) {
-        return frames;
-    }
-    for (const auto& frame : result["thermal"]) {
-        if (!frame.is_object() || !frame.contains("time_ms") || !frame["time_ms"].is_number()) {
-            continue;
-        }
-
+    for (size_t f = 0; f < series.frames.size(); ++f) {
         SVGFreqPlotter::FrameData frame_data;
-        frame_data.time_ms = frame["time_ms"];
+        frame_data.time_ms = series.frames[f].time_ms;
 
-        float temp_value = 0.0f;
-        if (frame.contains("data") && frame["data"].is_number()) {
-            temp_value = frame["data"];
-        }
+        for (size_t p = series.frames[f].first_process; p < series.processEnd(f); ++p) {
+            for (size_t t = series.processes[p].first_thread; t < series.threadEnd(p); ++t) {
+                std::string thread_class = threadClassOf(series, series.threads[t]);
+                if (thread_class.empty()) continue;
 
-        frame_data.frequencies["temperature"] = temp_value;
+                frame_data.frequencies[thread_class] += static_cast<float>(series.threads[t].load);
+                all_classes.insert(thread_class);
+            }
+        }
         frames.push_back(frame_data);
     }
 
-    return frames;
-}
-
-// 处理fps帧率数据
-std::vector<SVGFreqPlotter::FrameData> parseFpsData(const nlohmann::json& result) {
-    std::vector<SVGFreqPlotter::FrameData> frames;
-
-    if (!result.is_object() || !result.contains("fps") || !result["fps"].is_array()) {
+    if (all_classes.empty()) {
+        frames.clear();
         return frames;
     }
 
-    for (const auto& frame : result["fps"]) {
-        if (!frame.is_object() || !frame.contains("time_ms") || !frame["time_ms"].is_number()) {
-            continue;
+    for (auto& frame : frames) {  //没有线程的分组补0
+        for (const auto& thread_class : all_classes) {
+            frame.frequencies.emplace(thread_class, 0.0f);
         }
-
-        SVGFreqPlotter::FrameData frame_data;
-        frame_data.time_ms = frame["time_ms"];
-
-        float fps_value = 0.0f;
-        if (frame.contains("data") && frame["data"].is_number()) {
-            fps_value = frame["data"];
-        }
-
-        frame_data.frequencies["fps"] = fps_value;
-        frames.push_back(frame_data);
     }
 
     return frames;
 }
 
-std::vector<SVGFreqPlotter::FrameData> parseCpuLoadData(const nlohmann::json& result) {
-    std::vector<SVGFreqPlotter::FrameData> frames;
-
-    if (!result.is_object() || !result.contains("cpu_load") || !result["cpu_load"].is_array()) {
-        return frames;
+bool buildThreadClassChart(const ReportData& result, ChartSpec& chart, const RenderOptions& options) {  //旧记录没有分组信息时返回false
+    auto frames = parseThreadClassData(result);
+    if (frames.empty()) {
+        return false;
     }
 
-    for (const auto& frame : result["cpu_load"]) {
-        if (!frame.is_object() || !frame.contains("time_ms") || !frame["time_ms"].is_number()) {
-            continue;
-        }
+    chart.title = "线程负载 - 调度分组";
+    chart.y_label = "负载(%)";
 
-        SVGFreqPlotter::FrameData frame_data;
-        frame_data.time_ms = frame["time_ms"];
+    SVGFreqPlotter::StyleParams& style = chart.style;
+    style.use_custom_range = true;
+    style.custom_min_value = 0.0f;
+    style.use_custom_max_range = false;
+    style.label = "按cgroup/cpuset分组的线程负载之和";
+    style.legend_items_per_row = 3;
+    style.data_line_width = data_line_width(frames.size());
+    style.decimate = options.decimate;
 
-        if (frame.contains("data") && frame["data"].is_array()) {
-            for (const auto& cpu_data : frame["data"]) {
-                if (cpu_data.is_object()) {
-                    std::string cpu_name = cpu_data.value("name", "unknown");
-                    float load_value = 0.0f;
+    chart.data = SVGFreqPlotter(style).seriesFromFrames(frames);
+    return true;
+}
 
-                    if (cpu_data.contains("load") && cpu_data["load"].is_number()) {
-                        load_value = cpu_data["load"];
-                    }
+// 辅助函数：清理cpu-set字符串用于文件名
+std::string sanitizeCpuSet(const std::string& cpu_set) {
+    std::string sanitized = cpu_set;
+    std::replace(sanitized.begin(), sanitized.end(), ',', '_');
+    std::replace(sanitized.begin(), sanitized.end(), '-', '_');
+    std::replace(sanitized.begin(), sanitized.end(), ' ', '_');
+    return sanitized;
+}
 
-                    frame_data.frequencies[cpu_name] = load_value;
-                }
-            }
-        }
+std::vector<SVGFreqPlotter::FrameData> scalarFrameData(const ScalarSeries& series, const std::string& name) {
+    std::vector<SVGFreqPlotter::FrameData> frames;
+    frames.reserve(series.size());
 
+    for (size_t i = 0; i < series.size(); ++i) {
+        SVGFreqPlotter::FrameData frame_data;
+        frame_data.time_ms = series.time_ms[i];
+        frame_data.frequencies[name] = static_cast<float>(series.values[i]);
         frames.push_back(frame_data);
     }
 
-    if (frames.size() > 1) {
-        frames[0] = frames[1];
-        frames[0].time_ms = 0;
-    }
-
     return frames;
 }
 
-std::vector<SVGFreqPlotter::FrameData> CPUFreqFrameData(const nlohmann::json& json_data) {
+std::vector<SVGFreqPlotter::FrameData> channelFrameData(const ChannelSeries& series, float divisor) {
     std::vector<SVGFreqPlotter::FrameData> frames;
+    frames.reserve(series.size());
 
-    if (!json_data.is_object() || !json_data.contains("cpu_freq") || !json_data["cpu_freq"].is_array()) {
-        return frames;
-    }
-
-    const auto& cpu_freq_array = json_data["cpu_freq"];
-
-    for (const auto& frame : cpu_freq_array) {
-        if (!frame.is_object()) {
-            continue;
-        }
+    for (size_t i = 0; i < series.size(); ++i) {
+        SVGFreqPlotter::FrameData frame_data;
+        frame_data.time_ms = series.time_ms[i];
 
-        if (!frame.contains("time_ms") || !frame["time_ms"].is_number()) {
-            continue;
+        for (size_t v = series.offsets[i]; v < series.offsets[i + 1]; ++v) {
+            const auto& value = series.values[v];
+            frame_data.frequencies[series.channels[value.channel]] = static_cast<float>(value.value) / divisor;
         }
+        frames.push_back(frame_data);
+    }
 
-        SVGFreqPlotter::FrameData frame_data;
-        frame_data.time_ms = frame["time_ms"];
+    return frames;
+}
 
-        if (frame.contains("data") && frame["data"].is_array()) {
-            for (const auto& core_data : frame["data"]) {
-                if (core_data.is_object()) {
-                    std::string name = "unknown";
-                    float freq_mhz = 0.0f;
+std::vector<SVGFreqPlotter::FrameData> parseThermalData(const ReportData& result) {
+    return scalarFrameData(result.thermal, "temperature");
+}
 
-                    if (core_data.contains("name") && core_data["name"].is_string()) {
-                        name = core_data["name"];
-                    }
+// 处理fps帧率数据
+std::vector<SVGFreqPlotter::FrameData> parseFpsData(const ReportData& result) {
+    return scalarFrameData(result.fps, "fps");
+}
 
-                    if (core_data.contains("freq") && core_data["freq"].is_number()) {
-                        freq_mhz = static_cast<float>(core_data["freq"]) / 1000000.0f;
-                    }
+std::vector<SVGFreqPlotter::FrameData> parseCpuLoadData(const ReportData& result) {
+    std::vector<SVGFreqPlotter::FrameData> frames = channelFrameData(result.cpu_load, 1.0f);
 
-                    frame_data.frequencies[name] = freq_mhz;
-                }
-            }
-        }
-        frames.push_back(frame_data);
+    if (frames.size() > 1 && result.begin_ms == 0) {  //第一帧没有上一次的统计可比，用第二帧代替；裁剪出的窗口不需要
+        frames[0] = frames[1];
+        frames[0].time_ms = 0;
     }
 
     return frames;
 }
 
+std::vector<SVGFreqPlotter::FrameData> CPUFreqFrameData(const ReportData& result) {
+    return channelFrameData(result.cpu_freq, 1000000.0f);
+}
+
 std::vector<std::string> sortcpus(const std::map<std::string, float>& ord) {
     std::vector<std::string> cpuKeys;
     std::vector<std::string> otherKeys;
@@ -386,27 +394,637 @@ std::vector<std::string> sortcpus(const std::map<std::string, float>& ord) {
     return result;
 }
 
-void draw_svg(nlohmann::json& result, std::string pkg) {
-    std::vector<std::string> svgs;
+// 频率驻留：每个频率通道一张热力图，每行一个频点，值为该时间段内处于这个频点的时间占比
+// 频点按sysfs原始值区分，行从高频到低频；同一簇的核心频率完全相同，合并成一张
+std::vector<ChartSpec> buildResidencyCharts(const ChannelSeries& series) {
+    std::vector<std::vector<double>> traces(series.channels.size(), std::vector<double>(series.size(), -1.0));
+    for (size_t i = 0; i < series.size(); ++i) {
+        for (size_t v = series.offsets[i]; v < series.offsets[i + 1]; ++v) {
+            traces[series.values[v].channel][i] = series.values[v].value;
+        }
+    }
+
+    std::vector<ChartSpec> charts;
+    std::vector<bool> merged(series.channels.size(), false);
+    for (uint32_t channel = 0; channel < series.channels.size(); ++channel) {
+        if (merged[channel]) continue;
+        std::set<double, std::greater<double>> levels(traces[channel].begin(), traces[channel].end());
+        levels.erase(-1.0);
+        if (levels.empty()) continue;
+
+        std::string channels = series.channels[channel];
+        for (uint32_t other = channel + 1; other < series.channels.size(); ++other) {
+            if (!merged[other] && traces[other] == traces[channel]) {
+                merged[other] = true;
+                channels += "/" + series.channels[other];
+            }
+        }
+
+        ChartSpec chart;
+        chart.title = "频率驻留 - " + channels;
+        chart.y_label = "驻留(%)";
+        chart.line_view = false;
+
+        SVGFreqPlotter::StyleParams& style = chart.style;
+        useHeatmap(style, 160);
+        style.use_custom_range = true;
+        style.custom_min_value = 0.0f;
+        style.custom_max_value = 100.0f;
+        style.label = "每行一个频点，颜色为处于该频点的时间占比";
+
+        std::map<double, std::string> names;
+        for (double level : levels) {
+            char label[32];
+            auto res = std::to_chars(label, label + sizeof(label), level / 1000000.0, std::chars_format::fixed, 2);
+            std::string name = std::string(label, res.ptr - label) + "Ghz";
+            names[level] = name;
+            style.order.push_back(name);
+        }
+
+        chart.data.time_ms = series.time_ms;
+        for (size_t i = 0; i < series.size(); ++i) {  //只记处于该频点的帧，其余帧按0补
+            if (traces[channel][i] >= 0) {
+                chart.data.series[names[traces[channel][i]]].push(static_cast<uint32_t>(i), 100.0f);
+            }
+        }
+        charts.push_back(std::move(chart));
+    }
+    return charts;
+}
+
+// "0-3,6" -> {0,1,2,3,6}，格式不对的部分跳过
+std::vector<int> parseCpuList(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string part;
+    while (std::getline(ss, part, ',')) {
+        int first = 0, last = 0;
+        char dash = 0;
+        std::stringstream range(part);
+        if (!(range >> first)) continue;
+        if (range >> dash >> last && dash == '-') {
+            for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+        } else {
+            cpus.push_back(first);
+        }
+    }
+    return cpus;
+}
+
+// 线程组：去掉名字末尾的编号，"Worker Thread 3"、"binder:1234_5" 分别归入 "Worker Thread"、"binder"
+std::string threadGroupOf(const std::string& name) {
+    size_t end = name.find_last_not_of("0123456789 _-:#.");
+    if (end == std::string::npos) return name;
+    return name.substr(0, end + 1);
+}
+
+// 按总量从大到小排序，超出keep_count的名字返回在rest里
+std::vector<std::string> rankByTotal(const std::map<std::string, double>& totals, size_t keep_count,
+                                     std::set<std::string>* rest = nullptr) {
+    std::vector<std::pair<std::string, double>> ranked(totals.begin(), totals.end());
+    std::stable_sort(ranked.begin(), ranked.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+    std::vector<std::string> names;
+    for (size_t i = 0; i < ranked.size(); ++i) {
+        if (i < keep_count) {
+            names.push_back(ranked[i].first);
+        } else if (rest) {
+            rest->insert(ranked[i].first);
+        }
+    }
+    return names;
+}
+
+ChartSpec stackedChart(const std::string& title, const std::string& label, const RenderOptions& options) {
+    ChartSpec chart;
+    chart.title = title;
+    chart.y_label = "负载(单核%)";
+    SVGFreqPlotter::StyleParams& style = chart.style;
+    style.chart_type = SVGFreqPlotter::ChartType::StackedArea;
+    style.use_custom_range = true;
+    style.custom_min_value = 0.0f;
+    style.use_custom_max_range = false;
+    style.label = label;
+    style.legend_font_size = 18;
+    style.decimate = options.decimate;
+    return chart;
+}
+
+// 负载构成：(a) 每个CPU Set上各被追踪进程的负载，顶层"其他"为这些核心的总负载减去已追踪部分
+//           (b) 游戏内按线程组汇总的负载，前10组之外合并为"其他线程"
+// 时间轴为线程采样的帧，CPU负载取不晚于该帧的最近一帧
+std::vector<ChartSpec> buildStackedCharts(const ReportData& result, const RenderOptions& options) {
+    std::vector<ChartSpec> charts;
+    const ThreadSeries& series = result.thread;
+    if (series.frames.empty()) return charts;
+
+    std::vector<uint64_t> time_axis;
+    time_axis.reserve(series.frames.size());
+    for (const auto& frame : series.frames) time_axis.push_back(frame.time_ms);
+
+    std::map<int, uint32_t> load_channel;  //核心号 -> cpu_load通道
+    for (uint32_t c = 0; c < result.cpu_load.channels.size(); ++c) {
+        const std::string& name = result.cpu_load.channels[c];
+        if (name.size() > 3 && name.compare(0, 3, "cpu") == 0 &&
+            name.find_first_not_of("0123456789", 3) == std::string::npos) {
+            load_channel[std::stoi(name.substr(3))] = c;
+        }
+    }
+
+    // (a) 按帧内的亲和性分组，组内按进程名累加
+    struct SetData {
+        std::vector<int> cpus;
+        std::map<std::string, SVGFreqPlotter::SparseSeries> layers;
+        std::map<std::string, double> totals;
+        SVGFreqPlotter::SparseSeries other;
+    };
+    std::map<std::string, SetData> sets;
+
+    // (b) 先统计各线程组总量，决定保留哪些
+    std::map<std::string, double> group_totals;
+    for (const auto& thread : series.threads) group_totals[threadGroupOf(series.strings[thread.name])] += thread.load;
+    std::set<std::string> minor_groups;
+    std::vector<std::string> group_order = rankByTotal(group_totals, 10, &minor_groups);
+    std::map<std::string, SVGFreqPlotter::SparseSeries> group_layers;
+
+    const ChannelSeries& cpu_load = result.cpu_load;
+    size_t load_frame = 0;
+    std::map<std::string, std::map<std::string, float>> set_sums;
+    std::map<std::string, float> group_sums;
+    for (size_t f = 0; f < series.frames.size(); ++f) {
+        set_sums.clear();
+        group_sums.clear();
+        for (size_t p = series.frames[f].first_process; p < series.processEnd(f); ++p) {
+            const std::string& process = series.strings[series.processes[p].name];
+            for (size_t t = series.processes[p].first_thread; t < series.threadEnd(p); ++t) {
+                const auto& thread = series.threads[t];
+                float load = static_cast<float>(thread.load);
+                set_sums[series.strings[thread.affinity]][process] += load;
+                std::string group = threadGroupOf(series.strings[thread.name]);
+                group_sums[minor_groups.count(group) ? "其他线程" : group] += load;
+            }
+        }
+
+        while (load_frame + 1 < cpu_load.size() && cpu_load.time_ms[load_frame + 1] <= time_axis[f]) ++load_frame;
+        bool has_load = load_frame < cpu_load.size() && cpu_load.time_ms[load_frame] <= time_axis[f];
+
+        for (const auto& [cpu_set, processes] : set_sums) {
+            SetData& set = sets[cpu_set];
+            if (set.cpus.empty()) set.cpus = parseCpuList(cpu_set);
+            float tracked = 0.0f;
+            for (const auto& [process, load] : processes) {
+                set.layers[process].push(static_cast<uint32_t>(f), load);
+                set.totals[process] += load;
+                tracked += load;
+            }
+            if (!has_load) continue;
+            float total = 0.0f;
+            for (size_t v = cpu_load.offsets[load_frame]; v < cpu_load.offsets[load_frame + 1]; ++v) {
+                const auto& value = cpu_load.values[v];
+                for (int cpu : set.cpus) {
+                    auto it = load_channel.find(cpu);
+                    if (it != load_channel.end() && it->second == value.channel) total += static_cast<float>(value.value);
+                }
+            }
+            set.other.push(static_cast<uint32_t>(f), std::max(0.0f, total - tracked));
+        }
+        for (const auto& [group, load] : group_sums) {
+            group_layers[group].push(static_cast<uint32_t>(f), load);
+        }
+    }
+
+    for (auto& [cpu_set, set] : sets) {
+        ChartSpec chart = stackedChart("负载构成 - CPU Set: " + cpu_set,
+                                       "按进程堆叠，其他为这些核心上的其余负载", options);
+        chart.style.order = rankByTotal(set.totals, SIZE_MAX);
+        if (!set.other.values.empty()) {
+            chart.style.order.push_back("其他");
+            set.layers["其他"] = std::move(set.other);
+        }
+        chart.data.time_ms = time_axis;
+        chart.data.series = std::move(set.layers);
+        charts.push_back(std::move(chart));
+    }
+
+    ChartSpec chart = stackedChart("负载构成 - 线程组", "游戏内按线程名(去掉编号)汇总", options);
+    chart.style.order = group_order;
+    if (!minor_groups.empty()) chart.style.order.push_back("其他线程");
+    chart.style.legend_items_per_row = 3;
+    chart.data.time_ms = std::move(time_axis);
+    chart.data.series = std::move(group_layers);
+    charts.push_back(std::move(chart));
+    return charts;
+}
+
+// 叠加图的一个指标：原始采样，时间递增
+struct OverlaySource {
+    std::string name;
+    std::vector<uint64_t> time_ms;
+    std::vector<float> values;
+};
+
+// 指标写法：fps、temp、power、freq(最高频的核心)、freq:<通道>、load:<通道>
+bool overlaySource(const ReportData& result, const std::string& key, OverlaySource& source) {
+    auto fromChannel = [&](const ChannelSeries& series, uint32_t channel, float divisor) {
+        for (size_t i = 0; i < series.size(); ++i) {
+            for (size_t v = series.offsets[i]; v < series.offsets[i + 1]; ++v) {
+                if (series.values[v].channel != channel) continue;
+                source.time_ms.push_back(series.time_ms[i]);
+                source.values.push_back(static_cast<float>(series.values[v].value) / divisor);
+            }
+        }
+    };
+    auto findChannel = [](const ChannelSeries& series, const std::string& name, uint32_t& channel) {
+        auto it = std::find(series.channels.begin(), series.channels.end(), name);
+        channel = static_cast<uint32_t>(it - series.channels.begin());
+        return it != series.channels.end();
+    };
+
+    if (key == "fps" || key == "temp" || key == "power") {
+        const ScalarSeries& series = key == "fps" ? result.fps : key == "temp" ? result.thermal : result.power;
+        source.name = key == "fps" ? "帧率(FPS)" : key == "temp" ? "温度(°C)" : "功耗(W)";
+        source.time_ms = series.time_ms;
+        source.values.assign(series.values.begin(), series.values.end());
+    } else if (key == "freq") {  //最高频的核心，相同时取编号大的
+        const ChannelSeries& series = result.cpu_freq;
+        std::vector<double> peak(series.channels.size(), 0.0);
+        for (const auto& value : series.values) peak[value.channel] = std::max(peak[value.channel], value.value);
+        int best = -1;
+        for (size_t c = 0; c < series.channels.size(); ++c) {
+            if (series.channels[c].compare(0, 3, "cpu") == 0 && (best < 0 || peak[c] >= peak[best])) {
+                best = static_cast<int>(c);
+            }
+        }
+        if (best < 0) return false;
+        source.name = series.channels[best] + "频率(Ghz)";
+        fromChannel(series, best, 1000000.0f);
+    } else if (key.compare(0, 5, "freq:") == 0 || key.compare(0, 5, "load:") == 0) {
+        bool freq = key[0] == 'f';
+        const ChannelSeries& series = freq ? result.cpu_freq : result.cpu_load;
+        uint32_t channel;
+        if (!findChannel(series, key.substr(5), channel)) return false;
+        source.name = key.substr(5) + (freq ? "频率(Ghz)" : "负载(%)");
+        fromChannel(series, channel, freq ? 1000000.0f : 1.0f);
+    } else {
+        return false;
+    }
+    return !source.time_ms.empty();
+}
+
+// 线性插值到公共时间网格，网格在采样范围之内
+std::vector<float> resampleLinear(const OverlaySource& source, const std::vector<uint64_t>& grid) {
+    std::vector<float> values(grid.size());
+    size_t j = 0;
+    for (size_t i = 0; i < grid.size(); ++i) {
+        while (j + 1 < source.time_ms.size() && source.time_ms[j + 1] <= grid[i]) ++j;
+        if (j + 1 >= source.time_ms.size() || source.time_ms[j] >= grid[i]) {
+            values[i] = source.values[j];
+            continue;
+        }
+        double f = static_cast<double>(grid[i] - source.time_ms[j]) / (source.time_ms[j + 1] - source.time_ms[j]);
+        values[i] = static_cast<float>(source.values[j] + (source.values[j + 1] - source.values[j]) * f);
+    }
+    return values;
+}
+
+double pearson(const float* a, const float* b, size_t n) {  //任一方没有变化时为0
+    double sa = 0, sb = 0;
+    for (size_t i = 0; i < n; ++i) {
+        sa += a[i];
+        sb += b[i];
+    }
+    double ma = sa / n, mb = sb / n;
+    double cov = 0, va = 0, vb = 0;
+    for (size_t i = 0; i < n; ++i) {
+        double da = a[i] - ma, db = b[i] - mb;
+        cov += da * db;
+        va += da * da;
+        vb += db * db;
+    }
+    return va > 0 && vb > 0 ? cov / std::sqrt(va * vb) : 0.0;
+}
+
+// 在±max_lag个网格步长内找|r|最大的滞后；lag>0表示b的变化落后a这么多步
+std::pair<double, int> laggedCorrelation(const std::vector<float>& a, const std::vector<float>& b, int max_lag) {
+    double best_r = 0.0;
+    int best_lag = 0;
+    int n = static_cast<int>(a.size());
+    for (int lag = -max_lag; lag <= max_lag; ++lag) {
+        int begin = std::max(0, -lag), end = std::min(n, n - lag);
+        if (end - begin < 10) continue;  //重叠太少不可信
+        double r = pearson(a.data() + begin, b.data() + begin + lag, end - begin);
+        if (std::abs(r) > std::abs(best_r) + 1e-9) {
+            best_r = r;
+            best_lag = lag;
+        }
+    }
+    return {best_r, best_lag};
+}
+
+// 多轴叠加图：各指标插值到公共网格(取最粗的平均采样间隔，至少100ms)，只覆盖都有数据的时间段
+// 副标题给出第1个指标与其余指标在±10s内的最大互相关
+bool buildOverlayChart(const ReportData& result, const RenderOptions& options, ChartSpec& chart) {
+    std::vector<OverlaySource> sources;
+    for (const auto& key : options.overlay) {
+        OverlaySource source;
+        if (sources.size() < 3 && overlaySource(result, key, source)) sources.push_back(std::move(source));
+    }
+    if (sources.size() < 2) return false;
+
+    uint64_t begin = 0, end = UINT64_MAX, step = 100;
+    for (const auto& source : sources) {
+        begin = std::max(begin, source.time_ms.front());
+        end = std::min(end, source.time_ms.back());
+        if (source.time_ms.size() > 1) {
+            step = std::max(step, (source.time_ms.back() - source.time_ms.front()) / (source.time_ms.size() - 1));
+        }
+    }
+    if (end <= begin) return false;
+
+    std::vector<uint64_t> grid;
+    for (uint64_t t = begin; t <= end; t += step) grid.push_back(t);
+    std::vector<std::vector<float>> values;
+    for (const auto& source : sources) values.push_back(resampleLinear(source, grid));
+
+    auto shortName = [](const std::string& name) { return name.substr(0, name.find('(')); };  //摘要里去掉单位
+    std::string summary;
+    int max_lag = static_cast<int>(10000 / step);
+    for (size_t k = 1; k < sources.size(); ++k) {
+        auto [r, lag] = laggedCorrelation(values[0], values[k], max_lag);
+        char text[160];
+        double seconds = lag * static_cast<double>(step) / 1000.0;
+        std::snprintf(text, sizeof(text), "%s vs %s r=%.2f", shortName(sources[0].name).c_str(),
+                      shortName(sources[k].name).c_str(), r);
+        if (!summary.empty()) summary += "；";
+        summary += text;
+        if (lag != 0) {
+            std::snprintf(text, sizeof(text), " (%s%.1fs)", lag > 0 ? "滞后" : "超前", std::abs(seconds));
+            summary += text;
+        }
+    }
+
+    chart.title = "指标叠加";
+    chart.y_label = "";
+    SVGFreqPlotter::StyleParams& style = chart.style;
+    style.chart_type = SVGFreqPlotter::ChartType::MultiAxis;
+    style.right_margin = 170;
+    style.use_custom_range = true;
+    style.custom_min_value = 0.0f;
+    style.use_custom_max_range = false;
+    style.label = summary;
+    style.legend_items_per_row = 3;
+    style.data_line_width = data_line_width(grid.size());
+    style.decimate = options.decimate;
+
+    chart.data.time_ms = std::move(grid);
+    for (size_t k = 0; k < sources.size(); ++k) {
+        style.order.push_back(sources[k].name);
+        SVGFreqPlotter::SparseSeries& series = chart.data.series[sources[k].name];
+        for (size_t i = 0; i < values[k].size(); ++i) series.push(static_cast<uint32_t>(i), values[k][i]);
+    }
+    return true;
+}
+
+// 对每个采样周期求和：第i个值代表(time_ms[i-1], time_ms[i]]这段时间，功耗(W)得到焦耳、帧率得到帧数
+// 只统计time_ms[i]落在[begin, end)内的值，第一个采样没有周期，不计
+double integrateScalar(const ScalarSeries& series, uint64_t begin, uint64_t end) {
+    double sum = 0;
+    size_t first = std::lower_bound(series.time_ms.begin(), series.time_ms.end(), begin) - series.time_ms.begin();
+    for (size_t i = std::max<size_t>(first, 1); i < series.size() && series.time_ms[i] < end; ++i) {
+        sum += series.values[i] * (series.time_ms[i] - series.time_ms[i - 1]) / 1000.0;
+    }
+    return sum;
+}
+
+// 按时间加权的平均值，范围内没有完整的采样周期时为负
+double averageScalar(const ScalarSeries& series, uint64_t begin, uint64_t end) {
+    size_t first = std::lower_bound(series.time_ms.begin(), series.time_ms.end(), begin) - series.time_ms.begin();
+    size_t last = std::lower_bound(series.time_ms.begin(), series.time_ms.end(), end) - series.time_ms.begin();
+    first = std::max<size_t>(first, 1);
+    if (first >= last || series.time_ms[last - 1] == series.time_ms[first - 1]) return -1;
+    return integrateScalar(series, begin, end) * 1000.0 / static_cast<double>(series.time_ms[last - 1] - series.time_ms[first - 1]);
+}
+
+// 平均功耗(W)和每帧能耗(mJ)，没有功耗或帧率数据的一项为负
+// 两个监控器开始出数据的时刻不同，每帧能耗用平均功耗/平均帧率，而不是总能耗/总帧数
+std::pair<double, double> powerSummary(const ReportData& result, uint64_t begin, uint64_t end) {
+    double watts = averageScalar(result.power, begin, end);
+    double fps = averageScalar(result.fps, begin, end);
+    return {watts, watts >= 0 && fps > 0 ? watts * 1000.0 / fps : -1};
+}
+
+// 功耗图，标题里是整段记录的平均功耗、总能耗和每帧能耗
+bool buildPowerChart(const ReportData& result, const RenderOptions& options, ChartSpec& chart) {
+    if (result.power.time_ms.empty()) return false;
+    auto frame_data = scalarFrameData(result.power, "power");
+    auto [watts, mj_per_frame] = powerSummary(result, 0, UINT64_MAX);
+    char title[128];
+    if (watts < 0) {
+        snprintf(title, sizeof(title), "功耗");
+    } else if (mj_per_frame < 0) {
+        snprintf(title, sizeof(title), "功耗  平均%.2fW  共%.0fJ", watts, integrateScalar(result.power, 0, UINT64_MAX));
+    } else {
+        snprintf(title, sizeof(title), "功耗  平均%.2fW  共%.0fJ  %.1fmJ/帧", watts,
+                 integrateScalar(result.power, 0, UINT64_MAX), mj_per_frame);
+    }
+    chart.title = title;
+    chart.key = "power";
+    chart.y_label = "功率(W)";
+    SVGFreqPlotter::StyleParams& style = chart.style;
+    style.use_custom_range = true;
+    style.custom_min_value = 0.0f;
+    style.use_custom_max_range = false;
+    style.label = "功耗";
+
+    style.data_line_width = data_line_width(frame_data.size());
+    style.decimate = options.decimate;
+    chart.data = SVGFreqPlotter(style).seriesFromFrames(frame_data);
+    return true;
+}
+
+// 内存图：目标进程的RSS、PSS、swap、脏页按类相加，和系统可用内存画在一起；缺页和内存回收的速率另画一张
+// PSS等慢速通道只在读了smaps_rollup的帧上有值，画出来沿用上一个值
+std::vector<ChartSpec> buildMemoryCharts(const ReportData& result, const RenderOptions& options) {
+    std::vector<ChartSpec> charts;
+    const ChannelSeries& series = result.memory;
+    if (series.time_ms.empty()) return charts;
+
+    static const std::pair<const char*, const char*> totals[] = {
+        {"rss:", "RSS"}, {"pss:", "PSS"}, {"swap:", "Swap"}, {"dirty:", "脏页"}};
+    static const std::pair<const char*, const char*> rates[] = {
+        {"pgmajfault", "主缺页"}, {"allocstall", "直接回收"}, {"pgscan_kswapd", "kswapd扫描"}};
+
+    std::vector<SVGFreqPlotter::FrameData> memory_frames, rate_frames;
+    std::set<std::string> nonzero;
+    double peak_pss = -1, faults = 0;
+    size_t fault_frames = 0;
+    for (size_t i = 0; i < series.size(); ++i) {
+        SVGFreqPlotter::FrameData memory, rate;
+        memory.time_ms = rate.time_ms = series.time_ms[i];
+        for (size_t v = series.offsets[i]; v < series.offsets[i + 1]; ++v) {
+            const std::string& name = series.channels[series.values[v].channel];
+            float value = static_cast<float>(series.values[v].value);
+            if (name == "MemAvailable") {
+                memory.frequencies["系统可用"] = value;
+            } else if (name == "pgfault") {
+                faults += value;
+                ++fault_frames;
+            }
+            for (const auto& [channel, label] : rates) {
+                if (name == channel) rate.frequencies[label] = value;
+            }
+            for (const auto& [prefix, label] : totals) {
+                if (name.compare(0, strlen(prefix), prefix) == 0) memory.frequencies[label] += value;
+            }
+        }
+        for (const auto& frame : {&memory, &rate}) {
+            for (const auto& [label, value] : frame->frequencies) {
+                if (value > 0) nonzero.insert(label);
+            }
+        }
+        auto pss = memory.frequencies.find("PSS");
+        if (pss != memory.frequencies.end()) peak_pss = std::max<double>(peak_pss, pss->second);
+        if (!memory.frequencies.empty()) memory_frames.push_back(std::move(memory));
+        if (!rate.frequencies.empty()) rate_frames.push_back(std::move(rate));
+    }
+
+    auto addChart = [&](std::vector<SVGFreqPlotter::FrameData>& frames, std::vector<std::string> order, const char* key,
+                        const char* title, const char* y_label, const char* label) {
+        order.erase(std::remove_if(order.begin(), order.end(), [&](const std::string& name) { return !nonzero.count(name); }),
+                    order.end());
+        if (frames.empty() || order.empty()) return;
+        ChartSpec& chart = charts.emplace_back();
+        chart.title = title;
+        chart.key = key;
+        chart.y_label = y_label;
+        SVGFreqPlotter::StyleParams& style = chart.style;
+        style.use_custom_range = true;
+        style.custom_min_value = 0.0f;
+        style.use_custom_max_range = false;
+        style.label = label;
+        style.order = std::move(order);
+
+        style.data_line_width = data_line_width(frames.size());
+        style.decimate = options.decimate;
+        chart.data = SVGFreqPlotter(style).seriesFromFrames(frames);
+    };
+
+    char title[128] = "内存";
+    if (peak_pss >= 0) snprintf(title, sizeof(title), "内存  PSS峰值%.0fMB", peak_pss);
+    addChart(memory_frames, {"RSS", "PSS", "Swap", "脏页", "系统可用"}, "memory", title, "内存(MB)", "目标进程各项相加");
+
+    snprintf(title, sizeof(title), "缺页与内存回收");
+    if (fault_frames > 0) snprintf(title, sizeof(title), "缺页与内存回收  平均缺页%.0f次/秒", faults / fault_frames);
+    addChart(rate_frames, {"主缺页", "直接回收", "kswapd扫描"}, "faults", title, "次/秒", "整机，kswapd扫描为页数");
+    return charts;
+}
+
+// 区段统计表：每个有名字的标记开始一个区段，到下一个标记(或记录结束)为止，无名标记只结束区段
+// 帧率只有每个采样周期的平均值，没有逐帧的帧时间，所以表头写明是各周期平均帧时间(1000/fps)的99分位
+// 平均功耗和每帧能耗按采样周期积分，没有采集功耗时显示"--"
+bool buildSectionTable(const ReportData& result, ChartSpec& chart) {
+    uint64_t record_end = 0;
+    for (const auto* series : {&result.fps.time_ms, &result.thermal.time_ms, &result.power.time_ms, &result.cpu_load.time_ms,
+                               &result.cpu_freq.time_ms}) {
+        if (!series->empty()) record_end = std::max(record_end, series->back());
+    }
+
+    auto range = [](const std::vector<uint64_t>& time_ms, uint64_t begin, uint64_t end) {  // [begin, end)
+        return std::make_pair(std::lower_bound(time_ms.begin(), time_ms.end(), begin) - time_ms.begin(),
+                              std::lower_bound(time_ms.begin(), time_ms.end(), end) - time_ms.begin());
+    };
+    auto format = [](const char* fmt, double value) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), fmt, value);
+        return std::string(buf);
+    };
+    auto clock = [](uint64_t ms) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%llu:%02llu", static_cast<unsigned long long>(ms / 60000),
+                 static_cast<unsigned long long>(ms / 1000 % 60));
+        return std::string(buf);
+    };
+
+    auto& rows = chart.style.table;
+    rows.push_back({"区段", "开始", "时长", "平均帧率", "P99周期平均帧时间(ms)", "平均功耗(W)", "能耗(mJ/帧)", "最高温度(°C)"});
+    const auto& markers = result.markers;
+    for (size_t m = 0; m < markers.size(); ++m) {
+        if (markers[m].name.empty() || markers[m].time_ms > record_end) continue;
+        uint64_t begin = markers[m].time_ms;
+        uint64_t end = m + 1 < markers.size() ? markers[m + 1].time_ms : record_end + 1;
+
+        auto [fps_first, fps_last] = range(result.fps.time_ms, begin, end);
+        auto [temp_first, temp_last] = range(result.thermal.time_ms, begin, end);
+        if (fps_first == fps_last && temp_first == temp_last) continue;  //窗口之外的区段
+
+        std::string avg_fps = "--", p99 = "--", max_temp = "--";
+        if (fps_first < fps_last) {
+            double sum = 0;
+            std::vector<double> frame_times;
+            for (auto i = fps_first; i < fps_last; ++i) {
+                double fps = result.fps.values[i];
+                sum += fps;
+                if (fps > 0) frame_times.push_back(1000.0 / fps);
+            }
+            avg_fps = format("%.1f", sum / static_cast<double>(fps_last - fps_first));
+            if (!frame_times.empty()) {
+                size_t rank = (frame_times.size() * 99 + 99) / 100 - 1;  //最近秩
+                std::nth_element(frame_times.begin(), frame_times.begin() + rank, frame_times.end());
+                p99 = format("%.1f", frame_times[rank]);
+            }
+        }
+        if (temp_first < temp_last) {
+            max_temp = format("%.1f", *std::max_element(result.thermal.values.begin() + temp_first,
+                                                        result.thermal.values.begin() + temp_last));
+        }
+        auto [watts, mj_per_frame] = powerSummary(result, begin, end);
+        rows.push_back({markers[m].name, clock(begin), format("%.0fs", (std::min(end, record_end + 1) - begin) / 1000.0),
+                        avg_fps, p99, watts < 0 ? "--" : format("%.2f", watts),
+                        mj_per_frame < 0 ? "--" : format("%.1f", mj_per_frame), max_temp});
+    }
+    if (rows.size() == 1) return false;
+
+    chart.title = "区段统计";
+    chart.line_view = false;
+    chart.style.chart_type = SVGFreqPlotter::ChartType::Table;
+    return true;
+}
+
+// 按固定顺序生成全部图表，pool不为空时并行解析
+std::vector<ChartSpec> buildCharts(const ReportData& result, const RenderOptions& options = {}, ThreadPool* pool = nullptr) {
+    std::vector<ChartSpec> charts(5);
+    bool has_class_chart = false;
+    std::map<std::string, SVGFreqPlotter::SeriesData> cpu_set_series;
+    std::vector<ChartSpec> residency_charts;
+    std::vector<ChartSpec> stacked_charts;
+    ChartSpec overlay_chart;
+    bool has_overlay = false;
+    ChartSpec power_chart;
+    bool has_power = false;
+    std::vector<ChartSpec> memory_charts;
+
+    TaskGroup group(pool);
     // 绘制fps===================
-    {
+    group.run([&, &chart = charts[0]] {
         auto frame_data = parseFpsData(result);
-        SVGFreqPlotter::StyleParams style;
+        chart.title = "帧率";
+        chart.y_label = "帧率(FPS)";
+        SVGFreqPlotter::StyleParams& style = chart.style;
         style.use_custom_range = true;
         style.custom_min_value = 0.0f;
         style.use_custom_max_range=false;
         style.label = "帧率";
 
         style.data_line_width = data_line_width(frame_data.size());
+        style.decimate = options.decimate;
         style.ticks={30.0,60.0,90.0,120.0,144.0};
-        SVGFreqPlotter plotter(style);
-        plotter.drawChart(frame_data, "帧率", "帧率(FPS)");//, "fps.svg");
-        svgs.push_back(plotter.getSVG());
-    }
+        chart.data = SVGFreqPlotter(style).seriesFromFrames(frame_data);
+    });
     // 绘制频率============
-    {
+    group.run([&, &chart = charts[1]] {
         auto frame_data = CPUFreqFrameData(result);
-        SVGFreqPlotter::StyleParams style;
+        chart.title = "CPU_Freq";
+        chart.y_label = "Ghz";
+        SVGFreqPlotter::StyleParams& style = chart.style;
         style.use_custom_range = true;
         style.custom_min_value = 0.0f;
         style.use_custom_max_range=false;
@@ -416,17 +1034,17 @@ void draw_svg(nlohmann::json& result, std::string pkg) {
         }
 
         style.data_line_width = data_line_width(frame_data.size());
-
-        SVGFreqPlotter plotter(style);
-        plotter.drawChart(frame_data, "CPU_Freq", "Ghz");//, "cpu_freq.svg");
-        svgs.push_back(plotter.getSVG());
-    }
+        style.decimate = options.decimate;
+        chart.data = SVGFreqPlotter(style).seriesFromFrames(frame_data);
+    });
 
     // 绘制负载=============
-    {
+    group.run([&, &chart = charts[2]] {
         auto frame_data = parseCpuLoadData(result);
+        chart.title = "CPU负载";
+        chart.y_label = "负载(%)";
 
-        SVGFreqPlotter::StyleParams style;
+        SVGFreqPlotter::StyleParams& style = chart.style;
         style.use_custom_range = true;
         style.custom_min_value = 0.0f;
         style.custom_max_value = 100.0f;
@@ -436,45 +1054,117 @@ void draw_svg(nlohmann::json& result, std::string pkg) {
         }
 
         style.data_line_width = data_line_width(frame_data.size());
-
-        SVGFreqPlotter plotter(style);
-        plotter.drawChart(frame_data, "CPU负载", "负载(%)");//, "cpu_load.svg");
-        svgs.push_back(plotter.getSVG());
-    }
+        style.decimate = options.decimate;
+        if (options.heatmap) {
+            useHeatmap(style, 100);
+            style.label = "每行一个核心，颜色为平均负载";
+        }
+        chart.data = SVGFreqPlotter(style).seriesFromFrames(frame_data);
+    });
     // 温度=============
-    {
+    group.run([&, &chart = charts[3]] {
         auto frame_data = parseThermalData(result);
-        SVGFreqPlotter::StyleParams style;
+        chart.title = "CPU温度";
+        chart.y_label = "温度(°C)";
+        SVGFreqPlotter::StyleParams& style = chart.style;
         style.use_custom_range = true;
         style.custom_min_value = 0.0f;
         style.use_custom_max_range=false;
         style.label = "温度";
 
         style.data_line_width = data_line_width(frame_data.size());
+        style.decimate = options.decimate;
+        chart.data = SVGFreqPlotter(style).seriesFromFrames(frame_data);
+    });
 
-        SVGFreqPlotter plotter(style);
-        plotter.drawChart(frame_data, "CPU温度", "温度(°C)");//, "thermal.svg");
-        svgs.push_back(plotter.getSVG());
+    group.run([&] { has_power = buildPowerChart(result, options, power_chart); });
+    group.run([&] { memory_charts = buildMemoryCharts(result, options); });
+    group.run([&] { has_class_chart = buildThreadClassChart(result, charts[4], options); });
+    group.run([&] { cpu_set_series = parseThreadData(result); });
+    if (options.heatmap) {
+        group.run([&] { residency_charts = buildResidencyCharts(result.cpu_freq); });
+    }
+    if (options.stacked) {
+        group.run([&] { stacked_charts = buildStackedCharts(result, options); });
+    }
+    if (!options.overlay.empty()) {
+        group.run([&] { has_overlay = buildOverlayChart(result, options, overlay_chart); });
     }
+    group.wait();
 
-    {
-        drawThreadCharts(result,svgs);
+    if (!has_class_chart) {
+        charts.pop_back();
+    }
+    if (has_power) {
+        charts.insert(charts.begin() + 4, std::move(power_chart));  //紧跟在温度图之后
+    }
+    charts.insert(charts.begin() + 4 + has_power, std::make_move_iterator(memory_charts.begin()),
+                  std::make_move_iterator(memory_charts.end()));
+    charts.insert(charts.begin() + 2, std::make_move_iterator(residency_charts.begin()),  //紧跟在频率图之后
+                  std::make_move_iterator(residency_charts.end()));
+    addThreadCharts(std::move(cpu_set_series), charts, options);
+    charts.insert(charts.end(), std::make_move_iterator(stacked_charts.begin()),
+                  std::make_move_iterator(stacked_charts.end()));
+    if (has_overlay) {
+        charts.insert(charts.begin(), std::move(overlay_chart));  //叠加图是总览，放在最前
     }
+    if (!result.markers.empty()) {  //每张图都画标记线，区段统计表放在最后
+        std::vector<SVGFreqPlotter::TimeMarker> markers;
+        for (const auto& marker : result.markers) markers.push_back({marker.time_ms, marker.name});
+        for (auto& chart : charts) chart.style.markers = markers;
+        ChartSpec table;
+        if (buildSectionTable(result, table)) charts.push_back(std::move(table));
+    }
+    return charts;
+}
 
-    std::string name;
-    std::string time;
-    if(result.contains("info")){
-        if(result["info"].is_object())
-        name=result["info"].value("name","");
-        time=result["info"].value("time","");
+// 串行时图表直接写进文档缓冲；pool不为空时各图表并行写入自己的缓冲，再按顺序拼入
+// 两种方式输出完全相同
+std::string render_svg(const std::vector<ChartSpec>& charts, const std::string& title, const std::string& time,
+                       ThreadPool* pool = nullptr) {
+    auto drawOne = [](const ChartSpec& chart, SvgBuffer& out) {
+        SVGFreqPlotter plotter(chart.style);
+        plotter.setPathCache(chart.path_cache);
+        plotter.drawChart(chart.data, chart.title, chart.y_label, out);
+    };
+
+    SVGDocument document(charts.size(), 1440.0, 720.0, 50.0, title, time);
+    if (!pool) {
+        for (const auto& chart : charts) {
+            drawOne(chart, document.beginChart());
+            document.endChart();
+        }
+    } else {
+        std::vector<SvgBuffer> buffers(charts.size());
+        TaskGroup group(pool);
+        for (size_t i = 0; i < charts.size(); ++i) {
+            group.run([&, i] { drawOne(charts[i], buffers[i]); });
+        }
+        group.wait();
 
+        size_t total = 4096;
+        for (const auto& buffer : buffers) total += buffer.size() + 64;
+        document.reserve(total);
+        for (const auto& buffer : buffers) {
+            document.appendChart(buffer);
+        }
     }
 
-    std::string out=SVGFreqPlotter::concatenateSVGsVertically(svgs,1440.0,720.0,50.0,name,time);
-    std::string filename=pkg+".svg";
-    std::ofstream file(filename);
-    file << out;
-    file.close();
+    document.finish();
+    return document.release();
+}
+
+void draw_svg(const std::vector<ChartSpec>& charts, const std::string& title, const std::string& time,
+              const std::string& pkg, ThreadPool* pool = nullptr) {
+    std::string filename = pkg + ".svg";
+    if (!writeFileAtomic(filename, render_svg(charts, title, time, pool))) {
+        std::cerr << "无法写入 " << filename << std::endl;
+        return;
+    }
 
     std::cout << "图表已生成" << std::endl;
-}
\ No newline at end of file
+}
+
+void draw_svg(const ReportData& result, std::string pkg, const RenderOptions& options = {}, ThreadPool* pool = nullptr) {
+    draw_svg(buildCharts(result, options, pool), result.name, result.time, pkg, pool);
+}
@@ -1,18 +1,32 @@
 // test_monitors.cpp
 #include "CpuFreqMonitor.hpp"
 #include "CpuLoadMonitor.hpp"
+#include "FlightRecorder.hpp"
 #include "FpsMonitor.hpp"
+#include "ForegroundTracker.hpp"
+#include "LiveDashboard.hpp"
+#include "MetricsExporter.hpp"
+#include "LiveReport.hpp"
+#include "MarkerChannel.hpp"
+#include "MemoryMonitor.hpp"
 #include "MonitorBase.hpp"
+#include "PowerMonitor.hpp"
+#include "ReportLoader.hpp"
+#include "ReportWriter.hpp"
+#include "Snapshot.hpp"
 #include "ThermalMonitor.hpp"
 #include "ThreadMonitor.hpp"
+#include "ThreadPool.hpp"
 #include <fstream>
 #include <iostream>
 #include <memory>
 #include <vector>
 
-#include "draw_svg.hpp"
+#include "draw_report.hpp"
 #include <algorithm>
+#include <cmath>
 #include <filesystem>
+#include <getopt.h>
 #include <fstream>
 #include <map>
 #include <regex>
@@ -23,26 +37,164 @@
 
 #include "nlohmann/json.hpp"
 
+std::atomic<bool> g_stop_requested{false};  //守护模式收到SIGINT/SIGTERM
+
 class MainMonitor {
 private:
     std::vector<std::unique_ptr<MonitorBase>> monitors_;
     std::string package_name_;
     int test_duration_;
+    ReportFormat format_;
+    RenderOptions render_options_;
+    int live_interval_;  //实时报告刷新间隔(秒)，0为关闭
+    double tui_rate_;    //终端面板刷新率(Hz)，0为关闭
+    std::string export_address_;  //指标导出地址，空为关闭
+    bool follow_;                 //跟随前台应用切换
+    std::unique_ptr<ForegroundTracker> tracker_;
+    std::string followed_package_;
+    std::vector<Marker> follow_markers_;  //每次切换记一个以包名命名的标记
+    std::string marker_fifo_;             //接收标记的命名管道，空为关闭
+    std::string snapshot_path_;           //节点快照输出文件，空为关闭
+    std::unique_ptr<SnapshotRecorder> snapshot_;
+    std::chrono::steady_clock::time_point started_;
 
 public:
-    MainMonitor(const std::string& pkgName, int duration_seconds = 10)
-        : package_name_(pkgName), test_duration_(duration_seconds) {}
+    MainMonitor(const std::string& pkgName, int duration_seconds = 10, ReportFormat format = ReportFormat::Json,
+                const RenderOptions& render_options = {}, int live_interval = 0, double tui_rate = 0,
+                const std::string& export_address = "", bool follow = false, const std::string& marker_fifo = "",
+                const std::string& snapshot_path = "")
+        : package_name_(pkgName), test_duration_(duration_seconds), format_(format), render_options_(render_options),
+          live_interval_(live_interval), tui_rate_(tui_rate), export_address_(export_address), follow_(follow),
+          marker_fifo_(marker_fifo), snapshot_path_(snapshot_path) {}
 
     void startTest() {
+        startMonitors();
+
+        auto start = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+        std::stringstream sstart;
+        sstart << std::put_time(std::localtime(&start), "%Y-%m-%d %H:%M:%S");
+
+        std::unique_ptr<LiveReport> live;
+        if (live_interval_ > 0) {
+            live = std::make_unique<LiveReport>(package_name_, package_name_, sstart.str(), render_options_);
+        }
+
+        std::unique_ptr<MetricsExporter> exporter = startExporter();
+        std::unique_ptr<MarkerChannel> marker_channel = startMarkerChannel();
+
+        std::unique_ptr<LiveDashboard> dashboard;
+        if (tui_rate_ > 0) {
+            dashboard = std::make_unique<LiveDashboard>(package_name_, tui_rate_);
+            dashboard->begin();
+        }
+
+        // 按开始时刻加整秒数的绝对时刻倒计时，刷新报告等耗时算在这一秒里，不会拉长记录
+        auto tick = std::chrono::steady_clock::now();
+        auto deadline = SessionClock::now();
+        for (int i = test_duration_; i > 0; --i) {
+            if (dashboard) {
+                tick += std::chrono::seconds(1);
+                dashboard->runUntil(monitors_, tick, i);
+            } else {
+                std::cout << "剩余时间: " << i << "秒\r" << std::flush;
+                deadline += std::chrono::seconds(1);
+                SessionClock::sleepUntil(deadline);
+            }
+            followForeground(dashboard != nullptr);
+            if (live && (test_duration_ - i + 1) % live_interval_ == 0 && i > 1) {  //最后一秒之后直接出正式报告
+                live->refresh(monitors_);
+            }
+        }
+        if (dashboard) dashboard->end();
+        if (exporter) exporter->stop();  //监控器停止前关闭，导出线程还在读它们的快照
+        if (marker_channel) marker_channel->stop();
+        std::cout << std::endl;
+        releaseClock();
+
+        ReportData result;
+        result.name = package_name_;
+
+        auto now = std::chrono::system_clock::now();
+        auto time_t = std::chrono::system_clock::to_time_t(now);
+        
+        std::stringstream sstime;
+        sstime << std::put_time(std::localtime(&time_t), "%Y-%m-%d %H:%M:%S");
+        result.time = sstime.str();
+
+        for (auto& monitor : monitors_) {
+            std::cout << "停止: " << monitor->name() << std::endl;
+            monitor->stop();
+            monitor->exportTo(result);
+        }
+        stopSnapshot();
+        result.markers = follow_markers_;
+        if (marker_channel) {
+            std::vector<Marker> received = marker_channel->markers();
+            result.markers.insert(result.markers.end(), received.begin(), received.end());
+            std::stable_sort(result.markers.begin(), result.markers.end(),
+                             [](const Marker& a, const Marker& b) { return a.time_ms < b.time_ms; });
+        }
+
+        saveToFile(result);
+        draw_report(result, package_name_, render_options_);
+    }
+
+    // 守护模式：一直运行到收到SIGINT/SIGTERM，只把触发点前后的片段写成文件
+    void startDaemon(std::vector<FlightTrigger> triggers, uint64_t pre_ms, uint64_t post_ms) {
+        startMonitors();
+        std::unique_ptr<MetricsExporter> exporter = startExporter();
+        std::unique_ptr<MarkerChannel> marker_channel = startMarkerChannel();
+        FlightRecorder recorder(package_name_, format_, std::move(triggers), pre_ms, post_ms);
+
+        auto onSignal = [](int) { g_stop_requested = true; };
+        std::signal(SIGINT, onSignal);
+        std::signal(SIGTERM, onSignal);
+        std::cout << "守护模式运行中，Ctrl+C 结束" << std::endl;
+
+        while (!g_stop_requested) {
+            SessionClock::sleepFor(std::chrono::seconds(1));
+            followForeground(false);
+            if (marker_channel) recorder.annotate(marker_channel->take());
+            recorder.tick(monitors_);
+        }
+
+        if (exporter) exporter->stop();
+        if (marker_channel) {
+            marker_channel->stop();
+            recorder.annotate(marker_channel->take());
+        }
+        for (auto& monitor : monitors_) {
+            monitor->stop();
+        }
+        stopSnapshot();
+        recorder.tick(monitors_);
+        recorder.finish();
+    }
 
+private:
+    void startMonitors() {
         std::cout << "包名: " << package_name_ << std::endl;
 
         // 创建监控器实例
         monitors_.push_back(std::make_unique<CPUFreqMonitor>());
         monitors_.push_back(std::make_unique<CPULoadMonitor>());
         monitors_.push_back(std::make_unique<ThermalMonitor>());
+        monitors_.push_back(std::make_unique<PowerMonitor>());
         monitors_.push_back(std::make_unique<FPSMonitor>(true));
-        monitors_.push_back(std::make_unique<ThreadMonitor>());
+        auto thread_monitor = std::make_unique<ThreadMonitor>();
+        monitors_.push_back(std::make_unique<MemoryMonitor>(*thread_monitor));  //用线程监控器扫到的进程
+        monitors_.push_back(std::move(thread_monitor));
+
+        if (!snapshot_path_.empty()) {  //登记监控器读的节点，要在它们启动前接上
+            snapshot_ = std::make_unique<SnapshotRecorder>(snapshot_path_, package_name_, test_duration_);
+            if (snapshot_->open()) {
+                SysRoot::trace(snapshot_.get());
+                std::cout << "节点快照: " << snapshot_path_ << std::endl;
+            } else {
+                std::cout << "无法写入快照: " << snapshot_path_ << std::endl;
+                snapshot_.reset();
+            }
+        }
 
         std::cout << "启动监控器..." << std::endl;
         for (auto& monitor : monitors_) {
@@ -52,109 +204,394 @@ public:
             }
         }
 
-        for (int i = test_duration_; i > 0; --i) {
-            std::cout << "剩余时间: " << i << "秒\r" << std::flush;
-            std::this_thread::sleep_for(std::chrono::seconds(1));
+        started_ = SessionClock::now();
+        if (snapshot_) snapshot_->start(started_);
+        if (follow_) {
+            tracker_ = std::make_unique<ForegroundTracker>(getForegroundApp_lru);
+            followed_package_ = package_name_;
+            follow_markers_.push_back({0, package_name_});
+            std::cout << "跟随前台应用(" << (tracker_->usingCgroup() ? "top-app控制组" : "dumpsys") << ")" << std::endl;
         }
-        std::cout << std::endl;
-
-        nlohmann::json result;
-        result["info"]["name"]=package_name_;
+    }
 
-        auto now = std::chrono::system_clock::now();
-        auto time_t = std::chrono::system_clock::to_time_t(now);
-        
-        std::stringstream sstime;
-        sstime << std::put_time(std::localtime(&time_t), "%Y-%m-%d %H:%M:%S");
-        result["info"]["time"]=sstime.str();
+    void followForeground(bool quiet) {  //前台换了应用：监控器改跟新包名，并记一个标记
+        if (!tracker_ || !tracker_->poll(followed_package_)) return;
+        for (auto& monitor : monitors_) {
+            monitor->retarget(followed_package_);
+        }
+        uint64_t time_ms =
+            std::chrono::duration_cast<std::chrono::milliseconds>(SessionClock::now() - started_).count();
+        follow_markers_.push_back({time_ms, followed_package_});
+        if (!quiet) std::cout << "\n前台切换: " << followed_package_ << std::endl;
+    }
 
+    void releaseClock() {  //回放时等各监控器做完最后一个时刻的采样，一起停下后主线程才退出虚拟时钟
+        SessionClock::settle();
         for (auto& monitor : monitors_) {
-            std::cout << "停止: " << monitor->name() << std::endl;
-            result[monitor->name()] = monitor->stop();
+            monitor->halt();
         }
+        SessionClock::leave();
+    }
 
-        saveToFile(result);
-        draw_svg(result, package_name_);
+    void stopSnapshot() {  //监控器都停止后再停，最后一帧包含它们最后读过的节点
+        if (!snapshot_) return;
+        snapshot_->stop();
+        SysRoot::trace(nullptr);
+        snapshot_.reset();
     }
 
-private:
-    void saveToFile(const nlohmann::json& data) {
-        std::ofstream file("monitor_test.json");
-        if (file.is_open()) {
-            file << data.dump(4);
-            file.close();
+    std::unique_ptr<MetricsExporter> startExporter() {
+        if (export_address_.empty()) return nullptr;
+        auto exporter = std::make_unique<MetricsExporter>(export_address_, monitors_);
+        if (!exporter->start()) {
+            std::cout << "指标导出启动失败: " << export_address_ << std::endl;
+            return nullptr;
         }
+        std::cout << "指标导出: " << export_address_ << std::endl;
+        return exporter;
+    }
+
+    std::unique_ptr<MarkerChannel> startMarkerChannel() {
+        if (marker_fifo_.empty()) return nullptr;
+        auto channel = std::make_unique<MarkerChannel>(marker_fifo_, started_);
+        if (!channel->start()) {
+            std::cout << "无法打开标记管道: " << marker_fifo_ << std::endl;
+            return nullptr;
+        }
+        std::cout << "标记管道: " << marker_fifo_ << std::endl;
+        return channel;
+    }
+
+    void saveToFile(const ReportData& data) {
+        std::string filename = "monitor_test" + reportFileExtension(format_);
+        if (!writeReport(filename, data, format_)) {
+            std::cerr << "无法写入 " << filename << std::endl;
+        }
+    }
+};
+
+struct TimeWindow {  // -i 时只画一段：--from/--to 或 --range <标记名>
+    bool active = false;
+    uint64_t from = 0;
+    uint64_t to = UINT64_MAX;
+    std::string marker;
+
+    std::string suffix() const {  //输出文件名后缀，区分同一记录的不同窗口
+        if (!marker.empty()) return "_" + marker;
+        return "_" + std::to_string(from / 1000) + "s-" + (to == UINT64_MAX ? "end" : std::to_string(to / 1000) + "s");
     }
 };
 
-std::string getForegroundApp_lru() {  //捕捉前台游戏
-    FILE* pipe = popen("dumpsys activity lru", "r");
-    if (!pipe) return "";
-
-    char buffer[256];
-    int lineCount = 0;
-    std::string result = "";
-
-    while (fgets(buffer, sizeof(buffer), pipe)) {
-        if (result.empty()) {
-            size_t len = strlen(buffer);
-            size_t startPos = 0;
-            size_t endPos = 0;
-
-            for (size_t i = 16; i < len; ++i) {
-                if (buffer[i] == ':') {
-                    startPos = i + 1;                       //包名起始点
-                } else if (buffer[i] == '/' && startPos) {  //包名结束
-                    endPos = i;
-                    break;
-                }
-            }
-
-            //确保是TOP
-            if (startPos && endPos && endPos > startPos) {
-                bool foundValidTOP = false;
-                for (int i = startPos - 4; i >= 0; --i) {
-                    if (i + 3 < static_cast<int>(startPos) &&
-                        buffer[i] == 'T' &&
-                        buffer[i + 1] == 'O' &&
-                        buffer[i + 2] == 'P') {
-                        if (i == 0 || buffer[i - 1] != 'B') {
-                            foundValidTOP = true;
-                            break;
-                        }
-                    }
-                }
-
-                if (foundValidTOP) {
-                    result.assign(buffer + startPos, endPos - startPos);
-                    break;
-                }
-            }
-        }
-    }
-    pclose(pipe);
-    return result;
+bool parseTimeArg(const std::string& text, uint64_t& time_ms) {  //秒数、m:ss 或 h:mm:ss，秒可带小数
+    double total = 0;
+    std::stringstream parts(text);
+    std::string part;
+    int count = 0;
+    while (std::getline(parts, part, ':')) {
+        char* end = nullptr;
+        double value = std::strtod(part.c_str(), &end);
+        if (part.empty() || *end != '\0' || value < 0 || ++count > 3) return false;
+        total = total * 60 + value;
+    }
+    if (count == 0) return false;
+    time_ms = static_cast<uint64_t>(total * 1000 + 0.5);
+    return true;
+}
+
+void renderReportFile(const std::string& input_file, const std::string& output_name, const RenderOptions& options,
+                      const TimeWindow& window, ThreadPool* pool) {  //读取一个记录并绘图
+    try {
+        std::string filename = output_name;
+
+        ReportData result;
+        if (window.active) {
+            result = loadReportWindow(input_file, window.from, window.to, window.marker);
+            filename += window.suffix();
+        } else {
+            result = loadReport(input_file);
+        }
+
+        draw_report(result, filename, options, pool);
+    } catch (const nlohmann::json::parse_error& e) {
+        std::cerr << "无法解析: " << input_file << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << input_file << ": " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "未知错误: " << input_file << std::endl;
+    }
+}
+
+std::vector<std::string> collectInputs(const std::vector<std::string>& paths) {  //目录展开为其中的记录文件
+    std::vector<std::string> inputs;
+    for (const auto& path : paths) {
+        std::error_code ec;
+        if (!std::filesystem::is_directory(path, ec)) {
+            inputs.push_back(path);
+            continue;
+        }
+
+        std::vector<std::string> dir_inputs;
+        for (const auto& entry : std::filesystem::directory_iterator(path, ec)) {
+            std::string ext = entry.path().extension().string();
+            if (entry.is_regular_file(ec) && (ext == ".json" || ext == ".cbor" || ext == ".msgpack")) {
+                dir_inputs.push_back(entry.path().string());
+            }
+        }
+        std::sort(dir_inputs.begin(), dir_inputs.end());
+        inputs.insert(inputs.end(), dir_inputs.begin(), dir_inputs.end());
+    }
+    return inputs;
+}
+
+// 输出文件名取记录文件名去掉扩展名，都写到当前目录
+// 录制出的记录都叫monitor_test，重名的依次加上扩展名、所在目录名，还重名就加序号，避免几个任务写同一个文件
+std::vector<std::string> outputNames(const std::vector<std::string>& inputs) {
+    auto nameAt = [](const std::string& input, int level) {
+        std::filesystem::path path(input);
+        std::string name = path.stem().string();
+        if (name.empty()) name = path.filename().string();
+        if (level >= 1 && path.has_extension()) name += "_" + path.extension().string().substr(1);
+        if (level >= 2) {
+            std::error_code ec;
+            std::string dir = std::filesystem::absolute(path, ec).lexically_normal().parent_path().filename().string();
+            if (!dir.empty()) name = dir + "_" + name;
+        }
+        return name;
+    };
+
+    std::vector<int> levels(inputs.size(), 0);
+    std::vector<std::string> names(inputs.size());
+    for (bool clash = true; clash;) {
+        std::map<std::string, int> counts;
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            names[i] = nameAt(inputs[i], levels[i]);
+            ++counts[names[i]];
+        }
+        clash = false;
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            if (counts[names[i]] > 1 && levels[i] < 2) {
+                ++levels[i];
+                clash = true;
+            }
+        }
+    }
+
+    std::set<std::string> used;
+    for (auto& name : names) {  //同一个文件给了两次之类，只能加序号
+        std::string unique = name;
+        for (int n = 2; !used.insert(unique).second; ++n) unique = name + "_" + std::to_string(n);
+        name = unique;
+    }
+    return names;
 }
 
 int main(int argc, char* argv[]) {
     std::string pkgname;
     std::string time_value;
-    std::string input_file;
+    std::vector<std::string> input_files;
     int duration = 30;
+    unsigned jobs = std::thread::hardware_concurrency();
+    ReportFormat format = ReportFormat::Json;
+    RenderOptions render_options;
+    int live_interval = 0;
+    double tui_rate = 0;
+    std::string export_address;
+    std::string marker_fifo;
+    std::string root_dir;
+    std::string snapshot_path;
+    std::string replay_path;
+    double speed = 1.0;
+    bool duration_set = false;
+    std::vector<FlightTrigger> triggers;
+    bool daemon = false;
+    bool follow = false;
+    uint64_t pre_ms = 20000, post_ms = 10000;
+    TimeWindow window;
+
+    static const option long_options[] = {
+        {"html", no_argument, nullptr, 'H'},
+        {"png", no_argument, nullptr, 'P'},
+        {"live-report", required_argument, nullptr, 'L'},
+        {"heatmap", no_argument, nullptr, 'M'},
+        {"stacked", no_argument, nullptr, 'S'},
+        {"overlay", optional_argument, nullptr, 'O'},
+        {"from", required_argument, nullptr, 'F'},
+        {"to", required_argument, nullptr, 'T'},
+        {"range", required_argument, nullptr, 'R'},
+        {"tui", optional_argument, nullptr, 'U'},
+        {"export", required_argument, nullptr, 'E'},
+        {"daemon", no_argument, nullptr, 'd'},
+        {"follow", no_argument, nullptr, 'W'},
+        {"trigger", required_argument, nullptr, 'g'},
+        {"window", required_argument, nullptr, 'w'},
+        {"marker-fifo", required_argument, nullptr, 'k'},
+        {"root", required_argument, nullptr, 'r'},
+        {"snapshot", required_argument, nullptr, 'n'},
+        {"replay", required_argument, nullptr, 'y'},
+        {"speed", required_argument, nullptr, 'v'},
+        {nullptr, 0, nullptr, 0}};
 
     int opt;
-    while ((opt = getopt(argc, argv, "t:i:h")) != -1) {
+    while ((opt = getopt_long(argc, argv, "t:i:f:j:Dh", long_options, nullptr)) != -1) {
         switch (opt) {
         case 'i':
-            input_file = optarg;
+            input_files.push_back(optarg);
+            break;
+        case 'j': {  // 1~1024
+            char* end = nullptr;
+            long value = std::strtol(optarg, &end, 10);
+            if (end == optarg || *end != '\0' || value <= 0 || value > 1024) {
+                std::cerr << "无效线程数: " << optarg << std::endl;
+                return 1;
+            }
+            jobs = static_cast<unsigned>(value);
+            break;
+        }
+        case 'D':
+            render_options.decimate = false;
+            break;
+        case 'H':
+            render_options.html = true;
+            break;
+        case 'P':
+            render_options.png = true;
+            break;
+        case 'O': {  //逗号分隔的指标，不带参数时为 帧率+温度+最高频核心
+            std::stringstream keys(optarg ? optarg : "fps,temp,freq");
+            std::string key;
+            render_options.overlay.clear();
+            while (std::getline(keys, key, ',')) {
+                if (!key.empty()) render_options.overlay.push_back(key);
+            }
+            break;
+        }
+        case 'S':
+            render_options.stacked = true;
+            break;
+        case 'M':
+            render_options.heatmap = true;
+            break;
+        case 'L': {  // 1~86400秒
+            char* end = nullptr;
+            long value = std::strtol(optarg, &end, 10);
+            if (end == optarg || *end != '\0' || value <= 0 || value > 86400) {
+                std::cerr << "无效刷新间隔: " << optarg << std::endl;
+                return 1;
+            }
+            live_interval = static_cast<int>(value);
+            break;
+        }
+        case 'F':
+        case 'T':
+            if (!parseTimeArg(optarg, opt == 'F' ? window.from : window.to)) {
+                std::cerr << "无效时间: " << optarg << std::endl;
+                return 1;
+            }
+            window.active = true;
+            break;
+        case 'R':
+            window.marker = optarg;
+            window.active = true;
+            break;
+        case 'd':
+            daemon = true;
+            break;
+        case 'W':
+            follow = true;
             break;
+        case 'g':
+            if (!parseFlightTriggers(optarg, triggers)) {
+                std::cerr << "无效触发条件: " << optarg << std::endl;
+                return 1;
+            }
+            break;
+        case 'w': {  // 前:后，秒
+            uint64_t pre = 0, post = 0;
+            std::string text = optarg;
+            size_t colon = text.find(':');
+            if (colon == std::string::npos || !parseTimeArg(text.substr(0, colon), pre) ||
+                !parseTimeArg(text.substr(colon + 1), post)) {
+                std::cerr << "无效窗口: " << optarg << std::endl;
+                return 1;
+            }
+            pre_ms = pre;
+            post_ms = post;
+            break;
+        }
+        case 'E':
+            export_address = optarg;
+            break;
+        case 'k':
+            marker_fifo = optarg;
+            break;
+        case 'r':
+            root_dir = optarg;
+            break;
+        case 'n':
+            snapshot_path = optarg;
+            break;
+        case 'y':
+            replay_path = optarg;
+            break;
+        case 'v': {
+            char* end = nullptr;
+            speed = std::strtod(optarg, &end);
+            if (end == optarg || *end != '\0' || !std::isfinite(speed) || speed <= 0) {
+                std::cerr << "无效倍速: " << optarg << std::endl;
+                return 1;
+            }
+            break;
+        }
+        case 'U': {
+            if (!optarg) {
+                tui_rate = 2.0;
+                break;
+            }
+            char* end = nullptr;
+            tui_rate = std::strtod(optarg, &end);
+            if (end == optarg || *end != '\0' || !std::isfinite(tui_rate) || tui_rate <= 0) {
+                std::cerr << "无效刷新率: " << optarg << std::endl;
+                return 1;
+            }
+            break;
+        }
         case 't':
             duration = std::stoi(optarg);
+            duration_set = true;
+            break;
+        case 'f':
+            if (!parseReportFormat(optarg, format)) {
+                std::cerr << "未知格式: " << optarg << std::endl;
+                return 1;
+            }
             break;
         case 'h':
             std::cout << "食用方法: \n" 
-            << argv[0] << " -t <时间> [包名]\n"
-            << argv[0] << " -i <文件>\n";
+            << argv[0] << " -t <时间> [-f json|json-compact|cbor|msgpack] [包名]\n"
+            << argv[0] << " -i <文件或目录> [更多文件...] [-j 线程数]  (自动识别json/cbor/msgpack)\n"
+            << "    输出到当前目录，文件名取记录名；重名时加上扩展名、所在目录名或序号区分\n"
+            << "  -D  不抽稀折线(默认点数远多于像素时抽稀)\n"
+            << "  --html  同时输出可缩放的交互式网页报告(单文件，离线可用)\n"
+            << "  --png   同时输出png位图(内置光栅化，不依赖外部工具)\n"
+            << "  --heatmap  CPU负载和线程负载画成热力图(每行一个核心/线程)，并增加各频率通道的驻留图\n"
+            << "  --stacked  增加负载构成堆叠图(各CPU Set按进程、游戏内按线程组)\n"
+            << "  --overlay[=指标,...]  增加多轴叠加图和互相关摘要，指标可选 fps,temp,power,freq,freq:<通道>,load:<通道>\n"
+            << "                        (最多3个，默认 fps,temp,freq)\n"
+            << "  --live-report <秒>  记录期间每隔N秒刷新svg/html报告(原子替换，可边录边看)\n"
+            << "  --tui[=Hz]  记录期间显示终端面板：帧率、温度、各核负载/频率、热点线程(默认2Hz)\n"
+            << "  --export <地址>  记录期间通过HTTP提供最新采样: /metrics(Prometheus) /latest /stream(NDJSON)\n"
+            << "                   地址为 tcp:<端口>(仅127.0.0.1)、unix:<路径> 或 unix:@<抽象名>\n"
+            << "  --follow  前台切换应用时改为记录新的前台应用(读top-app控制组，读不到时用dumpsys)，切换点记为标记\n"
+            << "  --marker-fifo <路径>  记录期间从命名管道接收标记，每行一条: <名字> | start <名字> | stop\n"
+            << "                        标记画在每张图上，并生成各区段统计表(平均帧率、各秒平均帧时间的P99、平均功耗、每帧能耗、最高温度)\n"
+            << "  --daemon --trigger <条件,...> [--window 前:后]  守护模式，只保存触发点前后的片段(默认前20s后10s)\n"
+            << "           条件: fps<X[:持续ms](画面卡住没有新帧也算) temp>摄氏度 thread>百分比\n"
+            << "  --from/--to <时间>  -i 时只画这段时间(秒、m:ss 或 h:mm:ss)，有.idx索引时只读这一段\n"
+            << "  --range <标记名>    -i 时只画该标记开始到下一个标记之间的区段\n"
+            << "  --root <目录>  从该目录下读/proc、/sys等节点(离线分析抓下来的节点树)\n"
+            << "  --snapshot <文件>  记录的同时把监控器读过的节点按时间抓成快照(只存变化)，供 --replay 使用\n"
+            << "  --replay <快照> [--speed 倍数]  用快照代替真机节点重跑整个记录流程，虚拟时间最快为真实时间的N倍(默认1)\n"
+            << "                                  包名和时长默认取快照记录时的；结果只取决于快照，与倍速和机器快慢无关\n";
             return 0;
         default:
             std::cerr << "未知参数\n";
@@ -162,39 +599,67 @@ int main(int argc, char* argv[]) {
         }
     }
 
-    if (!input_file.empty()) {
-        try {
-            std::ifstream file(input_file);
-
-            std::string filename = std::filesystem::path(input_file).filename().string();
-
-            size_t dot_pos = filename.find_last_of('.');
-
-            if (dot_pos != std::string::npos && dot_pos > 0) {
-                filename = filename.substr(0, dot_pos);
-            }
-
-            nlohmann::json result;
-            file >> result;
-            file.close();
+    if (!input_files.empty()) {
+        if (window.active && window.marker.empty() && window.from > window.to) {
+            std::cerr << "--from 晚于 --to" << std::endl;
+            return 1;
+        }
+        for (int i = optind; i < argc; ++i) {  //-i 之后的参数都当作输入
+            input_files.push_back(argv[i]);
+        }
 
-            draw_svg(result, filename);
-        } catch (const nlohmann::json::parse_error& e) {
-            std::cerr << "无法解析" << std::endl;
-        } catch (...) {
-            std::cerr << "未知错误" << std::endl;
+        std::vector<std::string> inputs = collectInputs(input_files);
+        std::vector<std::string> outputs = outputNames(inputs);
+        ThreadPool pool(jobs);
+        TaskGroup group(&pool);
+        for (size_t i = 0; i < inputs.size(); ++i) {  //每个文件一个任务，文件内的图表再拆分
+            const std::string& input = inputs[i];
+            const std::string& output = outputs[i];
+            group.run([&input, &output, &pool, &render_options, &window] {
+                renderReportFile(input, output, render_options, window, &pool);
+            });
         }
+        group.wait();
         return 0;
     }
 
+    std::unique_ptr<ReplayDriver> replay;
+    if (!replay_path.empty()) {
+        if (daemon || tui_rate > 0) {  //这两种模式由真实时间或信号驱动，回放时不会结束/不会刷新
+            std::cerr << "--replay 不能与 --daemon、--tui 同时使用" << std::endl;
+            return 1;
+        }  //先还原第一帧，监控器启动时看到的就是快照开始时的节点
+        replay = std::make_unique<ReplayDriver>(replay_path);
+        if (!replay->open()) {
+            std::cerr << "无法读取快照: " << replay_path << std::endl;
+            return 1;
+        }
+        root_dir = replay->root();
+        SessionClock::setSpeed(speed);
+        if (!duration_set) duration = replay->duration();
+    }
+    if (!root_dir.empty()) SysRoot::set(root_dir);
+
     if (optind < argc) {
         pkgname = argv[optind];
+    } else if (replay) {
+        pkgname = replay->package();
     } else {
-        pkgname = getForegroundApp_lru();
+        pkgname = follow ? ForegroundTracker(getForegroundApp_lru).detect() : getForegroundApp_lru();
     }
 
-    MainMonitor tester(pkgname, duration);
-    tester.startTest();
+    MainMonitor tester(pkgname, duration, format, render_options, live_interval, tui_rate, export_address, follow,
+                       marker_fifo, snapshot_path);
+    if (replay) replay->start();
+    if (daemon) {
+        if (triggers.empty()) {
+            std::cerr << "守护模式需要 --trigger" << std::endl;
+            return 1;
+        }
+        tester.startDaemon(std::move(triggers), pre_ms, post_ms);
+    } else {
+        tester.startTest();
+    }
 
     return 0;
 }
\ No newline at end of file